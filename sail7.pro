@@ -3,7 +3,7 @@
 # Project created by QtCreator
 #
 #-------------------------------------------------
-CONFIG += qt
+CONFIG += qt c++11 thread
 QT += opengl xml
 TEMPLATE = app
 TARGET = sail7
@@ -54,10 +54,14 @@ SOURCES += \
     src/objects/bspline.cpp \
     src/objects/cubicspline.cpp \
     src/objects/frame.cpp \
+    src/objects/hmatrix.cpp \
     src/objects/naca4spline.cpp \
     src/objects/nurbssail.cpp \
     src/objects/nurbssurface.cpp \
     src/objects/panel.cpp \
+    src/objects/panelbatch.cpp \
+    src/objects/panelresultpool.cpp \
+    src/objects/paneltree.cpp \
     src/objects/pointspline.cpp \
     src/objects/quaternion.cpp \
     src/objects/sail.cpp \
@@ -65,7 +69,9 @@ SOURCES += \
     src/objects/sailcutspline.cpp \
     src/objects/sailsection.cpp \
     src/objects/spline.cpp \
+    src/objects/trefftzplane.cpp \
     src/objects/vector3d.cpp \
+    src/objects/vortexbatch.cpp \
     src/sail7/boatanalysisdlg.cpp \
     src/sail7/boatdlg.cpp \
     src/sail7/boatpolardlg.cpp \
@@ -128,10 +134,14 @@ HEADERS  += \
     src/objects/bspline.h \
     src/objects/cubicspline.h \
     src/objects/frame.h \
+    src/objects/hmatrix.h \
     src/objects/naca4spline.h \
     src/objects/nurbssail.h \
     src/objects/nurbssurface.h \
     src/objects/panel.h \
+    src/objects/panelbatch.h \
+    src/objects/panelresultpool.h \
+    src/objects/paneltree.h \
     src/objects/pointspline.h \
     src/objects/quaternion.h \
     src/objects/rectangle.h \
@@ -139,8 +149,11 @@ HEADERS  += \
     src/objects/sailcutsail.h \
     src/objects/sailcutspline.h \
     src/objects/sailsection.h \
+    src/objects/simdpack.h \
     src/objects/spline.h \
+    src/objects/trefftzplane.h \
     src/objects/vector3d.h \
+    src/objects/vortexbatch.h \
     src/params.h \
     src/sail7/boatanalysisDlg.h \
     src/sail7/boatdlg.h \
@@ -230,6 +243,8 @@ macx{
 #QMAKE_CXXFLAGS+=-pg
 #QMAKE_LFLAGS+=-pg
 
+include(src/objects/simd.pri)
+
 OTHER_FILES += \
         doc/ReleaseNotes.txt
 
@@ -20,6 +20,20 @@
 #include <QDateTime> 
 #include <QByteArray>
 #include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 
 void ExpFormat(double &f, int &exp)
@@ -44,8 +58,8 @@ void ExpFormat(double &f, int &exp)
 
 bool Gauss(double *A, int n, double *B, int m, bool *pbCancel)
 {
-    static int row, i, j, pivot_row, k;
-    static double max, dum, *pa, *pA, *A_pivot_row;
+    int row, i, j, pivot_row, k;
+    double max, dum, *pa, *pA, *A_pivot_row;
     // for each variable find pivot row and perform forward substitution
     pa = A;
     for (row = 0; row < (n - 1); row++, pa += n)
@@ -865,6 +879,10 @@ void ReadValues(QString line, int &res, double &x, double &y, double &z)
 //     int    pivot[]  The i-th element is the pivot row interchanged with    //
 //                     row i.                                                 //
 //     int     n       The number of rows or columns of the matrix A.         //
+//     pbCancel        Checked after each block of columns, the               //
+//                     decomposition is interrupted if it is set to true.     //
+//     Progress        If set, called after each block of columns with the    //
+//                     fraction of the columns processed so far.              //
 //                                                                            //
 //  Return Values:                                                            //
 //     0  Success                                                             //
@@ -873,56 +891,120 @@ void ReadValues(QString line, int &res, double &x, double &y, double &z)
 ////////////////////////////////////////////////////////////////////////////////
 
 
-bool Crout_LU_Decomposition_with_Pivoting(double *A, int pivot[], int n, bool *pbCancel, double TaskSize, double &Progress)
+template <typename T>
+static bool CroutLUDecomposition(T *A, int pivot[], int n, std::atomic<bool> const *pbCancel, std::function<void(double)> const &Progress)
 {
-    int i, j, k;
-    double *p_k, *p_row, *p_col;
-    double max=0.0;
-
-    p_col = nullptr;
-
-    //  For each row and column, k = 0, ..., n-1,
-    for (k=0, p_k=A; k<n; p_k+=n, k++)
+    int i, j, k, k0, k1, nChunks, nRowBlocks;
+    T *p_k, *p_row, *p_col;
+    T max=0.0;
+
+    //  The matrix is processed by panels of LUBLOCKSIZE columns.
+    //  Each panel is factorized with the unblocked algorithm restricted to its own columns,
+    //  then the block row of U to the right of the panel is solved, and finally the trailing
+    //  sub-matrix is updated with a matrix-matrix product, which is where the bulk of the
+    //  work is done, and which is split by tiles between the available threads.
+    //  For each matrix element the updates are applied in the same order as in the
+    //  unblocked algorithm, so that the result does not depend on the number of threads.
+    for (k0=0; k0<n; k0+=LUBLOCKSIZE)
     {
-        //  find the pivot row
-        pivot[k] = k;
-        p_col = p_k+k;
-        max = fabs( *(p_k + k) );
-        for (j=k+1, p_row=p_k+n; j<n; j++, p_row+=n)
+        k1 = std::min(k0+LUBLOCKSIZE, n);
+
+        // Factorize the panel A[k0..n-1][k0..k1-1]
+        for (k=k0, p_k=A+k0*n; k<k1; p_k+=n, k++)
         {
-            if (max<fabs(*(p_row+k)))
+            //  find the pivot row
+            pivot[k] = k;
+            p_col = p_k;
+            max = fabs( *(p_k + k) );
+            for (j=k+1, p_row=p_k+n; j<n; j++, p_row+=n)
             {
-                max = fabs(*(p_row+k));
-                pivot[k] = j;
-                p_col = p_row;
+                if (max<fabs(*(p_row+k)))
+                {
+                    max = fabs(*(p_row+k));
+                    pivot[k] = j;
+                    p_col = p_row;
+                }
             }
-        }
-        if(!p_col) return false;
 
-        // and if the pivot row differs from the current row, then
-        // interchange the two rows.
-        if (pivot[k] != k)
-        {
-            for (j=0; j<n; j++)
+            // and if the pivot row differs from the current row, then
+            // interchange the two rows.
+            if (pivot[k] != k)
             {
-                max = *(p_k + j);
-                *(p_k + j) = *(p_col + j);
-                *(p_col + j) = max;
+                for (j=0; j<n; j++)
+                {
+                    max = *(p_k + j);
+                    *(p_k + j) = *(p_col + j);
+                    *(p_col + j) = max;
+                }
             }
-        }
 
-        // and if the matrix is singular, return error
-        if ( *(p_k + k) == 0.0 ) return false;
+            // and if the matrix is singular, return error
+            if ( *(p_k + k) == 0.0 ) return false;
 
-        // otherwise find the upper triangular matrix elements for row k.
-        for (j = k+1; j < n; j++) *(p_k + j) /= *(p_k + k);
+            // otherwise find the upper triangular matrix elements for row k within the panel.
+            for (j = k+1; j < k1; j++) *(p_k + j) /= *(p_k + k);
 
-        // update remaining matrix
-        for (i = k+1, p_row = p_k + n; i < n; p_row += n, i++)
-            for (j = k+1; j < n; j++) *(p_row + j) -= *(p_row + k) * *(p_k + j);
+            // update the remaining panel columns
+            for (i = k+1, p_row = p_k + n; i < n; p_row += n, i++)
+                for (j = k+1; j < k1; j++) *(p_row + j) -= *(p_row + k) * *(p_k + j);
+        }
+
+        if(k1<n)
+        {
+            // Solve for the block row of U, A[k0..k1-1][k1..n-1], by column chunks
+            nChunks = (n-k1+LUCHUNKSIZE-1)/LUCHUNKSIZE;
+            ParallelFor(nChunks, [=](int ic)
+            {
+                int jStart = k1 + ic*LUCHUNKSIZE;
+                int jEnd   = std::min(jStart+LUCHUNKSIZE, n);
+                for(int kk=k0; kk<k1; kk++)
+                {
+                    T *p_kk = A + kk*n;
+                    for(int p=k0; p<kk; p++)
+                    {
+                        T l = p_kk[p];
+                        T *p_p = A + p*n;
+                        for(int jj=jStart; jj<jEnd; jj++) p_kk[jj] -= l * p_p[jj];
+                    }
+                    T d = p_kk[kk];
+                    for(int jj=jStart; jj<jEnd; jj++) p_kk[jj] /= d;
+                }
+            });
+
+            // Update the trailing sub-matrix A22 -= L21.U12, by tiles of LUBLOCKSIZE rows x LUCHUNKSIZE columns
+            nRowBlocks = (n-k1+LUBLOCKSIZE-1)/LUBLOCKSIZE;
+            ParallelFor(nRowBlocks*nChunks, [=](int it)
+            {
+                int iStart = k1 + (it/nChunks)*LUBLOCKSIZE;
+                int iEnd   = std::min(iStart+LUBLOCKSIZE, n);
+                int jStart = k1 + (it%nChunks)*LUCHUNKSIZE;
+                int jEnd   = std::min(jStart+LUCHUNKSIZE, n);
+                for(int ii=iStart; ii<iEnd; ii++)
+                {
+                    T *p_ii = A + ii*n;
+                    int p=k0;
+                    // four rows of U at a time, subtracted in the same order as one at a time
+                    for(; p+3<k1; p+=4)
+                    {
+                        T l0 = p_ii[p],   l1 = p_ii[p+1], l2 = p_ii[p+2], l3 = p_ii[p+3];
+                        T const *p_0 = A + p*n;
+                        T const *p_1 = p_0 + n;
+                        T const *p_2 = p_1 + n;
+                        T const *p_3 = p_2 + n;
+                        for(int jj=jStart; jj<jEnd; jj++)
+                            p_ii[jj] = p_ii[jj] - l0*p_0[jj] - l1*p_1[jj] - l2*p_2[jj] - l3*p_3[jj];
+                    }
+                    for(; p<k1; p++)
+                    {
+                        T l = p_ii[p];
+                        T const *p_p = A + p*n;
+                        for(int jj=jStart; jj<jEnd; jj++) p_ii[jj] -= l * p_p[jj];
+                    }
+                }
+            });
+        }
 
-        Progress += TaskSize/double(n);
-        qApp->processEvents();
+        if(Progress) Progress(double(k1)/double(n));
         if(*pbCancel) return false;
     }
 
@@ -930,6 +1012,19 @@ bool Crout_LU_Decomposition_with_Pivoting(double *A, int pivot[], int n, bool *p
 }
 
 
+bool Crout_LU_Decomposition_with_Pivoting(double *A, int pivot[], int n, std::atomic<bool> const *pbCancel, std::function<void(double)> const &Progress)
+{
+    return CroutLUDecomposition(A, pivot, n, pbCancel, Progress);
+}
+
+
+bool Crout_LU_Decomposition_with_Pivoting(float *A, int pivot[], int n, std::atomic<bool> const *pbCancel, std::function<void(double)> const &Progress)
+{
+    //single precision version, for the mixed precision solver : half the memory and the bandwidth of the double version
+    return CroutLUDecomposition(A, pivot, n, pbCancel, Progress);
+}
+
+
 
 ////////////////////////////////////////////////////////////////////////////////
 //  int Crout_LU_with_Pivoting_Solve(double *LU, double B[], int pivot[],     //
@@ -964,25 +1059,48 @@ bool Crout_LU_Decomposition_with_Pivoting(double *A, int pivot[], int n, bool *p
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-bool Crout_LU_with_Pivoting_Solve(double *LU, double B[], int pivot[], double x[], int Size, bool *pbCancel)
+bool Crout_LU_with_Pivoting_Solve(double *LU, double B[], int pivot[], double x[], int Size, std::atomic<bool> const *pbCancel)
 {
-    int i, k;
+    int k, k0, k1, nRowBlocks;
     double *p_k;
     double dum;
 
-    //  Solve the linear equation Lx = B for x, where L is a lower triangular matrix.
-    for (k=0, p_k=LU; k<Size; p_k+=Size, k++)
+    //  Apply the row interchanges to a copy of B, so that B is left unchanged
+    memcpy(x, B, size_t(Size)*sizeof(double));
+    for (k=0; k<Size; k++)
     {
         if (pivot[k] != k)
         {
-            dum=B[k]; B[k]=B[pivot[k]]; B[pivot[k]]=dum;
+            dum=x[k]; x[k]=x[pivot[k]]; x[pivot[k]]=dum;
         }
+    }
 
-        x[k] = B[k];
-        for (i=0; i<k; i++) x[k]-=x[i] * *(p_k+i);
-        x[k] /= *(p_k+k);
+    //  Solve the linear equation Lx = B for x, where L is a lower triangular matrix.
+    //  The diagonal block is solved first, then the rows below are updated in parallel.
+    for (k0=0; k0<Size; k0+=LUBLOCKSIZE)
+    {
+        k1 = std::min(k0+LUBLOCKSIZE, Size);
+        for (k=k0, p_k=LU+k0*Size; k<k1; p_k+=Size, k++)
+        {
+            for (int i=k0; i<k; i++) x[k]-=x[i] * *(p_k+i);
+            if (*(p_k+k)==0.0) return false;
+            x[k] /= *(p_k+k);
+        }
+
+        nRowBlocks = (Size-k1+LUBLOCKSIZE-1)/LUBLOCKSIZE;
+        ParallelFor(nRowBlocks, [=](int ib)
+        {
+            int iStart = k1 + ib*LUBLOCKSIZE;
+            int iEnd   = std::min(iStart+LUBLOCKSIZE, Size);
+            for(int i=iStart; i<iEnd; i++)
+            {
+                double *p_i = LU + i*Size;
+                double sum = 0.0;
+                for(int p=k0; p<k1; p++) sum += x[p] * p_i[p];
+                x[i] -= sum;
+            }
+        });
 
-        qApp->processEvents();
         if(*pbCancel) return false;
     }
 
@@ -990,27 +1108,320 @@ bool Crout_LU_with_Pivoting_Solve(double *LU, double B[], int pivot[], double x[
     //  obtained above of Lx = B and U is an upper triangular matrix.
     //  The diagonal part of the upper triangular part of the matrix is
     //  assumed to be 1.0.
-    for (k=Size-1, p_k=LU+Size*(Size-1); k>=0; k--, p_k-=Size)
+    for (k1=Size; k1>0; k1-=LUBLOCKSIZE)
+    {
+        k0 = std::max(k1-LUBLOCKSIZE, 0);
+        for (k=k1-1, p_k=LU+Size*k; k>=k0; k--, p_k-=Size)
+        {
+            for (int i=k+1; i<k1; i++) x[k]-=x[i] * *(p_k+i);
+        }
+
+        nRowBlocks = (k0+LUBLOCKSIZE-1)/LUBLOCKSIZE;
+        ParallelFor(nRowBlocks, [=](int ib)
+        {
+            int iStart = ib*LUBLOCKSIZE;
+            int iEnd   = std::min(iStart+LUBLOCKSIZE, k0);
+            for(int i=iStart; i<iEnd; i++)
+            {
+                double *p_i = LU + i*Size;
+                double sum = 0.0;
+                for(int p=k0; p<k1; p++) sum += x[p] * p_i[p];
+                x[i] -= sum;
+            }
+        });
+
+        if(*pbCancel) return false;
+    }
+
+    return true;
+}
+
+
+
+template <typename T>
+static bool CroutLUSolveMultiple(T const *LU, double const *B, int const pivot[], double *X, int Size, int nRHS,
+                                 std::atomic<bool> const *pbCancel)
+{
+    //
+    // Solves the nRHS systems LU.X = B in one pass over the matrix
+    // B and X hold the right hand sides and the solutions in columns of Size elements,
+    // i.e. the k-th system is B[k*Size+i], i=0...Size-1
+    //
+    // The right hand sides are transposed in a work array, so that each row of the
+    // triangular matrices updates all the systems with contiguous memory accesses.
+    // The triangular solves are blocked as in the single RHS case.
+    //
+    int i, k, k0, k1, r, nRowBlocks;
+    double dum;
+
+    if(nRHS<=0) return true;
+
+    std::vector<double> Work(size_t(Size)*size_t(nRHS));
+    double *W = Work.data();
+
+    //  Transpose the RHS, and apply the row interchanges
+    for (r=0; r<nRHS; r++)
+    {
+        for (i=0; i<Size; i++) W[size_t(i)*nRHS+r] = B[size_t(r)*Size+i];
+    }
+    for (k=0; k<Size; k++)
     {
         if (pivot[k] != k)
         {
-            dum=B[k]; B[k]=B[pivot[k]]; B[pivot[k]]=dum;
+            double *w_k = W + size_t(k)*nRHS;
+            double *w_p = W + size_t(pivot[k])*nRHS;
+            for (r=0; r<nRHS; r++)
+            {
+                dum=w_k[r]; w_k[r]=w_p[r]; w_p[r]=dum;
+            }
+        }
+    }
+
+    //  Forward substitution, L holds the diagonal
+    for (k0=0; k0<Size; k0+=LUBLOCKSIZE)
+    {
+        k1 = std::min(k0+LUBLOCKSIZE, Size);
+        for (k=k0; k<k1; k++)
+        {
+            T const *p_k = LU + size_t(k)*Size;
+            double *w_k = W  + size_t(k)*nRHS;
+            for (i=k0; i<k; i++)
+            {
+                double l = p_k[i];
+                double const *w_i = W + size_t(i)*nRHS;
+                for (r=0; r<nRHS; r++) w_k[r] -= l * w_i[r];
+            }
+            if (p_k[k]==0.0) return false;
+            dum = 1.0/p_k[k];
+            for (r=0; r<nRHS; r++) w_k[r] *= dum;
         }
 
-        for (i=k+1; i<Size; i++) x[k]-=x[i] * *(p_k+i);
-        if (*(p_k+k)==0.0)
+        nRowBlocks = (Size-k1+LUBLOCKSIZE-1)/LUBLOCKSIZE;
+        ParallelFor(nRowBlocks, [=](int ib)
+        {
+            int iStart = k1 + ib*LUBLOCKSIZE;
+            int iEnd   = std::min(iStart+LUBLOCKSIZE, Size);
+            for(int ii=iStart; ii<iEnd; ii++)
+            {
+                T const *p_i = LU + size_t(ii)*Size;
+                double *w_i = W + size_t(ii)*nRHS;
+                for(int p=k0; p<k1; p++)
+                {
+                    double l = p_i[p];
+                    double const *w_p = W + size_t(p)*nRHS;
+                    for(int rr=0; rr<nRHS; rr++) w_i[rr] -= l * w_p[rr];
+                }
+            }
+        });
+
+        if(*pbCancel) return false;
+    }
+
+    //  Back substitution, U has a unit diagonal
+    for (k1=Size; k1>0; k1-=LUBLOCKSIZE)
+    {
+        k0 = std::max(k1-LUBLOCKSIZE, 0);
+        for (k=k1-1; k>=k0; k--)
         {
-            return false;
+            T const *p_k = LU + size_t(k)*Size;
+            double *w_k = W + size_t(k)*nRHS;
+            for (i=k+1; i<k1; i++)
+            {
+                double u = p_k[i];
+                double const *w_i = W + size_t(i)*nRHS;
+                for (r=0; r<nRHS; r++) w_k[r] -= u * w_i[r];
+            }
         }
 
-        qApp->processEvents();
+        nRowBlocks = (k0+LUBLOCKSIZE-1)/LUBLOCKSIZE;
+        ParallelFor(nRowBlocks, [=](int ib)
+        {
+            int iStart = ib*LUBLOCKSIZE;
+            int iEnd   = std::min(iStart+LUBLOCKSIZE, k0);
+            for(int ii=iStart; ii<iEnd; ii++)
+            {
+                T const *p_i = LU + size_t(ii)*Size;
+                double *w_i = W + size_t(ii)*nRHS;
+                for(int p=k0; p<k1; p++)
+                {
+                    double u = p_i[p];
+                    double const *w_p = W + size_t(p)*nRHS;
+                    for(int rr=0; rr<nRHS; rr++) w_i[rr] -= u * w_p[rr];
+                }
+            }
+        });
+
         if(*pbCancel) return false;
     }
 
+    //  Transpose the solutions back in columns
+    for (r=0; r<nRHS; r++)
+    {
+        for (i=0; i<Size; i++) X[size_t(r)*Size+i] = W[size_t(i)*nRHS+r];
+    }
+
     return true;
 }
 
 
+bool Crout_LU_with_Pivoting_Solve_Multiple(double *LU, double *B, int pivot[], double *X, int Size, int nRHS,
+                                           std::atomic<bool> const *pbCancel)
+{
+    return CroutLUSolveMultiple(LU, B, pivot, X, Size, nRHS, pbCancel);
+}
+
+
+bool Crout_LU_with_Pivoting_Solve_Multiple(float *LU, double *B, int pivot[], double *X, int Size, int nRHS,
+                                           std::atomic<bool> const *pbCancel)
+{
+    //single precision factors, the substitutions are computed in double precision
+    return CroutLUSolveMultiple(LU, B, pivot, X, Size, nRHS, pbCancel);
+}
+
+
+
+void MatrixVectorProduct(double const *A, double const *x, double *y, int n)
+{
+    // y = A.x, with the rows distributed between the threads
+    int nRowBlocks = (n+LUBLOCKSIZE-1)/LUBLOCKSIZE;
+    ParallelFor(nRowBlocks, [=](int ib)
+    {
+        int iStart = ib*LUBLOCKSIZE;
+        int iEnd   = std::min(iStart+LUBLOCKSIZE, n);
+        for(int i=iStart; i<iEnd; i++)
+        {
+            double const *a_i = A + size_t(i)*n;
+            double sum = 0.0;
+            for(int j=0; j<n; j++) sum += a_i[j] * x[j];
+            y[i] = sum;
+        }
+    });
+}
+
+
+static double Norm2(double const *x, int n)
+{
+    double sum = 0.0;
+    for(int i=0; i<n; i++) sum += x[i]*x[i];
+    return sqrt(sum);
+}
+
+
+bool GMRES_Solve(std::function<void(double const*, double*)> const &Product, double const *B, double *x, int n,
+                 std::function<void(double*)> const &Precondition,
+                 double Tolerance, int Restart, int MaxIter, int &nIter, double &Residual, std::atomic<bool> const *pbCancel)
+{
+    //
+    // Solves A.x = B with the restarted GMRES method, right preconditioned
+    //   - Product(x, y) sets y = A.x ; the matrix A is never accessed directly
+    //   - x holds the initial guess on input, and the solution on output
+    //   - Precondition(v) replaces v by an approximation of inv(A).v
+    //   - the iterations stop when |B-A.x|/|B| < Tolerance, or after MaxIter iterations
+    // Returns true if the tolerance has been reached, with the number of iterations and
+    // the relative residual in nIter and Residual.
+    //
+    int i, j, k;
+    double h, tmp;
+
+    std::vector<double> V(size_t(Restart+1)*n);   // the Krylov basis, one vector of n elements per row
+    std::vector<double> H(size_t(Restart+1)*Restart); // the Hessenberg matrix, stored by columns
+    std::vector<double> cs(Restart), sn(Restart), g(Restart+1), y(Restart);
+    std::vector<double> w(n), z(n);
+
+    nIter = 0;
+    Residual = 0.0;
+
+    double BNorm = Norm2(B, n);
+    if(BNorm<=0.0)
+    {
+        memset(x, 0, size_t(n)*sizeof(double));
+        return true;
+    }
+
+    for(;;)
+    {
+        // true residual for the current solution
+        Product(x, w.data());
+        for(i=0; i<n; i++) w[i] = B[i] - w[i];
+        double Beta = Norm2(w.data(), n);
+        Residual = Beta/BNorm;
+        if(Residual<=Tolerance) return true;
+        if(nIter>=MaxIter || *pbCancel) return false;
+
+        for(i=0; i<n; i++) V[i] = w[i]/Beta;
+        g.assign(Restart+1, 0.0);
+        g[0] = Beta;
+
+        for(j=0; j<Restart && nIter<MaxIter; j++)
+        {
+            nIter++;
+
+            // w = A.inv(M).v_j
+            memcpy(z.data(), V.data()+size_t(j)*n, size_t(n)*sizeof(double));
+            Precondition(z.data());
+            Product(z.data(), w.data());
+
+            // modified Gram-Schmidt orthogonalization against the basis
+            double *h_j = H.data() + size_t(j)*(Restart+1);
+            for(k=0; k<=j; k++)
+            {
+                double const *v_k = V.data()+size_t(k)*n;
+                h = 0.0;
+                for(i=0; i<n; i++) h += w[i]*v_k[i];
+                h_j[k] = h;
+                for(i=0; i<n; i++) w[i] -= h*v_k[i];
+            }
+            h_j[j+1] = Norm2(w.data(), n);
+            if(h_j[j+1]>0.0)
+            {
+                double *v_j1 = V.data()+size_t(j+1)*n;
+                for(i=0; i<n; i++) v_j1[i] = w[i]/h_j[j+1];
+            }
+
+            // apply the previous Givens rotations to the new column, then eliminate h(j+1,j)
+            for(k=0; k<j; k++)
+            {
+                tmp       =  cs[k]*h_j[k] + sn[k]*h_j[k+1];
+                h_j[k+1]  = -sn[k]*h_j[k] + cs[k]*h_j[k+1];
+                h_j[k]    =  tmp;
+            }
+            h = sqrt(h_j[j]*h_j[j] + h_j[j+1]*h_j[j+1]);
+            if(h<=0.0) return false;
+            cs[j] = h_j[j]/h;
+            sn[j] = h_j[j+1]/h;
+            h_j[j]   = h;
+            h_j[j+1] = 0.0;
+            g[j+1] = -sn[j]*g[j];
+            g[j]   =  cs[j]*g[j];
+
+            Residual = fabs(g[j+1])/BNorm;
+            if(*pbCancel) return false;
+            if(Residual<=Tolerance)
+            {
+                j++;
+                break;
+            }
+        }
+
+        // solve the triangular system H.y = g, and update the solution x = x + inv(M).V.y
+        for(k=j-1; k>=0; k--)
+        {
+            tmp = g[k];
+            for(i=k+1; i<j; i++) tmp -= H[size_t(i)*(Restart+1)+k]*y[i];
+            y[k] = tmp/H[size_t(k)*(Restart+1)+k];
+        }
+        memset(z.data(), 0, size_t(n)*sizeof(double));
+        for(k=0; k<j; k++)
+        {
+            double const *v_k = V.data()+size_t(k)*n;
+            for(i=0; i<n; i++) z[i] += y[k]*v_k[i];
+        }
+        Precondition(z.data());
+        for(i=0; i<n; i++) x[i] += z[i];
+    }
+}
+
+
 
 double Det33(double *aij)
 {
@@ -1267,9 +1678,11 @@ void VLMCmn(Vector3d const &A, Vector3d const &B, Vector3d const &WindDirection,
     //
     // Vectorial operations are written inline to save computing times
     // -->longer code, but 4x more efficient....
+    //
+    // All intermediate values are local, so that the function may be called concurrently from several threads
 
-    static double Omega, ftmp;
-    static Vector3d h, r0,r1, r2, Psi, Far, t;
+    double Omega, ftmp;
+    Vector3d h, r0,r1, r2, Psi, Far, t;
 
     V.x = 0.0;
     V.y = 0.0;
@@ -1433,10 +1846,11 @@ void VLMQmn(Vector3d const &LA, Vector3d const &LB, Vector3d const &TA, Vector3d
 
     //
     // Vectorial operations are written explicitly to save computing times (4x more efficient)
+    // All intermediate values are local, so that the function may be called concurrently from several threads
     //
-    static Vector3d R[5];
-    static Vector3d r0, r1, r2, Psi, t;
-    static double ftmp, r1v, r2v, Omega;
+    Vector3d R[5];
+    Vector3d r0, r1, r2, Psi, t;
+    double ftmp, r1v, r2v, Omega;
     V.x = 0.0;
     V.y = 0.0;
     V.z = 0.0;
@@ -1514,7 +1928,7 @@ bool Intersect(Vector3d const &LA, Vector3d const &LB, Vector3d const &TA, Vecto
     //    dist = |AI|
     //    The return value is true if intersection inside the quadrangle, false otherwise
     //
-    static Vector3d P, W, V, T;
+    Vector3d P, W, V, T;
     bool b1, b2, b3, b4;
     double r,s;
 
@@ -1623,9 +2037,9 @@ double Det44(double *aij)
 {
     //    returns the determinant of a 4x4 matrix
 
-    static int i,j,k,l,p,q;
-    static double sign;
-    static double det, a33[9];
+    int i,j,k,l,p,q;
+    double sign;
+    double det, a33[9];
     det = 0.0;
 
     i=0;
@@ -1744,5 +2158,171 @@ void SetWindAxis(double const Beta, Vector3d &WindDirection, Vector3d &WindNorma
 
 
 
+int ThreadCount()
+{
+    int nThreads = int(std::thread::hardware_concurrency());
+    return nThreads>0 ? nThreads : 1;
+}
+
+
+double AvailableMemory()
+{
+    // returns an estimate of the physical memory available to the program, in bytes
+#ifdef Q_OS_WIN
+    MEMORYSTATUSEX Status;
+    Status.dwLength = sizeof(Status);
+    if(GlobalMemoryStatusEx(&Status)) return double(Status.ullAvailPhys);
+#else
+    QFile MemInfo("/proc/meminfo");
+    if(MemInfo.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        QTextStream in(&MemInfo);
+        QString strong = in.readLine();
+        while(!strong.isNull())
+        {
+            if(strong.startsWith("MemAvailable:"))
+                return strong.section(' ', 1, 1, QString::SectionSkipEmpty).toDouble() * 1024.0;
+            strong = in.readLine();
+        }
+    }
+    //no better estimate : assume half of the physical memory is available
+    long nPages = sysconf(_SC_PHYS_PAGES);
+    long PageSize = sysconf(_SC_PAGESIZE);
+    if(nPages>0 && PageSize>0) return double(nPages) * double(PageSize) / 2.0;
+#endif
+    return 0.0;
+}
+
+
+
+/**
+* The worker threads which run the loops of ParallelFor().
+* They are started by the first loop and kept until the program exits, sleeping between the loops,
+* so that the loops called at each step of the solvers do not create threads.
+* A single loop runs at a time ; Start() returns false while the loop of another thread is running.
+*/
+class WorkerPool
+{
+public:
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_bExit = true;
+        }
+        m_Wake.notify_all();
+        for(uint it=0; it<m_Threads.size(); it++) m_Threads[it].join();
+    }
+
+    bool Start(std::function<void()> const &Work, int nHelpers)
+    {
+        // wakes nHelpers workers to run Work ; the caller runs its own part, then calls Wait()
+        if(!m_LoopMutex.try_lock()) return false;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            while(int(m_Threads.size())<ThreadCount()-1)
+            {
+                int iWorker = int(m_Threads.size());
+                m_Threads.push_back(std::thread([this, iWorker](){RunWorker(iWorker);}));
+            }
+            m_pWork    = &Work;
+            m_nHelpers = std::min(nHelpers, int(m_Threads.size()));
+            m_nRunning = m_nHelpers;
+            m_Generation++;
+        }
+        m_Wake.notify_all();
+        return true;
+    }
+
+    void Wait()
+    {
+        // returns once the workers have completed the loop
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Done.wait(lock, [this](){return m_nRunning==0;});
+            m_pWork = nullptr;
+        }
+        m_LoopMutex.unlock();
+    }
+
+private:
+    void RunWorker(int iWorker)
+    {
+        unsigned long Generation = 0;
+        for(;;)
+        {
+            std::function<void()> const *pWork;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Wake.wait(lock, [&](){return m_bExit || (m_Generation!=Generation && iWorker<m_nHelpers);});
+                if(m_bExit) return;
+                Generation = m_Generation;
+                pWork = m_pWork;
+            }
+
+            (*pWork)();
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if(--m_nRunning==0) m_Done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> m_Threads;
+    std::mutex m_LoopMutex;                 // held by the thread whose loop is running
+    std::mutex m_Mutex;                     // guards the members below
+    std::condition_variable m_Wake, m_Done;
+    std::function<void()> const *m_pWork = nullptr;
+    unsigned long m_Generation = 0;         // incremented at each loop
+    int m_nHelpers = 0;                     // the number of workers taking part in the current loop
+    int m_nRunning = 0;                     // the number of those which have not finished it
+    bool m_bExit = false;
+};
+
+
+/**
+* Runs Task(i) for i=0..nTasks-1, distributing the tasks dynamically between the available cores.
+* The calling thread takes part in the work, and returns only once all the tasks have been completed.
+* If Poll is provided, it is called by the calling thread after each of its own tasks; if it returns false
+* the remaining tasks are not started and the function returns false.
+* The tasks must be independent of each other, and must not call Qt GUI functions.
+* A loop started from within the task of another loop runs serially on the calling thread,
+* since all the cores are already busy, as does a loop started while another thread's loop is running.
+* The threads are those of a WorkerPool shared by all the loops.
+*/
+bool ParallelFor(int nTasks, std::function<void(int)> const &Task, std::function<bool()> const &Poll)
+{
+    static thread_local bool s_bInLoop = false;
+    static WorkerPool s_Pool;
+
+    if(nTasks<=0) return true;
+
+    std::atomic<int> next(0);
+    std::atomic<bool> bCancel(false);
 
+    std::function<void()> worker = [&]()
+    {
+        int i;
+        s_bInLoop = true;
+        while(!bCancel && (i=next++)<nTasks) Task(i);
+        s_bInLoop = false;
+    };
+
+    int nThreads = std::min(ThreadCount(), nTasks);
+    bool bPool = !s_bInLoop && nThreads>1 && s_Pool.Start(worker, nThreads-1);
+
+    int i;
+    bool bInLoop = s_bInLoop;
+    s_bInLoop = true;
+    while(!bCancel && (i=next++)<nTasks)
+    {
+        Task(i);
+        if(Poll && !Poll()) bCancel = true;
+    }
+    s_bInLoop = bInLoop;
+
+    if(bPool) s_Pool.Wait();
+
+    return !bCancel;
+}
 
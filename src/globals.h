@@ -18,6 +18,8 @@
 #include <QColor>
 #include <QList>
 #include <complex>
+#include <functional>
+#include <atomic>
 
 #include "objects/vector3d.h"
 
@@ -81,8 +83,19 @@ bool LinBairstow(double *p, complex<double> *root, int n);
 bool Eigenvector(double a[][4], complex<double> lambda, complex<double> *V);
 
 
-bool Crout_LU_Decomposition_with_Pivoting(double *A, int pivot[], int n, bool *pbCancel, double TaskSize, double &Progress);
-bool Crout_LU_with_Pivoting_Solve(double *LU, double B[], int pivot[], double x[], int n, bool *pbCancel);
+bool Crout_LU_Decomposition_with_Pivoting(double *A, int pivot[], int n, std::atomic<bool> const *pbCancel, std::function<void(double)> const &Progress=nullptr);
+bool Crout_LU_Decomposition_with_Pivoting(float *A, int pivot[], int n, std::atomic<bool> const *pbCancel, std::function<void(double)> const &Progress=nullptr);
+bool Crout_LU_with_Pivoting_Solve(double *LU, double B[], int pivot[], double x[], int n, std::atomic<bool> const *pbCancel);
+bool Crout_LU_with_Pivoting_Solve_Multiple(double *LU, double *B, int pivot[], double *X, int Size, int nRHS, std::atomic<bool> const *pbCancel);
+bool Crout_LU_with_Pivoting_Solve_Multiple(float *LU, double *B, int pivot[], double *X, int Size, int nRHS, std::atomic<bool> const *pbCancel);
+void MatrixVectorProduct(double const *A, double const *x, double *y, int n);
+bool GMRES_Solve(std::function<void(double const*, double*)> const &Product, double const *B, double *x, int n,
+                 std::function<void(double*)> const &Precondition,
+                 double Tolerance, int Restart, int MaxIter, int &nIter, double &Residual, std::atomic<bool> const *pbCancel);
+
+int ThreadCount();
+double AvailableMemory();
+bool ParallelFor(int nTasks, std::function<void(int)> const &Task, std::function<bool()> const &Poll = nullptr);
 
 
 bool SplineInterpolation(int n, double *x, double *y,  double *a, double *b, double *c, double *d);
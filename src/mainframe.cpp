@@ -18,6 +18,7 @@
 #include <QFileDialog>
 #include <QFontDatabase>
 #include <QDesktopServices>
+#include <new>
 
 #include "./mainframe.h"
 #include "./globals.h"
@@ -97,6 +98,9 @@ MainFrame::MainFrame(QWidget *parent, Qt::WindowFlags flags)
 
     m_LastDirName = QDir::homePath();
 
+    m_bAutoSave = false;     // the autosave writes to the project file, so that the user enables it
+    m_AutoSaveInterval = AUTOSAVEINTERVAL;
+
     QDesktopWidget desktop;
     QRect r = desktop.screenGeometry();
     m_DlgPos = QPoint(int(r.width()/3), int(r.height()/3));
@@ -168,17 +172,157 @@ MainFrame::MainFrame(QWidget *parent, Qt::WindowFlags flags)
             m_UFOType = "";
 
     m_bSaved     = true;
+    m_SaveRevision = 0;
 
-    memset(m_aij, 0, sizeof(m_aij));
-    memset(m_aijRef, 0, sizeof(m_aijRef));
-    memset(m_RHS, 0, sizeof(m_RHS));
-    memset(m_RHSRef, 0, sizeof(m_RHSRef));
+    m_pSaveSnapshot = nullptr;
+    m_nFileResults = m_nSaveAppends = 0;
+    connect(this, SIGNAL(SaveFinished()), this, SLOT(OnSaveFinished()), Qt::QueuedConnection);
 
+    m_pAutoSaveTimer = new QTimer(this);
+    connect(m_pAutoSaveTimer, SIGNAL(timeout()), this, SLOT(OnAutoSaveTimer()));
+    if(m_bAutoSave) m_pAutoSaveTimer->start(m_AutoSaveInterval*60000);
 
-    CPanel::s_pNode = m_Node;
     CPanel::s_VortexPos = 0.25;
     CPanel::s_CtrlPos   = 0.75;
 
+    m_MaxPanels = m_MaxNodes = m_MaxMatrixSize = 0;
+    m_bSingleLUMatrix = false;
+    m_aij = m_aijRef = m_RHS = m_RHSRef = nullptr;
+    m_Node = m_MemNode = m_WakeNode = m_RefWakeNode = nullptr;
+    m_Panel = m_MemPanel = m_WakePanel = m_RefWakePanel = nullptr;
+
+    // start small, the arrays are resized when a boat is meshed
+    AllocateSolverArrays(1, 4);
+
+    HideToolbars();
+
+    SetMenus();
+}
+
+
+MainFrame::~MainFrame()
+{
+    if(m_SaveThread.joinable()) m_SaveThread.join();
+    delete m_pSaveSnapshot;
+    ReleaseSolverArrays();
+}
+
+
+bool MainFrame::AllocateSolverArrays(int nPanels, int nNodes)
+{
+    //
+    // Makes sure the solver arrays can hold nPanels panels and nNodes nodes
+    // The arrays are only grown, so that the memory is reused between boats and analysis
+    // The influence matrices are allocated separately, by AllocateMatrix()
+    //
+    nPanels = qMax(nPanels, 1);
+    nNodes  = qMax(nNodes,  1);
+
+    if(nPanels<=m_MaxPanels && nNodes<=m_MaxNodes) return true;
+
+    nPanels = qMax(nPanels, m_MaxPanels);
+    nNodes  = qMax(nNodes,  m_MaxNodes);
+
+    ReleaseSolverArrays();
+
+    size_t RHSSize = size_t(nPanels) * size_t(VLMMAXRHS);
+
+    m_RHS          = new (std::nothrow) double[RHSSize];
+    m_RHSRef       = new (std::nothrow) double[RHSSize];
+    m_Node         = new (std::nothrow) Vector3d[nNodes];
+    m_MemNode      = new (std::nothrow) Vector3d[nNodes];
+    m_WakeNode     = new (std::nothrow) Vector3d[nNodes];
+    m_RefWakeNode  = new (std::nothrow) Vector3d[nNodes];
+    m_Panel        = new (std::nothrow) CPanel[nPanels];
+    m_MemPanel     = new (std::nothrow) CPanel[nPanels];
+    m_WakePanel    = new (std::nothrow) CPanel[nPanels];
+    m_RefWakePanel = new (std::nothrow) CPanel[nPanels];
+
+    if(!m_RHS || !m_RHSRef ||
+       !m_Node || !m_MemNode || !m_WakeNode || !m_RefWakeNode ||
+       !m_Panel || !m_MemPanel || !m_WakePanel || !m_RefWakePanel)
+    {
+        // fall back on the smallest arrays, the caller decides what to tell the user
+        ReleaseSolverArrays();
+        AllocateSolverArrays(1, 4);
+        return false;
+    }
+
+    m_MaxPanels = nPanels;
+    m_MaxNodes  = nNodes;
+
+    memset(m_RHS,    0, RHSSize*sizeof(double));
+    memset(m_RHSRef, 0, RHSSize*sizeof(double));
+
+    SetSolverPointers();
+
+    return true;
+}
+
+
+void MainFrame::ReleaseSolverArrays()
+{
+    delete [] m_aij;           m_aij          = nullptr;
+    delete [] m_aijRef;        m_aijRef       = nullptr;
+    delete [] m_RHS;           m_RHS          = nullptr;
+    delete [] m_RHSRef;        m_RHSRef       = nullptr;
+    delete [] m_Node;          m_Node         = nullptr;
+    delete [] m_MemNode;       m_MemNode      = nullptr;
+    delete [] m_WakeNode;      m_WakeNode     = nullptr;
+    delete [] m_RefWakeNode;   m_RefWakeNode  = nullptr;
+    delete [] m_Panel;         m_Panel        = nullptr;
+    delete [] m_MemPanel;      m_MemPanel     = nullptr;
+    delete [] m_WakePanel;     m_WakePanel    = nullptr;
+    delete [] m_RefWakePanel;  m_RefWakePanel = nullptr;
+
+    m_MaxPanels = m_MaxNodes = m_MaxMatrixSize = 0;
+}
+
+
+bool MainFrame::AllocateMatrix(int nPanels, bool bSingleLU)
+{
+    //
+    // Makes sure the influence matrices can hold nPanels panels
+    // They are allocated only when an analysis needs them, since the matrix-free solver
+    // does not build them and they would prevent the meshing of large boats
+    // If bSingleLU, m_aij only needs to hold the single precision LU decomposition, i.e. half the size of m_aijRef
+    //
+    nPanels = qMax(nPanels, 1);
+    if(nPanels<=m_MaxMatrixSize && bSingleLU==m_bSingleLUMatrix) return true;
+
+    delete [] m_aij;      m_aij    = nullptr;
+    delete [] m_aijRef;   m_aijRef = nullptr;
+    m_MaxMatrixSize = 0;
+
+    size_t MatSize = size_t(nPanels) * size_t(nPanels);
+    size_t LUSize  = bSingleLU ? (MatSize+1)/2 : MatSize;
+    m_aij    = new (std::nothrow) double[LUSize];
+    m_aijRef = new (std::nothrow) double[MatSize];
+
+    if(!m_aij || !m_aijRef)
+    {
+        delete [] m_aij;      m_aij    = nullptr;
+        delete [] m_aijRef;   m_aijRef = nullptr;
+    }
+    else
+    {
+        memset(m_aij,    0, LUSize*sizeof(double));
+        memset(m_aijRef, 0, MatSize*sizeof(double));
+        m_MaxMatrixSize = nPanels;
+        m_bSingleLUMatrix = bSingleLU;
+    }
+
+    SetSolverPointers();
+    return m_MaxMatrixSize>0;
+}
+
+
+void MainFrame::SetSolverPointers()
+{
+    //
+    // The panel classes and the analysis work directly on the arrays owned by the MainFrame
+    //
+    CPanel::s_pNode = m_Node;
 
     m_pSail7->m_paij          = m_aij;
     m_pSail7->m_paijRef       = m_aijRef;
@@ -202,13 +346,9 @@ MainFrame::MainFrame(QWidget *parent, Qt::WindowFlags flags)
     BoatAnalysisDlg::s_pRefWakeNode  = m_RefWakeNode;
     BoatAnalysisDlg::s_pRefWakePanel = m_RefWakePanel;
     BoatAnalysisDlg::s_aij           = m_aij;
-    BoatAnalysisDlg::s_aijWake       = m_aijRef;
+    BoatAnalysisDlg::s_aijRef        = m_aijRef;
     BoatAnalysisDlg::s_RHS           = m_RHS;
     BoatAnalysisDlg::s_RHSRef        = m_RHSRef;
-
-    HideToolbars();
-
-    SetMenus();
 }
 
 
@@ -234,6 +374,7 @@ void MainFrame::AddRecentFile(const QString &PathName)
 
 void MainFrame::closeEvent (QCloseEvent * event)
 {
+    WaitForSave();
     if(!m_bSaved)
     {
         int resp = QMessageBox::question(this, tr("Exit"), tr("Save the project before exit ?"),
@@ -302,6 +443,12 @@ void MainFrame::CreateActions()
     saveProjectAsAct->setStatusTip(tr("Save the current project under a new name"));
     connect(saveProjectAsAct, SIGNAL(triggered()), this, SLOT(OnSaveProjectAs()));
 
+    autoSaveAct = new QAction(tr("Autosave"), this);
+    autoSaveAct->setCheckable(true);
+    autoSaveAct->setChecked(m_bAutoSave);
+    autoSaveAct->setStatusTip(tr("Save the changes to the project file periodically, in the background ; the changes saved cannot be discarded on exit"));
+    connect(autoSaveAct, SIGNAL(triggered()), this, SLOT(OnAutoSave()));
+
     unitsAct = new QAction(tr("Units..."), this);
     unitsAct->setStatusTip(tr("Define the units for this project"));
     connect(unitsAct, SIGNAL(triggered()), this, SLOT(OnUnits()));
@@ -524,6 +671,8 @@ void MainFrame::CreateMainMenu()
     optionsMenu->addSeparator();
     optionsMenu->addAction(styleAct);
     optionsMenu->addSeparator();
+    optionsMenu->addAction(autoSaveAct);
+    optionsMenu->addSeparator();
     optionsMenu->addAction(restoreToolbarsAct);
     optionsMenu->addSeparator();
     optionsMenu->addAction(resetSettingsAct);
@@ -897,6 +1046,10 @@ void MainFrame::DeleteBoat(Boat *pThisBoat, bool bResultsOnly)
 
 void MainFrame::DeleteProject()
 {
+    WaitForSave();
+    m_SavedFile.clear();
+    m_SavedSections.clear();
+
     // clear everything
     int i;
     Boat *pBoat;
@@ -1062,6 +1215,9 @@ bool MainFrame::LoadSettings()
 
         m_LanguageFilePath = settings.value("LanguageFilePath").toString();
 
+        m_bAutoSave        = settings.value("AutoSave", false).toBool();
+        m_AutoSaveInterval = qMax(1, settings.value("AutoSaveInterval", AUTOSAVEINTERVAL).toInt());
+
         m_LengthUnit  = settings.value("LengthUnit").toInt();
         m_AreaUnit    = settings.value("AreaUnit").toInt();
         m_WeightUnit  = settings.value("WeightUnit").toInt();
@@ -1191,6 +1347,9 @@ bool MainFrame::LoadFile(QString PathName)
         }
         QApplication::restoreOverrideCursor();
 
+        // the next save appends the changes to the file, if its format allows it
+        RecordSavedFile(XFile);
+
         AddRecentFile(PathName);
         SetSaveState(true);
         SetProjectName(PathName);
@@ -1450,11 +1609,8 @@ void MainFrame::OnSaveProject()
         OnSaveProjectAs();
         return;
     }
-    if(SaveProject(m_FileName))
-    {
-        SetSaveState(true);
-        statusBar()->showMessage(tr("The project ") + m_ProjectName + tr(" has been saved"));
-    }
+    // the project is written in the background, and marked as saved once complete
+    SaveProject(m_FileName, true);
     m_pSail7->m_bArcball = false;
     m_pSail7->UpdateView();
 }
@@ -1710,8 +1866,11 @@ void MainFrame::openRecentFile()
 
 
 
-bool MainFrame::SaveProject(QString PathName)
+bool MainFrame::SaveProject(QString PathName, bool bBackground)
 {
+    // a single save runs at a time
+    WaitForSave();
+
     QString Filter = "Sail7 v0.01 Project File (*.sl7)";
     QString FileName = m_ProjectName;
 
@@ -1733,29 +1892,207 @@ bool MainFrame::SaveProject(QString PathName)
         if(pos>0) m_LastDirName = PathName.left(pos);
     }
 
-    QFile fp(PathName);
+    PathName = QFileInfo(PathName).absoluteFilePath();
+
+    // the changes are appended to the project file if it is the one last read or written,
+    // unless it holds too many objects which are no longer used, in which case it is written anew
+    bool bAppend = PathName==m_SavedFile && QFile::exists(PathName)
+                   && m_nSaveAppends<MAXSAVEAPPENDS && m_nFileResults<=2*m_oaBoatOpp.size();
 
-    if (!fp.open(QIODevice::WriteOnly))
+    ProjectSnapshot *pSnapshot = new ProjectSnapshot;
+    if(!TakeProjectSnapshot(*pSnapshot, PathName, bAppend))
     {
-        QMessageBox::warning(window(), tr("Warning"), tr("Could not open the file for writing"));
+        delete pSnapshot;
+        QMessageBox::warning(window(), tr("Warning"), tr("Error writing the project file"));
         return false;
     }
 
+    if(bBackground)
+    {
+        // the snapshot is written by a separate thread, and the save is completed by OnSaveFinished()
+        statusBar()->showMessage(tr("Saving the project..."));
+        m_pSaveSnapshot = pSnapshot;
+        m_SaveThread = std::thread([this, pSnapshot]()
+        {
+            pSnapshot->bWritten = WriteProjectFile(*pSnapshot);
+            pSnapshot->bDone = true;
+            emit SaveFinished();
+        });
+        return true;
+    }
+
     QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    pSnapshot->bWritten = WriteProjectFile(*pSnapshot);
+    QApplication::restoreOverrideCursor();
+
+    bool bSaved = EndSave(*pSnapshot);
+    delete pSnapshot;
+    return bSaved;
+}
 
-    QDataStream ar(&fp);
+
+bool MainFrame::EndSave(ProjectSnapshot &Snapshot)
+{
+    //
+    // Completes the save once the snapshot has been written
+    //
+    QString FileName = Snapshot.PathName;
+    if(!Snapshot.bWritten)
+    {
+        // an incomplete section may remain after the end of the file, so that the next save writes it anew
+        if(!Snapshot.bAppend) QFile::remove(FileName+".tmp");
+        m_SavedFile.clear();
+        QMessageBox::warning(window(), tr("Warning"), tr("Error writing the project file"));
+        return false;
+    }
+
+    if(Snapshot.bAppend)
+    {
+        m_nSaveAppends++;
+        m_nFileResults += Snapshot.nWrittenResults;
+    }
+    else
+    {
+        // the project has been written to a temporary file,
+        // since the previous file may hold the panel results of the points which have not been loaded
+        QFile::remove(FileName);
+        if(!QFile::rename(FileName+".tmp", FileName))
+        {
+            // the project remains in the temporary file
+            QMessageBox::warning(window(), tr("Warning"), tr("Could not replace the file, the project has been saved in\n")+FileName+".tmp");
+            FileName += ".tmp";
+        }
+        m_nSaveAppends = 0;
+        m_nFileResults = Snapshot.nWrittenResults;
+    }
+
+    // record the contents of the file, so that the next save appends only the changes
+    // the project may have been modified during the save, but a section is reused only if its object
+    // still serializes to the same bytes, so that the objects which have changed meanwhile are written again,
+    // including those created at the address of a deleted object
+    m_SavedFile = FileName;
+    m_SavedSections.clear();
+    QVector<ProjectSection> *pSections[3] = {&Snapshot.Boats, &Snapshot.BoatPolars, &Snapshot.BoatOpps};
+    for(int il=0; il<3; il++)
+    {
+        for(int i=0; i<pSections[il]->size(); i++)
+            m_SavedSections.insert(pSections[il]->at(i).pObject, pSections[il]->at(i));
+    }
+
+    // the points read their results from the new file, unless they have been deleted or reloaded meanwhile
+    // a point created since the snapshot may have the address of a deleted one, but not its serial number
+    for(int ir=0; ir<Snapshot.Results.size(); ir++)
+    {
+        ResultSection const &Result = Snapshot.Results.at(ir);
+        BoatOpp *pBoatOpp = (BoatOpp*)Result.pObject;
+        if(!m_oaBoatOpp.contains(pBoatOpp) || pBoatOpp->m_Serial!=Result.Serial) continue;
+        if(pBoatOpp->m_ResultFile!=Result.SourceFile || pBoatOpp->m_ResultPos!=Result.SourcePos) continue;
+        pBoatOpp->SetResultSource(FileName, Result.Pos);
+    }
+
+    if(Snapshot.SaveRevision==m_SaveRevision)
+    {
+        SetSaveState(true);
+        statusBar()->showMessage(tr("The project ") + m_ProjectName + tr(" has been saved"));
+    }
+    m_FileName = FileName;
+
+    SaveSettings();
+    return true;
+}
+
+
+void MainFrame::RecordSavedFile(QFile &XFile)
+{
+    //
+    // Records the contents of the project file which has just been read, as if it had just been saved,
+    // so that the next save appends only the objects which have changed since.
+    // An object is recorded only if it serializes to the bytes stored at its position in the file ;
+    // the others, such as those read from an earlier format of the object, are written by the next save
+    //
+    m_SavedFile.clear();
+    m_SavedSections.clear();
+
+    QDataStream ar(&XFile);
 #if QT_VERSION >= 0x040500
     ar.setVersion(QDataStream::Qt_4_5);
 #endif
     ar.setByteOrder(QDataStream::LittleEndian);
 
-    SerializeProject(ar,true);
-    m_FileName = PathName;
-    fp.close();
+    int ArchiveFormat = 0;
+    qint64 IndexPos;
+    ProjectIndex Index;
+    if(!XFile.seek(0)) return;
+    ar >> ArchiveFormat;
+    if(ArchiveFormat<100032) return;
+    ar >> IndexPos;
+    if(!XFile.seek(IndexPos) || !SerializeProjectIndex(ar, Index, false)) return;
 
-    SaveSettings();
+    QString FileName = QFileInfo(XFile).absoluteFilePath();
+    ProjectSnapshot Snapshot;
+    if(!TakeProjectSnapshot(Snapshot, FileName, false)) return;
+
+    QVector<ProjectSection> *pSections[3] = {&Snapshot.Boats, &Snapshot.BoatPolars, &Snapshot.BoatOpps};
+    QVector<qint64> *pPositions[3] = {&Index.Boats, &Index.BoatPolars, &Index.BoatOpps};
+    for(int il=0; il<3; il++)
+    {
+        if(pSections[il]->size()!=pPositions[il]->size()) return;
+    }
+
+    for(int il=0; il<3; il++)
+    {
+        for(int i=0; i<pSections[il]->size(); i++)
+        {
+            ProjectSection &Section = (*pSections[il])[i];
+            Section.Pos = pPositions[il]->at(i);
+            if(!XFile.seek(Section.Pos) || XFile.read(Section.Data.size())!=Section.Data) continue;
+            m_SavedSections.insert(Section.pObject, Section);
+        }
+    }
+
+    m_SavedFile = FileName;
+    m_nFileResults = Index.BoatOppResults.size();
+    m_nSaveAppends = 0;
+}
+
+
+void MainFrame::WaitForSave()
+{
+    // waits for the end of the background save, if any, and completes it
+    if(!m_pSaveSnapshot) return;
+
+    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    m_SaveThread.join();
     QApplication::restoreOverrideCursor();
-    return true;
+
+    ProjectSnapshot *pSnapshot = m_pSaveSnapshot;
+    m_pSaveSnapshot = nullptr;
+    EndSave(*pSnapshot);
+    delete pSnapshot;
+}
+
+
+void MainFrame::OnSaveFinished()
+{
+    // the save thread has finished ; the signal of a save already completed by WaitForSave() is ignored
+    if(m_pSaveSnapshot && m_pSaveSnapshot->bDone) WaitForSave();
+}
+
+
+void MainFrame::OnAutoSave()
+{
+    m_bAutoSave = autoSaveAct->isChecked();
+    if(m_bAutoSave) m_pAutoSaveTimer->start(m_AutoSaveInterval*60000);
+    else            m_pAutoSaveTimer->stop();
+}
+
+
+void MainFrame::OnAutoSaveTimer()
+{
+    // saves the changes in the background if the project has a file,
+    // unless a save is already running, or an analysis is running and building the operating points
+    if(m_bSaved || m_pSaveSnapshot || !m_FileName.length() || !isEnabled()) return;
+    SaveProject(m_FileName, true);
 }
 
 
@@ -1786,6 +2123,8 @@ void MainFrame::SaveSettings()
         settings.setValue("ImageDirName", m_ImageDirName);
         settings.setValue("ExportLastDirName", m_ExportLastDirName);
         settings.setValue("XMLPath", m_XMLPath);
+        settings.setValue("AutoSave", m_bAutoSave);
+        settings.setValue("AutoSaveInterval", m_AutoSaveInterval);
         settings.setValue("LengthUnit", m_LengthUnit);
         settings.setValue("AreaUnit", m_AreaUnit);
         settings.setValue("WeightUnit", m_WeightUnit);
@@ -1866,44 +2205,16 @@ void MainFrame::SelectBoatOpp(double x)
 bool MainFrame::SerializeProject(QDataStream &ar, bool bIsStoring)
 {
     int n;
+    qint64 IndexPos;
+    ProjectIndex Index;
+    QIODevice *pDevice = ar.device();
+
     if (bIsStoring)
     {
         // storing code
-        ar << 100030;
-        // 100030; tentative format for Sail7 objects
-        ar << m_LengthUnit;
-        ar << m_AreaUnit;
-        ar << m_WeightUnit;
-        ar << m_SpeedUnit;
-        ar << m_ForceUnit;
-        ar << m_MomentUnit;
-
-
-        //serialize Sail7 objects
-        ar << m_oaBoat.size();
-        for(int ib=0; ib<m_oaBoat.size(); ib++)
-        {
-            Boat* pBoat = m_oaBoat.at(ib);
-            if(!pBoat->SerializeBoat(ar, true)) return false;
-        }
-
-        //serialize boat polars
-        ar << m_oaBoatPolar.size();
-        for(int ib=0; ib<m_oaBoatPolar.size(); ib++)
-        {
-            BoatPolar* pBoatPolar = m_oaBoatPolar.at(ib);
-            if(!pBoatPolar->SerializeBoatPlr(ar, true)) return false;
-        }
-
-        //serialize boat opps
-        ar << m_oaBoatOpp.size();
-        for(int ib=0; ib<m_oaBoatOpp.size(); ib++)
-        {
-            BoatOpp* pBoatOpp = m_oaBoatOpp.at(ib);
-            if(!pBoatOpp->SerializeBoatOpp(ar, true)) return false;
-        }
-
-        return true;
+        ProjectSnapshot Snapshot;
+        if(!TakeProjectSnapshot(Snapshot, QString(), false)) return false;
+        return WriteProjectSnapshot(Snapshot, pDevice);
     }
     else
     {
@@ -1912,6 +2223,7 @@ bool MainFrame::SerializeProject(QDataStream &ar, bool bIsStoring)
         int ArchiveFormat;
         ar >> n; //n is the ArchiveFormat number
         ArchiveFormat = n;
+        if(ArchiveFormat>=100031) ar >> IndexPos;
         ar >> m_LengthUnit;
         ar >> m_AreaUnit;
         ar >> m_WeightUnit;
@@ -1924,7 +2236,32 @@ bool MainFrame::SerializeProject(QDataStream &ar, bool bIsStoring)
 
 
         //serialize Sail7 objects
-        if(ArchiveFormat>=100030)
+        if(ArchiveFormat>=100032)
+        {
+            // the objects are read at the positions listed in the index
+            if(!pDevice->seek(IndexPos) || !SerializeProjectIndex(ar, Index, false)) return false;
+
+            for(int ib=0; ib<Index.Boats.size(); ib++)
+            {
+                Boat* pBoat= new Boat;
+                if(!pDevice->seek(Index.Boats.at(ib)) || !pBoat->SerializeBoat(ar, false)) return false;
+                m_oaBoat.append(pBoat);
+            }
+            for(int ib=0; ib<Index.BoatPolars.size(); ib++)
+            {
+                BoatPolar* pBoatPolar= new BoatPolar;
+                if(!pDevice->seek(Index.BoatPolars.at(ib)) || !pBoatPolar->SerializeBoatPlr(ar, false)) return false;
+                m_oaBoatPolar.append(pBoatPolar);
+            }
+            n = Index.BoatOpps.size();
+            for(int ib=0; ib<n; ib++)
+            {
+                BoatOpp* pBoatOpp= new BoatOpp;
+                if(!pDevice->seek(Index.BoatOpps.at(ib)) || !pBoatOpp->SerializeBoatOpp(ar, false)) return false;
+                m_oaBoatOpp.append(pBoatOpp);
+            }
+        }
+        else if(ArchiveFormat>=100030)
         {
             //serialize boats
             ar >>n;
@@ -1951,6 +2288,34 @@ bool MainFrame::SerializeProject(QDataStream &ar, bool bIsStoring)
                 if(!pBoatOpp->SerializeBoatOpp(ar, false)) return false;
                 m_oaBoatOpp.append(pBoatOpp);
             }
+            if(ArchiveFormat>=100031)
+            {
+                if(!pDevice->seek(IndexPos) || !SerializeProjectIndex(ar, Index, false)) return false;
+            }
+        }
+
+        if(ArchiveFormat>=100031)
+        {
+            // the panel results are left in the file, and are read when the points are displayed
+            // unless the stream is not a file, in which case they are read now
+            if(Index.BoatOppResults.size()!=n) return false;
+
+            QFile *pFile = qobject_cast<QFile*>(pDevice);
+            QString FileName;
+            if(pFile) FileName = QFileInfo(*pFile).absoluteFilePath();
+            for(int ib=0; ib<n; ib++)
+            {
+                BoatOpp *pBoatOpp = m_oaBoatOpp.at(m_oaBoatOpp.size()-n+ib);
+                if(pFile)
+                {
+                    pBoatOpp->SetResultSource(FileName, Index.BoatOppResults.at(ib));
+                }
+                else
+                {
+                    if(!pDevice->seek(Index.BoatOppResults.at(ib))) return false;
+                    if(!pBoatOpp->SerializePanelResults(ar, false)) return false;
+                }
+            }
         }
 
         return true;
@@ -1958,6 +2323,243 @@ bool MainFrame::SerializeProject(QDataStream &ar, bool bIsStoring)
 }
 
 
+bool MainFrame::SerializeProjectIndex(QDataStream &ar, ProjectIndex &Index, bool bIsStoring)
+{
+    // the index of the positions of the objects, written after the objects in the project file
+    int ArchiveFormat;
+    QVector<qint64> *pList[4] = {&Index.Boats, &Index.BoatPolars, &Index.BoatOpps, &Index.BoatOppResults};
+
+    if(bIsStoring)
+    {
+        ar << 100001;
+        //100001 : first file format
+        for(int il=0; il<4; il++)
+        {
+            ar << pList[il]->size();
+            for(int i=0; i<pList[il]->size(); i++) ar << pList[il]->at(i);
+        }
+    }
+    else
+    {
+        int n;
+        qint64 pos;
+        ar >> ArchiveFormat;
+        if(ArchiveFormat<100000 || ArchiveFormat>120000) return false;
+        for(int il=0; il<4; il++)
+        {
+            ar >> n;
+            if(n<0 || ar.status()!=QDataStream::Ok) return false;
+            pList[il]->clear();
+            for(int i=0; i<n; i++)
+            {
+                ar >> pos;
+                pList[il]->append(pos);
+            }
+        }
+    }
+    return ar.status()==QDataStream::Ok;
+}
+
+
+bool MainFrame::SnapshotSection(void const *pObject, std::function<bool(QDataStream&)> const &Serialize, bool bAppend, QVector<ProjectSection> &Sections)
+{
+    // serializes the object in memory ; if it is unchanged since the last save, the section already in the file is used
+    ProjectSection Section;
+    Section.pObject = pObject;
+    Section.Pos = -1;
+
+    QDataStream ar(&Section.Data, QIODevice::WriteOnly);
+#if QT_VERSION >= 0x040500
+    ar.setVersion(QDataStream::Qt_4_5);
+#endif
+    ar.setByteOrder(QDataStream::LittleEndian);
+    if(!Serialize(ar)) return false;
+
+    if(bAppend)
+    {
+        QHash<void const*, ProjectSection>::const_iterator it = m_SavedSections.constFind(pObject);
+        if(it!=m_SavedSections.constEnd() && it.value().Data==Section.Data) Section.Pos = it.value().Pos;
+    }
+    Sections.append(Section);
+    return true;
+}
+
+
+bool MainFrame::TakeProjectSnapshot(ProjectSnapshot &Snapshot, QString const &PathName, bool bAppend)
+{
+    //
+    // Copies the state of the project, so that it may be written by a separate thread while the project is modified.
+    // The objects are serialized in memory, and the panel results are copied,
+    // except those which are already stored in the project file when the changes are appended to it,
+    // and those which have not been loaded, which are read from their file by the save thread
+    //
+    Snapshot.PathName = PathName;
+    Snapshot.bAppend = bAppend;
+    Snapshot.SaveRevision = m_SaveRevision;
+    Snapshot.nWrittenResults = 0;
+    Snapshot.bWritten = false;
+    Snapshot.bDone = false;
+
+    Snapshot.Units[0] = m_LengthUnit;
+    Snapshot.Units[1] = m_AreaUnit;
+    Snapshot.Units[2] = m_WeightUnit;
+    Snapshot.Units[3] = m_SpeedUnit;
+    Snapshot.Units[4] = m_ForceUnit;
+    Snapshot.Units[5] = m_MomentUnit;
+
+    for(int ib=0; ib<m_oaBoat.size(); ib++)
+    {
+        Boat *pBoat = m_oaBoat.at(ib);
+        if(!SnapshotSection(pBoat, [pBoat](QDataStream &ar){return pBoat->SerializeBoat(ar, true);}, bAppend, Snapshot.Boats))
+            return false;
+    }
+
+    for(int ib=0; ib<m_oaBoatPolar.size(); ib++)
+    {
+        BoatPolar *pBoatPolar = m_oaBoatPolar.at(ib);
+        if(!SnapshotSection(pBoatPolar, [pBoatPolar](QDataStream &ar){return pBoatPolar->SerializeBoatPlr(ar, true);}, bAppend, Snapshot.BoatPolars))
+            return false;
+    }
+
+    for(int ib=0; ib<m_oaBoatOpp.size(); ib++)
+    {
+        BoatOpp *pBoatOpp = m_oaBoatOpp.at(ib);
+        if(!SnapshotSection(pBoatOpp, [pBoatOpp](QDataStream &ar){return pBoatOpp->SerializeBoatOpp(ar, true);}, bAppend, Snapshot.BoatOpps))
+            return false;
+
+        ResultSection Result;
+        Result.pObject    = pBoatOpp;
+        Result.Serial     = pBoatOpp->m_Serial;
+        Result.Pos        = -1;
+        Result.nPanels    = pBoatOpp->m_NVLMPanels;
+        Result.SourceFile = pBoatOpp->m_ResultFile;
+        Result.SourcePos  = pBoatOpp->m_ResultPos;
+
+        if(bAppend && pBoatOpp->m_ResultFile==PathName)
+        {
+            Result.Pos = pBoatOpp->m_ResultPos;
+        }
+        else if(pBoatOpp->ResultsLoaded())
+        {
+            Result.Values.resize(3*Result.nPanels);
+            if(Result.nPanels) memcpy(Result.Values.data(), pBoatOpp->m_Cp, 3*size_t(Result.nPanels)*sizeof(double));
+        }
+        else if(!Result.SourceFile.length()) return false;
+
+        Snapshot.Results.append(Result);
+    }
+    return true;
+}
+
+
+bool MainFrame::WriteProjectFile(ProjectSnapshot &Snapshot)
+{
+    // writes the snapshot to its project file, or to a temporary file if the project is written anew
+    // may be called from the save thread
+    QFile XFile(Snapshot.bAppend ? Snapshot.PathName : Snapshot.PathName+".tmp");
+    if(!XFile.open(Snapshot.bAppend ? QIODevice::ReadWrite : QIODevice::WriteOnly)) return false;
+
+    bool bWritten = WriteProjectSnapshot(Snapshot, &XFile);
+    XFile.close();
+    return bWritten && XFile.error()==QFile::NoError;
+}
+
+
+bool MainFrame::WriteProjectSnapshot(ProjectSnapshot &Snapshot, QIODevice *pDevice)
+{
+    //
+    // Writes the snapshot of the project ; does not use the GUI, so that it may be called from the save thread.
+    // If Snapshot.bAppend is true, the device holds the project file in format 100032 ;
+    // the sections which have changed are appended after its end, followed by a new index,
+    // and the position of the index is updated last, so that the file remains readable if the save is interrupted
+    //
+    QDataStream ar(pDevice);
+#if QT_VERSION >= 0x040500
+    ar.setVersion(QDataStream::Qt_4_5);
+#endif
+    ar.setByteOrder(QDataStream::LittleEndian);
+
+    qint64 HeaderPos = Snapshot.bAppend ? 0 : pDevice->pos();
+    Snapshot.Index = ProjectIndex();
+    Snapshot.nWrittenResults = 0;
+
+    if(Snapshot.bAppend)
+    {
+        if(!pDevice->seek(HeaderPos + qint64(sizeof(int) + sizeof(qint64)))) return false;
+    }
+    else
+    {
+        ar << 100032;
+        // 100032; the objects are read at the positions listed in the index, so that the changes may be appended to the file
+        // 100031; the objects are followed by the panel results of the operating points, and by the index of their positions
+        // 100030; tentative format for Sail7 objects
+        ar << qint64(0);   // the position of the index, set once the objects have been written
+    }
+    for(int iu=0; iu<6; iu++) ar << Snapshot.Units[iu];
+
+    if(Snapshot.bAppend && !pDevice->seek(pDevice->size())) return false;
+
+    //serialize the boats, the polars and the operating points without their panel results
+    QVector<ProjectSection> *pSections[3] = {&Snapshot.Boats, &Snapshot.BoatPolars, &Snapshot.BoatOpps};
+    QVector<qint64> *pPositions[3] = {&Snapshot.Index.Boats, &Snapshot.Index.BoatPolars, &Snapshot.Index.BoatOpps};
+    for(int il=0; il<3; il++)
+    {
+        for(int i=0; i<pSections[il]->size(); i++)
+        {
+            ProjectSection &Section = (*pSections[il])[i];
+            if(Section.Pos<0)
+            {
+                Section.Pos = pDevice->pos();
+                if(ar.writeRawData(Section.Data.constData(), Section.Data.size())!=Section.Data.size()) return false;
+            }
+            pPositions[il]->append(Section.Pos);
+        }
+    }
+
+    //serialize the panel results ; those which have not been loaded are read from their file
+    for(int ir=0; ir<Snapshot.Results.size(); ir++)
+    {
+        ResultSection &Result = Snapshot.Results[ir];
+        if(Result.Pos<0)
+        {
+            if(Result.Values.size()!=3*Result.nPanels)
+            {
+                QFile SourceFile(Result.SourceFile);
+                if(!SourceFile.open(QIODevice::ReadOnly) || !SourceFile.seek(Result.SourcePos)) return false;
+
+                QDataStream Source(&SourceFile);
+#if QT_VERSION >= 0x040500
+                Source.setVersion(QDataStream::Qt_4_5);
+#endif
+                Source.setByteOrder(QDataStream::LittleEndian);
+
+                Result.Values.resize(3*Result.nPanels);
+                if(!BoatOpp::ReadPanelResults(Source, Result.Values.data(), Result.nPanels)) return false;
+            }
+            Result.Pos = pDevice->pos();
+            BoatOpp::WritePanelResults(ar, Result.Values.constData(), Result.nPanels);
+            Result.Values.clear();
+            Snapshot.nWrittenResults++;
+        }
+        Snapshot.Index.BoatOppResults.append(Result.Pos);
+    }
+
+    qint64 IndexPos = pDevice->pos();
+    if(!SerializeProjectIndex(ar, Snapshot.Index, true)) return false;
+    qint64 EndPos = pDevice->pos();
+
+    // the new sections are written to the file before the index which refers to them
+    QFile *pFile = qobject_cast<QFile*>(pDevice);
+    if(pFile && !pFile->flush()) return false;
+
+    if(!pDevice->seek(HeaderPos + qint64(sizeof(int)))) return false;
+    ar << IndexPos;
+    pDevice->seek(EndPos);
+
+    return ar.status()==QDataStream::Ok;
+}
+
+
 
 void MainFrame::SetMenus()
 {
@@ -1991,6 +2593,7 @@ void MainFrame::SetProjectName(QString PathName)
 void MainFrame::SetSaveState(bool bSaved)
 {
     m_bSaved = bSaved;
+    if(!bSaved) m_SaveRevision++;
 
     int len = m_ProjectName.length();
     if(m_ProjectName.right(1)=="*") m_ProjectName = m_ProjectName.left(len-1);
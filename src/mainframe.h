@@ -22,6 +22,14 @@
 #include <QStatusBar>
 #include <QList>
 #include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+#include <QFile>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+#include <thread>
 
 #include "view/twodwidget.h"
 #include "params.h"
@@ -38,6 +46,53 @@ class BoatPolar;
 class BoatOpp;
 class glSail7View;
 
+
+// the positions of the objects in a project file, listed in the index which follows them
+struct ProjectIndex
+{
+    QVector<qint64> Boats, BoatPolars, BoatOpps, BoatOppResults;
+};
+
+
+// an object serialized in memory, or the position at which it is already stored in the project file
+struct ProjectSection
+{
+    void const *pObject;
+    qint64 Pos;            // -1 if Data is to be written
+    QByteArray Data;
+};
+
+
+// the panel results of an operating point, copied, or read from their project file when they have not been loaded
+struct ResultSection
+{
+    void const *pObject;
+    quint64 Serial;           // the BoatOpp::m_Serial of the point
+    qint64 Pos;               // the position of the results in the project file, or -1 if they are to be written
+    int nPanels;
+    QVector<double> Values;   // Cp, Gamma and Sigma, or empty if the results are read from SourceFile
+    QString SourceFile;       // the file from which the point reads its results, if any
+    qint64 SourcePos;
+};
+
+
+// the state of the project, taken in the GUI thread and written by MainFrame::WriteProjectSnapshot()
+struct ProjectSnapshot
+{
+    QString PathName;         // the project file
+    bool bAppend;             // true if the changes are appended to the project file, false if it is written anew
+    int SaveRevision;         // the value of MainFrame::m_SaveRevision when the snapshot was taken
+    int Units[6];
+    QVector<ProjectSection> Boats, BoatPolars, BoatOpps;
+    QVector<ResultSection> Results;
+
+    ProjectIndex Index;       // the positions at which the objects have been written
+    int nWrittenResults;      // the number of result blocks written to the file
+    bool bWritten;
+    std::atomic<bool> bDone;  // set by the save thread once the snapshot has been written
+};
+
+
 class MainFrame : public QMainWindow
 {
     friend class TwoDWidget;
@@ -58,6 +113,10 @@ class MainFrame : public QMainWindow
 
     public:
         MainFrame(QWidget *parent = nullptr, Qt::WindowFlags flags = nullptr);
+        ~MainFrame();
+
+        bool AllocateSolverArrays(int nPanels, int nNodes);
+        bool AllocateMatrix(int nPanels, bool bSingleLU=false);
 
         bool LoadFile(QString PathName);
         void ClientToGL(QPoint const &point, Vector3d &real);
@@ -80,7 +139,7 @@ class MainFrame : public QMainWindow
 
         void UpdateView();
 
-        bool SaveProject(QString PathName="");
+        bool SaveProject(QString PathName="", bool bBackground=false);
         bool LoadSettings();
         bool LoadPolarFileV3(QDataStream &ar, bool bIsStoring, int ArchiveFormat=0);
         bool SerializeProject(QDataStream &ar, bool bIsStoring);
@@ -98,6 +157,9 @@ class MainFrame : public QMainWindow
 
         static MainFrame* self();
 
+    signals:
+        void SaveFinished();
+
     public slots:
         void OnSail7();
 
@@ -119,6 +181,9 @@ class MainFrame : public QMainWindow
         void OnSelChangeBoatOpp(int i);
         void OnSelChangeBoatPolar(int i);
         void OnSaveProject();
+        void OnSaveFinished();
+        void OnAutoSave();
+        void OnAutoSaveTimer();
         void OnDisplayOptions();
         void OnUnits();
         void openRecentFile();
@@ -139,6 +204,15 @@ class MainFrame : public QMainWindow
         void CreateSail7Actions();
         void CreateSail7Toolbar();
 
+        bool EndSave(ProjectSnapshot &Snapshot);
+        void RecordSavedFile(QFile &XFile);
+        bool SnapshotSection(void const *pObject, std::function<bool(QDataStream&)> const &Serialize, bool bAppend, QVector<ProjectSection> &Sections);
+        bool TakeProjectSnapshot(ProjectSnapshot &Snapshot, QString const &PathName, bool bAppend);
+        void WaitForSave();
+        static bool SerializeProjectIndex(QDataStream &ar, ProjectIndex &Index, bool bIsStoring);
+        static bool WriteProjectFile(ProjectSnapshot &Snapshot);
+        static bool WriteProjectSnapshot(ProjectSnapshot &Snapshot, QIODevice *pDevice);
+
 
         /*___________________________________________Variables_______________________________*/
     public:
@@ -180,7 +254,7 @@ class MainFrame : public QMainWindow
         //MainFrame actions
         QAction *restoreToolbarsAct, *exportCurGraphAct, *resetCurGraphScales;
         QAction *m_pOpenAct, *m_pOpenLast, *insertAct, *styleAct;
-        QAction *saveAct, *saveProjectAsAct,*newProjectAct, *closeProjectAct;
+        QAction *saveAct, *saveProjectAsAct,*newProjectAct, *closeProjectAct, *autoSaveAct;
         QAction *unitsAct;
         QAction *languageAct;
         QAction *exitAct;
@@ -220,6 +294,21 @@ class MainFrame : public QMainWindow
 
 
         bool m_bSaved;
+        int m_SaveRevision;                     // incremented each time the project is modified
+
+        // the background save
+        std::thread m_SaveThread;
+        ProjectSnapshot *m_pSaveSnapshot;       // the snapshot being written by m_SaveThread, or nullptr
+
+        // the project file to which the next save may append the changes, and its contents
+        QString m_SavedFile;
+        QHash<void const*, ProjectSection> m_SavedSections;   // the objects stored in m_SavedFile, by object
+        int m_nFileResults;                     // the number of result blocks in m_SavedFile, including those no longer used
+        int m_nSaveAppends;                     // the number of saves appended to m_SavedFile since it was written anew
+
+        QTimer *m_pAutoSaveTimer;
+        bool m_bAutoSave;
+        int m_AutoSaveInterval;                 // minutes
         bool m_bSaveSettings;
         bool m_bReverseZoom;                    // true if the rolling forward zooms in
         //    bool m_bSaveOpps, m_bSaveWOpps;
@@ -258,21 +347,26 @@ class MainFrame : public QMainWindow
         int m_ExportFileType;
         bool m_bAlphaChannel;
 
-        double m_aij[VLMMAXMATSIZE*VLMMAXMATSIZE];    // coefficient matrix
-        double m_aijRef[VLMMAXMATSIZE*VLMMAXMATSIZE]; // coefficient matrix
-        double m_RHS[VLMMAXMATSIZE*VLMMAXRHS];            // RHS vector
-        double m_RHSRef[VLMMAXMATSIZE*VLMMAXRHS];        // RHS vector
-
-
-        Vector3d m_Node[2*VLMMAXMATSIZE];        // the node array for the currently loaded UFO
-        Vector3d m_TempWakeNode[2*VLMMAXMATSIZE];    // the temporary wake node array during relaxation calc
-        Vector3d m_MemNode[2*VLMMAXMATSIZE];         // used if the analysis should be performed on the tilted geometry
-        Vector3d m_WakeNode[2*VLMMAXMATSIZE];        // the reference current wake node array
-        Vector3d m_RefWakeNode[2*VLMMAXMATSIZE];     // the reference wake node array if wake needs to be reset
-        CPanel m_Panel[VLMMAXMATSIZE];        // the panel array for the currently loaded UFO
-        CPanel m_MemPanel[VLMMAXMATSIZE];           // used if the analysis should be performed on the tilted geometry
-        CPanel m_WakePanel[VLMMAXMATSIZE];          // the reference current wake panel array
-        CPanel m_RefWakePanel[VLMMAXMATSIZE];       // the reference wake panel array if wake needs to be reset
+        // The solver arrays are sized to the boat currently meshed, and are only grown,
+        // so that they are reused from one boat and one analysis to the next
+        int m_MaxPanels;                 // the number of panels the arrays can hold
+        int m_MaxNodes;                  // the number of nodes the arrays can hold
+        int m_MaxMatrixSize;             // the number of panels the influence matrices can hold ; allocated only for the direct solvers
+        bool m_bSingleLUMatrix;          // true if m_aij is sized for a single precision LU decomposition
+
+        double *m_aij;        // coefficient matrix
+        double *m_aijRef;     // coefficient matrix
+        double *m_RHS;        // RHS vector
+        double *m_RHSRef;     // RHS vector
+
+        Vector3d *m_Node;            // the node array for the currently loaded UFO
+        Vector3d *m_MemNode;         // used if the analysis should be performed on the tilted geometry
+        Vector3d *m_WakeNode;        // the reference current wake node array
+        Vector3d *m_RefWakeNode;     // the reference wake node array if wake needs to be reset
+        CPanel *m_Panel;             // the panel array for the currently loaded UFO
+        CPanel *m_MemPanel;          // used if the analysis should be performed on the tilted geometry
+        CPanel *m_WakePanel;         // the reference current wake panel array
+        CPanel *m_RefWakePanel;      // the reference wake panel array if wake needs to be reset
 
 };
 
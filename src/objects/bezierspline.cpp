@@ -88,7 +88,7 @@ double BezierSpline::Bernstein(int const &i, int const &n, double const &u)
 
 double BezierSpline::BezierBlend(int const &k, int const &n, double const&u)
 {
-    static int nn,kn,nkn;
+    int nn,kn,nkn;
     double blend=1.0;
 
     nn = n;
@@ -137,8 +137,8 @@ void BezierSpline::Duplicate(Spline *pSpline)
 
 double BezierSpline::GetY(double const &x)
 {
-    static int i;
-    static double y;
+    int i;
+    double y;
 
     if(x<=0.0 || x>=1.0) return 0.0;
 
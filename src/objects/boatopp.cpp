@@ -12,11 +12,18 @@
 #include "../mainframe.h"
 #include "../sail7/sail7.h"
 #include "boatopp.h"
+#include "panelresultpool.h"
 #include <QtDebug>
+#include <QByteArray>
+#include <string.h>
+#include <atomic>
 
 void *BoatOpp::s_pMainFrame = nullptr;
 void *BoatOpp::s_pSail7 = nullptr;
 
+// the points are built by the analysis thread as well as by the GUI thread
+static std::atomic<quint64> s_nBoatOpps(0);
+
 
 BoatOpp::BoatOpp()
 {
@@ -46,9 +53,35 @@ BoatOpp::BoatOpp()
 
     for(int is=0;is<MAXSAILS; is++) m_SailAngle[is]=0.0;
 
-    memset(m_Cp,0,sizeof(m_Cp));
-    memset(m_G,0,sizeof(m_G));
-    memset(m_Sigma,0,sizeof(m_Sigma));
+    m_Cp = m_G = m_Sigma = nullptr;
+    m_ResultPos = 0;
+    m_Serial = ++s_nBoatOpps;
+}
+
+
+BoatOpp::~BoatOpp()
+{
+    UnloadResults();
+}
+
+
+bool BoatOpp::AllocateResults(int nPanels)
+{
+    // sizes the per-panel results for nPanels panels, and sets them to zero
+    // returns false if there is not enough memory, in which case the point holds no panel
+    UnloadResults();
+    m_NVLMPanels = 0;
+
+    if(nPanels<=0) return nPanels==0;
+
+    m_Cp = PanelResultPool::Allocate(3*nPanels);
+    if(!m_Cp) return false;
+
+    m_NVLMPanels = nPanels;
+    m_G     = m_Cp + nPanels;
+    m_Sigma = m_G  + nPanels;
+    memset(m_Cp, 0, 3*ulong(nPanels)*sizeof(double));
+    return true;
 }
 
 
@@ -63,7 +96,8 @@ bool BoatOpp::SerializeBoatOpp(QDataStream &ar, bool bIsStoring)
 
     if(bIsStoring)
     {
-        ar << 100002;
+        ar << 100003;
+        //100003 : the panel results are stored apart, by SerializePanelResults()
         //100002 : added lift and drag
         //100001 : first file format
 
@@ -92,9 +126,6 @@ bool BoatOpp::SerializeBoatOpp(QDataStream &ar, bool bIsStoring)
         ar << M.x << M.y << M.z;
 
         ar << m_NVLMPanels;
-        for (p=0; p<m_NVLMPanels;p++)    ar << (float)m_Cp[p] ;
-        for (p=0; p<m_NVLMPanels;p++)    ar << (float)m_G[p] ;
-        for (p=0; p<m_NVLMPanels;p++)    ar << (float)m_Sigma[p] ;
 
         //provision
         {
@@ -138,21 +169,31 @@ bool BoatOpp::SerializeBoatOpp(QDataStream &ar, bool bIsStoring)
         ar >> M.x >> M.y >> M.z;
 
 
-        ar>> m_NVLMPanels;
-        for (p=0; p<m_NVLMPanels;p++)
+        ar>> a;
+        if(a<0) return false;
+        if(ArchiveFormat>=100003)
         {
-            ar >> f; m_Cp[p] =f;
-
+            // the results are read later, from the position set by SetResultSource()
+            UnloadResults();
+            m_NVLMPanels = a;
         }
-
-        for (p=0; p<m_NVLMPanels;p++)
-        {
-            ar >> f; m_G[p] =f;
-        }
-
-        for (p=0; p<m_NVLMPanels;p++)
+        else
         {
-            ar >> f; m_Sigma[p] = f;
+            if(!AllocateResults(a)) return false;
+            for (p=0; p<m_NVLMPanels;p++)
+            {
+                ar >> f; m_Cp[p] =f;
+            }
+
+            for (p=0; p<m_NVLMPanels;p++)
+            {
+                ar >> f; m_G[p] =f;
+            }
+
+            for (p=0; p<m_NVLMPanels;p++)
+            {
+                ar >> f; m_Sigma[p] = f;
+            }
         }
 
 
@@ -166,6 +207,202 @@ bool BoatOpp::SerializeBoatOpp(QDataStream &ar, bool bIsStoring)
 
 
 
+static void EncodePanelArray(QDataStream &ar, double const *Values, int n)
+{
+    // Writes one array of panel results.
+    // Arrays with only zeros, such as the source strengths of thin sails, are stored as a single flag.
+    // Otherwise the float bit patterns are delta coded from one panel to the next, which leaves
+    // small integers along the strips, and the bytes are regrouped by significance before compression.
+    // The coding is lossless with respect to the float values written by the former format.
+    int p, b;
+    bool bZero = true;
+    for(p=0; p<n; p++)
+    {
+        if(Values[p]!=0.0) { bZero = false; break; }
+    }
+    if(bZero)
+    {
+        ar << 0;
+        return;
+    }
+
+    QByteArray Planes(4*n, 0);
+    char *pPlane = Planes.data();
+    quint32 Bits, Previous=0, Delta;
+    float f;
+    for(p=0; p<n; p++)
+    {
+        f = (float)Values[p];
+        memcpy(&Bits, &f, sizeof(quint32));
+        Delta = Bits - Previous;
+        Previous = Bits;
+        for(b=0; b<4; b++) pPlane[b*n+p] = (char)((Delta>>(8*b)) & 0xFF);
+    }
+
+    QByteArray Packed = qCompress(Planes);
+    if(Packed.size()<Planes.size())
+    {
+        ar << 2;
+        ar << Packed;
+    }
+    else
+    {
+        ar << 1;
+        ar << Planes;
+    }
+}
+
+
+static bool DecodePanelArray(QDataStream &ar, double *Values, int n)
+{
+    // Reads one array of panel results written by EncodePanelArray()
+    int p, b, Coding;
+    QByteArray Planes;
+
+    ar >> Coding;
+    if(Coding==0)
+    {
+        memset(Values, 0, size_t(n)*sizeof(double));
+        return true;
+    }
+    else if(Coding==1)
+    {
+        ar >> Planes;
+    }
+    else if(Coding==2)
+    {
+        QByteArray Packed;
+        ar >> Packed;
+        Planes = qUncompress(Packed);
+    }
+    else return false;
+
+    if(Planes.size()!=4*n) return false;
+
+    unsigned char const *pPlane = (unsigned char const*)Planes.constData();
+    quint32 Bits=0, Delta;
+    float f;
+    for(p=0; p<n; p++)
+    {
+        Delta = 0;
+        for(b=0; b<4; b++) Delta |= quint32(pPlane[b*n+p])<<(8*b);
+        Bits += Delta;
+        memcpy(&f, &Bits, sizeof(float));
+        Values[p] = f;
+    }
+    return true;
+}
+
+
+bool BoatOpp::SerializePanelResults(QDataStream &ar, bool bIsStoring)
+{
+    // the per-panel results, stored after the points' headers in the project file
+    int n;
+
+    if(bIsStoring)
+    {
+        WritePanelResults(ar, m_Cp, m_NVLMPanels);
+    }
+    else
+    {
+        n = m_NVLMPanels;
+        if(!AllocateResults(n))
+        {
+            m_NVLMPanels = n;
+            return false;
+        }
+        if(!ReadPanelResults(ar, m_Cp, m_NVLMPanels))
+        {
+            UnloadResults();
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void BoatOpp::WritePanelResults(QDataStream &ar, double const *Results, int nPanels)
+{
+    // writes the block of 3 x nPanels results, Cp then Gamma then Sigma
+    // static, so that the results may be written by the background save from a copy of the arrays
+    ar << 100002;
+    //100002 : zero arrays skipped, delta coded and compressed arrays
+    //100001 : first file format
+
+    ar << nPanels;
+    EncodePanelArray(ar, Results,           nPanels);
+    EncodePanelArray(ar, Results+nPanels,   nPanels);
+    EncodePanelArray(ar, Results+2*nPanels, nPanels);
+}
+
+
+bool BoatOpp::ReadPanelResults(QDataStream &ar, double *Results, int nPanels)
+{
+    // reads a block written by WritePanelResults() into the array of 3 x nPanels results
+    int ArchiveFormat, n, p;
+    float f;
+
+    ar >> ArchiveFormat;
+    if(ArchiveFormat<100000 || ArchiveFormat>120000) return false;
+
+    ar >> n;
+    if(n!=nPanels) return false;
+
+    if(ArchiveFormat>=100002)
+    {
+        for(int k=0; k<3; k++)
+        {
+            if(!DecodePanelArray(ar, Results+k*nPanels, nPanels)) return false;
+        }
+    }
+    else
+    {
+        for (p=0; p<3*nPanels;p++)
+        {
+            ar >> f; Results[p] =f;
+        }
+    }
+    return ar.status()==QDataStream::Ok;
+}
+
+
+bool BoatOpp::LoadResults()
+{
+    // reads the panel results from the project file if they have not been loaded yet
+    // returns false if the file cannot be read, in which case the point has no results to display
+    if(ResultsLoaded()) return true;
+    if(!m_ResultFile.length()) return false;
+
+    QFile XFile(m_ResultFile);
+    if (!XFile.open(QIODevice::ReadOnly) || !XFile.seek(m_ResultPos)) return false;
+
+    QDataStream ar(&XFile);
+#if QT_VERSION >= 0x040500
+    ar.setVersion(QDataStream::Qt_4_5);
+#endif
+    ar.setByteOrder(QDataStream::LittleEndian);
+
+    return SerializePanelResults(ar, false);
+}
+
+
+void BoatOpp::UnloadResults()
+{
+    // releases the panel results, which may be read again from the result source
+    PanelResultPool::Release(m_Cp, 3*m_NVLMPanels);
+    m_Cp = m_G = m_Sigma = nullptr;
+}
+
+
+void BoatOpp::SetResultSource(QString const &FileName, qint64 Pos)
+{
+    // sets the project file and the position from which LoadResults() reads the panel results
+    m_ResultFile = FileName;
+    m_ResultPos  = Pos;
+}
+
+
+
 void BoatOpp::GetBoatOppProperties(QString &BOppProperties)
 {
     MainFrame *pMainFrame = (MainFrame*)s_pMainFrame;
@@ -16,6 +16,7 @@
 
 #include <QString>
 #include <QColor>
+#include <QMetaType>
 
 
 
@@ -24,10 +25,23 @@ class BoatOpp
     friend class MainFrame;
     friend class Sail7;
     friend class BoatPolar;
+    friend class BoatAnalysisDlg;
 
     public:
         BoatOpp();
+        ~BoatOpp();
+        // the results are a block of the shared pool, owned by a single point
+        BoatOpp(BoatOpp const &) = delete;
+        BoatOpp &operator=(BoatOpp const &) = delete;
+        bool AllocateResults(int nPanels);
         bool SerializeBoatOpp(QDataStream &ar, bool bIsStoring);
+        bool SerializePanelResults(QDataStream &ar, bool bIsStoring);
+        static void WritePanelResults(QDataStream &ar, double const *Results, int nPanels);
+        static bool ReadPanelResults(QDataStream &ar, double *Results, int nPanels);
+        bool LoadResults();
+        void UnloadResults();
+        void SetResultSource(QString const &FileName, qint64 Pos);
+        bool ResultsLoaded() const {return m_NVLMPanels==0 || m_Cp;}
         void GetBoatOppProperties(QString &BOppProperties);
 
         void GetLiftDrag(double &Lift, double &Drag, Vector3d &WindDirection, Vector3d &WindNormal, Vector3d &WindSide);
@@ -66,9 +80,15 @@ class BoatOpp
         int m_NStation;        // number of stations along wing span
 
         double m_QInf;
-        double m_Cp[VLMMAXMATSIZE];        // lift coeffs for each panel
-        double m_G[VLMMAXMATSIZE];            // vortice or doublet strengths
-        double m_Sigma[VLMMAXMATSIZE];        // source strengths
+        // the per-panel results, sized to m_NVLMPanels in a single block of the PanelResultPool
+        double *m_Cp;        // lift coeffs for each panel
+        double *m_G;            // vortice or doublet strengths
+        double *m_Sigma;        // source strengths
+
+        // if the results are not loaded, they are read on demand from this project file
+        QString m_ResultFile;
+        qint64 m_ResultPos;
+        quint64 m_Serial;    // unique to the point, so that a save does not mistake it for a deleted point at the same address
 
         double m_Beta;//heading angle, degerees
         double m_Phi;//bank angle, degrees
@@ -83,4 +103,6 @@ class BoatOpp
 
 };
 
+Q_DECLARE_METATYPE(BoatOpp*)
+
 #endif // BOATOPP_H
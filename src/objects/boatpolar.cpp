@@ -29,6 +29,13 @@ BoatPolar::BoatPolar()
     m_bIsVisible  = true;
     m_bShowPoints = false;
     m_bWakeRollUp = false;
+    m_bIterativeSolver = false;
+    m_SolverTolerance  = 1.e-6;
+    m_bMatrixFree      = false;
+    m_TreeAccuracy     = 0.3;
+    m_bHMatrix         = false;
+    m_HMatrixAccuracy  = 1.e-4;
+    m_bMixedPrecision  = false;
 
     m_NXWakePanels = 1;
     m_WakePanelFactor = 1.1;
@@ -70,6 +77,13 @@ void BoatPolar::DuplicateSpec(BoatPolar const*pBoatPolar)
     m_bGround         = pBoatPolar->m_bGround;
     m_bDirichlet      = pBoatPolar->m_bDirichlet;
     m_bWakeRollUp     = pBoatPolar->m_bWakeRollUp;
+    m_bIterativeSolver = pBoatPolar->m_bIterativeSolver;
+    m_SolverTolerance  = pBoatPolar->m_SolverTolerance;
+    m_bMatrixFree      = pBoatPolar->m_bMatrixFree;
+    m_TreeAccuracy     = pBoatPolar->m_TreeAccuracy;
+    m_bHMatrix         = pBoatPolar->m_bHMatrix;
+    m_HMatrixAccuracy  = pBoatPolar->m_HMatrixAccuracy;
+    m_bMixedPrecision  = pBoatPolar->m_bMixedPrecision;
 
     m_NXWakePanels    = pBoatPolar->m_NXWakePanels;
     m_WakePanelFactor = pBoatPolar->m_WakePanelFactor;
@@ -178,7 +192,11 @@ bool BoatPolar::SerializeBoatPlr(QDataStream &ar, bool bIsStoring)
     Sail7 *pSail7 = (Sail7*)s_pSail7;
     Boat *pBoat = pSail7->GetBoat(m_BoatName);
 
-    int PolarFormat = 100391;
+    int PolarFormat = 100395;
+    // 100395 : added mixed precision direct solver
+    // 100394 : added hierarchical matrix and its accuracy
+    // 100393 : added matrix-free solver and tree accuracy
+    // 100392 : added linear solver type and tolerance
     // 100391 : added Lift and Drag
     // 100390 : added wind gradient
     // 100389 : v0.00
@@ -215,6 +233,14 @@ bool BoatPolar::SerializeBoatPlr(QDataStream &ar, bool bIsStoring)
             ar << m_SailAngleMin[is] << m_SailAngleMax[is];
         }
 
+        if (m_bIterativeSolver) ar << 1; else ar << 0;
+        ar << m_SolverTolerance;
+        if (m_bMatrixFree) ar << 1; else ar << 0;
+        ar << m_TreeAccuracy;
+        if (m_bHMatrix) ar << 1; else ar << 0;
+        ar << m_HMatrixAccuracy;
+        if (m_bMixedPrecision) ar << 1; else ar << 0;
+
         ar <<m_Ctrl.size();
         for (i=0; i<m_Ctrl.size(); i++)
         {
@@ -290,6 +316,37 @@ bool BoatPolar::SerializeBoatPlr(QDataStream &ar, bool bIsStoring)
             ar >> m_SailAngleMin[is] >> m_SailAngleMax[is];
         }
 
+        if(PolarFormat>=100392)
+        {
+            ar >> n;
+            if (n!=0 && n!=1) return false;
+            if(n) m_bIterativeSolver =true; else m_bIterativeSolver = false;
+            ar >> m_SolverTolerance;
+        }
+
+        if(PolarFormat>=100393)
+        {
+            ar >> n;
+            if (n!=0 && n!=1) return false;
+            if(n) m_bMatrixFree =true; else m_bMatrixFree = false;
+            ar >> m_TreeAccuracy;
+        }
+
+        if(PolarFormat>=100394)
+        {
+            ar >> n;
+            if (n!=0 && n!=1) return false;
+            if(n) m_bHMatrix =true; else m_bHMatrix = false;
+            ar >> m_HMatrixAccuracy;
+        }
+
+        if(PolarFormat>=100395)
+        {
+            ar >> n;
+            if (n!=0 && n!=1) return false;
+            if(n) m_bMixedPrecision =true; else m_bMixedPrecision = false;
+        }
+
         ar >> n;
         for (i=0; i<n; i++)
         {
@@ -482,6 +539,26 @@ void BoatPolar::GetPolarProperties(QString &PolarProperties, int FileType, bool
         strong = QObject::tr("Ground effect");
         PolarProperties += strong +"\n";
     }
+    if(m_bIterativeSolver)
+    {
+        strong = QString(QObject::tr("GMRES solver, tolerance = %1")).arg(m_SolverTolerance, 0, 'g', 2);
+        PolarProperties += strong +"\n";
+        if(m_bMatrixFree)
+        {
+            strong = QString(QObject::tr("Matrix-free, tree accuracy = %1")).arg(m_TreeAccuracy, 0, 'f', 2);
+            PolarProperties += strong +"\n";
+        }
+        else if(m_bHMatrix)
+        {
+            strong = QString(QObject::tr("Hierarchical matrix, accuracy = %1")).arg(m_HMatrixAccuracy, 0, 'g', 2);
+            PolarProperties += strong +"\n";
+        }
+    }
+    else if(m_bMixedPrecision)
+    {
+        strong = QObject::tr("Single precision LU with iterative refinement");
+        PolarProperties += strong +"\n";
+    }
     PolarProperties += "\n";
 
     PolarProperties += QObject::tr("Wind gradient")+":\n";
@@ -54,6 +54,13 @@ private:
     bool m_bDirichlet;
     bool m_bIsVisible,m_bShowPoints;
     bool m_bWakeRollUp;
+    bool m_bIterativeSolver;   // if true, the linear system is solved with GMRES rather than with a dense LU
+    double m_SolverTolerance;  // relative residual at which the GMRES iterations are stopped
+    bool m_bMatrixFree;        // if true, GMRES evaluates the panel influences with a tree instead of building the matrix
+    double m_TreeAccuracy;     // max ratio of a tree box's size to its distance for the box to be replaced by its far field
+    bool m_bHMatrix;           // if true, GMRES uses the influence matrix stored in hierarchical form
+    double m_HMatrixAccuracy;  // relative accuracy of the low rank blocks of the hierarchical matrix
+    bool m_bMixedPrecision;    // if true, the direct solver factorizes the matrix in single precision and refines the solution
 
     double m_AMem;
 
@@ -0,0 +1,419 @@
+/****************************************************************************
+
+    HMatrix Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include "hmatrix.h"
+#include "../globals.h"
+
+
+
+HMatrix::HMatrix()
+{
+    m_WorkSize = 0;
+    m_Accuracy = 1.e-4;
+}
+
+
+void HMatrix::Clear()
+{
+    m_Index.clear();
+    m_Cluster.clear();
+    m_Block.clear();
+    m_WorkSize = 0;
+}
+
+
+size_t HMatrix::StorageSize() const
+{
+    // the number of coefficients stored in the blocks
+    size_t Size = 0;
+    for(uint ib=0; ib<m_Block.size(); ib++) Size += m_Block[ib].U.size() + m_Block[ib].V.size();
+    return Size;
+}
+
+
+bool HMatrix::Build(CPanel const *pPanel, int nPanels, bool bVLM1, Vector3d const &WindDirection,
+                    std::function<double(int,int)> const &Coefficient, double Accuracy,
+                    std::function<bool(double)> const &Poll)
+{
+    //
+    // Builds the clusters and the blocks for the current geometry, then computes the blocks
+    // Coefficient(p, pp) must return the influence of panel pp at the boundary condition point of panel p,
+    // and may be called from several threads at once
+    // Returns false if the construction has been interrupted by Poll
+    //
+    int p;
+    std::vector<Vector3d> Pos(nPanels);
+    std::vector<double> Radius(nPanels);
+    std::vector<bool> bLegs(nPanels);
+
+    Clear();
+    m_Accuracy = Accuracy;
+    if(nPanels<=0) return true;
+
+    for(p=0; p<nPanels; p++)
+    {
+        CPanel const &P = pPanel[p];
+        if(P.m_Pos!=MIDSURFACE)
+        {
+            Pos[ulong(p)]    = P.CollPt;
+            Radius[ulong(p)] = P.Size;
+            bLegs[ulong(p)]  = false;
+        }
+        else
+        {
+            // the vortex of a VLM2 panel extends on the next panel downstream
+            Pos[ulong(p)]    = P.CtrlPt;
+            Radius[ulong(p)] = 2.0*P.Size;
+            bLegs[ulong(p)]  = bVLM1 || P.m_bIsTrailing;
+        }
+        m_Index.push_back(p);
+    }
+
+    m_Cluster.reserve(ulong(2*nPanels/HMATRIXLEAFSIZE+2));
+    BuildCluster(0, nPanels, Pos, Radius, bLegs);
+    BuildBlocks(0, 0, WindDirection);
+
+    m_WorkSize = 0;
+    for(uint ib=0; ib<m_Block.size(); ib++)
+    {
+        m_Block[ib].WorkOffset = m_WorkSize;
+        m_WorkSize += size_t(m_Block[ib].nRows);
+    }
+
+    // the largest blocks first, for a better balance between the threads
+    std::vector<int> Order(m_Block.size());
+    for(uint ib=0; ib<m_Block.size(); ib++) Order[ib] = int(ib);
+    std::sort(Order.begin(), Order.end(), [this](int a, int b)
+    {
+        return double(m_Block[ulong(a)].nRows)*m_Block[ulong(a)].nCols > double(m_Block[ulong(b)].nRows)*m_Block[ulong(b)].nCols;
+    });
+
+    std::atomic<int> nDone(0);
+    int nBlocks = int(m_Block.size());
+    bool bDone = ParallelFor(nBlocks, [&](int ib)
+    {
+        FillBlock(m_Block[ulong(Order[ulong(ib)])], Coefficient);
+        nDone++;
+    },
+    [&]()
+    {
+        return !Poll || Poll(double(nDone)/double(nBlocks));
+    });
+
+    if(!bDone) Clear();
+    return bDone;
+}
+
+
+int HMatrix::BuildCluster(int First, int Last, std::vector<Vector3d> &Pos, std::vector<double> &Radius, std::vector<bool> &bLegs)
+{
+    //
+    // Creates the cluster holding the panels m_Index[First] to m_Index[Last-1], and its children
+    // The panels are split in two halves along the largest dimension of their bounding box
+    //
+    int i;
+    Vector3d Min, Max;
+
+    int iCluster = int(m_Cluster.size());
+    m_Cluster.push_back(Cluster());
+
+    Min = Max = Pos[ulong(m_Index[ulong(First)])];
+    for(i=First; i<Last; i++)
+    {
+        Vector3d const &P = Pos[ulong(m_Index[ulong(i)])];
+        Min.x = std::min(Min.x, P.x);    Max.x = std::max(Max.x, P.x);
+        Min.y = std::min(Min.y, P.y);    Max.y = std::max(Max.y, P.y);
+        Min.z = std::min(Min.z, P.z);    Max.z = std::max(Max.z, P.z);
+    }
+
+    Cluster C;
+    C.Center = (Min+Max)/2.0;
+    C.Radius = 0.0;
+    C.bLegs  = false;
+    C.First  = First;
+    C.Last   = Last;
+    C.Child[0] = C.Child[1] = -1;
+    for(i=First; i<Last; i++)
+    {
+        int p = m_Index[ulong(i)];
+        C.Radius = std::max(C.Radius, (Pos[ulong(p)]-C.Center).VAbs() + Radius[ulong(p)]);
+        if(bLegs[ulong(p)]) C.bLegs = true;
+    }
+
+    if(Last-First>HMATRIXLEAFSIZE)
+    {
+        int Axis = 0;
+        if(Max.y-Min.y > Max.x-Min.x) Axis = 1;
+        if(Max.z-Min.z > std::max(Max.x-Min.x, Max.y-Min.y)) Axis = 2;
+
+        int Mid = (First+Last)/2;
+        std::nth_element(m_Index.begin()+First, m_Index.begin()+Mid, m_Index.begin()+Last,
+                         [Axis, &Pos](int a, int b)
+        {
+            if(Axis==0) return Pos[ulong(a)].x<Pos[ulong(b)].x;
+            if(Axis==1) return Pos[ulong(a)].y<Pos[ulong(b)].y;
+            return Pos[ulong(a)].z<Pos[ulong(b)].z;
+        });
+
+        C.Child[0] = BuildCluster(First, Mid, Pos, Radius, bLegs);
+        C.Child[1] = BuildCluster(Mid, Last, Pos, Radius, bLegs);
+    }
+    m_Cluster[ulong(iCluster)] = C;
+    return iCluster;
+}
+
+
+bool HMatrix::IsAdmissible(Cluster const &t, Cluster const &s, Vector3d const &WindDirection) const
+{
+    //
+    // The block of rows t and columns s may be approximated at low rank if the clusters are well separated
+    // The trailing legs of the panels of s extend downstream, so the distance is measured
+    // from the half-cylinder swept by s in the wind direction
+    //
+    Vector3d r = t.Center - s.Center;
+    double Dist = r.VAbs();
+    if(s.bLegs)
+    {
+        Vector3d W = WindDirection;
+        double rw = r.dot(W);
+        if(rw>0.0)
+        {
+            r -= W*rw;
+            Dist = r.VAbs();
+        }
+    }
+    Dist -= t.Radius + s.Radius;
+    return Dist>0.0 && 2.0*std::min(t.Radius, s.Radius) <= HMATRIXETA * Dist;
+}
+
+
+void HMatrix::BuildBlocks(int t, int s, Vector3d const &WindDirection)
+{
+    // Splits the block of rows t and columns s until it is admissible or made of leaves
+    Cluster const &ct = m_Cluster[ulong(t)];
+    Cluster const &cs = m_Cluster[ulong(s)];
+
+    bool bAdmissible = IsAdmissible(ct, cs, WindDirection);
+    if(bAdmissible || (ct.Child[0]<0 && cs.Child[0]<0))
+    {
+        Block B;
+        B.Row   = ct.First;
+        B.Col   = cs.First;
+        B.nRows = ct.Last-ct.First;
+        B.nCols = cs.Last-cs.First;
+        B.Rank  = bAdmissible ? 0 : -1;
+        B.WorkOffset = 0;
+        m_Block.push_back(B);
+        return;
+    }
+
+    if(ct.Child[0]<0)
+    {
+        BuildBlocks(t, cs.Child[0], WindDirection);
+        BuildBlocks(t, cs.Child[1], WindDirection);
+    }
+    else if(cs.Child[0]<0)
+    {
+        BuildBlocks(ct.Child[0], s, WindDirection);
+        BuildBlocks(ct.Child[1], s, WindDirection);
+    }
+    else
+    {
+        for(int i=0; i<2; i++)
+            for(int j=0; j<2; j++)
+                BuildBlocks(ct.Child[i], cs.Child[j], WindDirection);
+    }
+}
+
+
+void HMatrix::FillFullBlock(Block &B, std::function<double(int,int)> const &Coefficient) const
+{
+    B.Rank = -1;
+    B.V.clear();
+    B.U.resize(size_t(B.nRows)*size_t(B.nCols));
+    for(int i=0; i<B.nRows; i++)
+    {
+        int p = m_Index[ulong(B.Row+i)];
+        double *Ui = B.U.data() + size_t(i)*size_t(B.nCols);
+        for(int j=0; j<B.nCols; j++) Ui[j] = Coefficient(p, m_Index[ulong(B.Col+j)]);
+    }
+}
+
+
+void HMatrix::FillBlock(Block &B, std::function<double(int,int)> const &Coefficient) const
+{
+    //
+    // Computes the coefficients of the block
+    // The admissible blocks are approximated by adaptive cross approximation with partial pivoting:
+    // at each step the residual of one row and of one column is computed, and their product
+    // is added to the approximation, until its contribution is less than the accuracy
+    // The blocks for which the approximation would not save memory are stored in full
+    //
+    if(B.Rank<0)
+    {
+        FillFullBlock(B, Coefficient);
+        return;
+    }
+
+    int nr = B.nRows, nc = B.nCols;
+    int MaxRank = (nr*nc)/(nr+nc);
+    int i, j, l, k=0;
+    int iRow = 0;
+    double Norm2 = 0.0;
+    std::vector<bool> bRowUsed(nr, false);
+    std::vector<double> Row(nc), Col(nr);
+
+    B.U.clear();
+    B.V.clear();
+
+    while(iRow>=0)
+    {
+        if(k>=MaxRank)
+        {
+            // not worth the approximation
+            FillFullBlock(B, Coefficient);
+            return;
+        }
+
+        // the residual of the row
+        bRowUsed[ulong(iRow)] = true;
+        int p = m_Index[ulong(B.Row+iRow)];
+        for(j=0; j<nc; j++)
+        {
+            double r = Coefficient(p, m_Index[ulong(B.Col+j)]);
+            for(l=0; l<k; l++) r -= B.U[size_t(l)*nr+iRow] * B.V[size_t(l)*nc+j];
+            Row[ulong(j)] = r;
+        }
+
+        int jPivot = 0;
+        for(j=1; j<nc; j++) if(fabs(Row[ulong(j)])>fabs(Row[ulong(jPivot)])) jPivot = j;
+
+        if(fabs(Row[ulong(jPivot)])<1.e-300)
+        {
+            // the row is already approximated, try the next one
+            iRow = -1;
+            for(i=0; i<nr; i++)
+            {
+                if(!bRowUsed[ulong(i)])
+                {
+                    iRow = i;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        // the residual of the pivot's column
+        double Pivot = Row[ulong(jPivot)];
+        for(j=0; j<nc; j++) Row[ulong(j)] /= Pivot;
+        int pp = m_Index[ulong(B.Col+jPivot)];
+        for(i=0; i<nr; i++)
+        {
+            double r = Coefficient(m_Index[ulong(B.Row+i)], pp);
+            for(l=0; l<k; l++) r -= B.U[size_t(l)*nr+i] * B.V[size_t(l)*nc+jPivot];
+            Col[ulong(i)] = r;
+        }
+
+        // update the estimate of the norm of the approximation
+        double u2 = 0.0, v2 = 0.0;
+        for(i=0; i<nr; i++) u2 += Col[ulong(i)]*Col[ulong(i)];
+        for(j=0; j<nc; j++) v2 += Row[ulong(j)]*Row[ulong(j)];
+        for(l=0; l<k; l++)
+        {
+            double uu = 0.0, vv = 0.0;
+            for(i=0; i<nr; i++) uu += Col[ulong(i)] * B.U[size_t(l)*nr+i];
+            for(j=0; j<nc; j++) vv += Row[ulong(j)] * B.V[size_t(l)*nc+j];
+            Norm2 += 2.0*uu*vv;
+        }
+        Norm2 += u2*v2;
+
+        B.U.insert(B.U.end(), Col.begin(), Col.end());
+        B.V.insert(B.V.end(), Row.begin(), Row.end());
+        k++;
+
+        if(sqrt(u2*v2) <= m_Accuracy*sqrt(fabs(Norm2))) break;
+
+        // the next row is the one with the largest residual in the last column
+        iRow = -1;
+        for(i=0; i<nr; i++)
+        {
+            if(!bRowUsed[ulong(i)] && (iRow<0 || fabs(Col[ulong(i)])>fabs(Col[ulong(iRow)]))) iRow = i;
+        }
+    }
+    B.Rank = k;
+}
+
+
+void HMatrix::Product(double const *x, double *y) const
+{
+    //
+    // y = A.x
+    // The blocks are evaluated in parallel in a work array, then added to the result
+    //
+    int n = Size();
+    std::vector<double> xs(n), ys(n, 0.0), Work(m_WorkSize);
+
+    for(int i=0; i<n; i++) xs[ulong(i)] = x[m_Index[ulong(i)]];
+
+    ParallelFor(int(m_Block.size()), [&](int ib)
+    {
+        Block const &B = m_Block[ulong(ib)];
+        double const *xb = xs.data() + B.Col;
+        double *wb = Work.data() + B.WorkOffset;
+        int i, j, l;
+
+        if(B.Rank<0)
+        {
+            for(i=0; i<B.nRows; i++)
+            {
+                double const *Ui = B.U.data() + size_t(i)*size_t(B.nCols);
+                double sum = 0.0;
+                for(j=0; j<B.nCols; j++) sum += Ui[j]*xb[j];
+                wb[i] = sum;
+            }
+        }
+        else
+        {
+            for(i=0; i<B.nRows; i++) wb[i] = 0.0;
+            for(l=0; l<B.Rank; l++)
+            {
+                double const *Vl = B.V.data() + size_t(l)*size_t(B.nCols);
+                double const *Ul = B.U.data() + size_t(l)*size_t(B.nRows);
+                double sum = 0.0;
+                for(j=0; j<B.nCols; j++) sum += Vl[j]*xb[j];
+                for(i=0; i<B.nRows; i++) wb[i] += Ul[i]*sum;
+            }
+        }
+    });
+
+    for(uint ib=0; ib<m_Block.size(); ib++)
+    {
+        Block const &B = m_Block[ib];
+        double const *wb = Work.data() + B.WorkOffset;
+        for(int i=0; i<B.nRows; i++) ys[ulong(B.Row+i)] += wb[i];
+    }
+
+    for(int i=0; i<n; i++) y[m_Index[ulong(i)]] = ys[ulong(i)];
+}
@@ -0,0 +1,87 @@
+/****************************************************************************
+
+    HMatrix Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+#ifndef HMATRIX_H
+#define HMATRIX_H
+
+#include <vector>
+#include <functional>
+#include "panel.h"
+#include "vector3d.h"
+
+
+//
+// Hierarchical storage of the influence matrix.
+//
+// The panels are sorted in a binary tree of clusters, built from their boundary condition points.
+// The matrix is split in blocks of cluster pairs. The blocks of clusters which are far enough
+// from each other are stored as products of two thin matrices U.Vt, built by adaptive cross
+// approximation from a few of their rows and columns. The other blocks are stored in full.
+// The storage and the cost of a product by a vector grow as N.log(N) instead of N².
+//
+class HMatrix
+{
+public:
+    HMatrix();
+
+    bool Build(CPanel const *pPanel, int nPanels, bool bVLM1, Vector3d const &WindDirection,
+               std::function<double(int,int)> const &Coefficient, double Accuracy,
+               std::function<bool(double)> const &Poll = nullptr);
+    void Product(double const *x, double *y) const;
+    void Clear();
+
+    int Size() const {return int(m_Index.size());}
+    size_t StorageSize() const;
+
+private:
+    struct Cluster
+    {
+        Vector3d Center;
+        double Radius;          // includes the extent of the panels
+        bool bLegs;             // true if the cluster holds panels with trailing legs
+        int First, Last;        // the range of the cluster's panels in m_Index
+        int Child[2];           // -1 if the cluster is a leaf
+    };
+
+    struct Block
+    {
+        int Row, Col;           // the first row and the first column, in the sorted order
+        int nRows, nCols;
+        int Rank;               // -1 if the block is stored in full
+        std::vector<double> U, V; // U holds the full block, row by row, if Rank<0
+        size_t WorkOffset;      // the position of the block's result in the work array of Product()
+    };
+
+    int BuildCluster(int First, int Last, std::vector<Vector3d> &Pos, std::vector<double> &Radius, std::vector<bool> &bLegs);
+    void BuildBlocks(int t, int s, Vector3d const &WindDirection);
+    bool IsAdmissible(Cluster const &t, Cluster const &s, Vector3d const &WindDirection) const;
+    void FillBlock(Block &B, std::function<double(int,int)> const &Coefficient) const;
+    void FillFullBlock(Block &B, std::function<double(int,int)> const &Coefficient) const;
+
+    std::vector<int> m_Index;       // the panel index at each position of the sorted order
+    std::vector<Cluster> m_Cluster;
+    std::vector<Block> m_Block;
+    size_t m_WorkSize;
+    double m_Accuracy;              // relative accuracy of the cross approximations
+};
+
+#endif // HMATRIX_H
@@ -0,0 +1,437 @@
+/****************************************************************************
+
+    Kernel benchmark
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+//
+// Compares the batch kernels of the influence matrix with the per-panel functions they replace,
+// on the panels of a sail and of a hull of typical sizes.
+// For each kernel, prints the time per influence in ns, and the largest difference of the results.
+//
+
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "../../globals.h"
+#include "../../params.h"
+#include "../panel.h"
+#include "../vortexbatch.h"
+#include "../panelbatch.h"
+
+
+#define SAILCHORDPANELS   20
+#define SAILSPANPANELS    40
+#define HULLLENGTHPANELS  60
+#define HULLGIRTHPANELS   24
+#define REPEAT            10      // the repetitions of the kernels' loops
+#define ROWREPEAT         2       // the repetitions of the rows of the matrix
+#define CORESIZE          0.0001  // the default core size of the panels
+
+static std::vector<Vector3d> s_Node;
+static std::vector<CPanel> s_Panel;  // the sail's thin panels, then the hull's thick panels
+static int s_nThin = 0;
+
+
+static void MakePanel(int iLA, int iLB, int iTA, int iTB, enumPanelPosition Pos)
+{
+    CPanel Panel;
+    Panel.m_iLA = iLA;
+    Panel.m_iLB = iLB;
+    Panel.m_iTA = iTA;
+    Panel.m_iTB = iTB;
+    Panel.m_Pos = Pos;
+    Panel.SetFrame(s_Node[ulong(iLA)], s_Node[ulong(iLB)], s_Node[ulong(iTA)], s_Node[ulong(iTB)]);
+    s_Panel.push_back(Panel);
+}
+
+
+static void MakeMesh()
+{
+    // a cambered sail, 2m chord and 8m span, above a half-cylinder hull, 8m long and 1.6m wide
+    int i, j, n0;
+
+    for(j=0; j<=SAILSPANPANELS; j++)
+    {
+        for(i=0; i<=SAILCHORDPANELS; i++)
+        {
+            double x = 2.0*double(i)/double(SAILCHORDPANELS);
+            s_Node.push_back(Vector3d(x, 0.15*sin(PI*x/2.0), 0.5+8.0*double(j)/double(SAILSPANPANELS)));
+        }
+    }
+    for(j=0; j<SAILSPANPANELS; j++)
+    {
+        for(i=0; i<SAILCHORDPANELS; i++)
+        {
+            n0 = j*(SAILCHORDPANELS+1) + i;
+            MakePanel(n0, n0+SAILCHORDPANELS+1, n0+1, n0+SAILCHORDPANELS+2, MIDSURFACE);
+        }
+    }
+    s_nThin = int(s_Panel.size());
+
+    n0 = int(s_Node.size());
+    for(j=0; j<=HULLGIRTHPANELS; j++)
+    {
+        double t = PI*double(j)/double(HULLGIRTHPANELS);
+        for(i=0; i<=HULLLENGTHPANELS; i++)
+        {
+            s_Node.push_back(Vector3d(-3.0+8.0*double(i)/double(HULLLENGTHPANELS), 0.8*cos(t), -0.6*sin(t)));
+        }
+    }
+    for(j=0; j<HULLGIRTHPANELS; j++)
+    {
+        for(i=0; i<HULLLENGTHPANELS; i++)
+        {
+            int n = n0 + j*(HULLLENGTHPANELS+1) + i;
+            MakePanel(n, n+HULLLENGTHPANELS+1, n+1, n+HULLLENGTHPANELS+2, BODYSURFACE);
+        }
+    }
+}
+
+
+static double Elapsed(std::chrono::steady_clock::time_point const &Start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+}
+
+
+static double Difference(Vector3d const &V, double const *Vx, double const *Vy, double const *Vz, int nSegments)
+{
+    // the difference between V and the sum of the nSegments velocities
+    double x=0.0, y=0.0, z=0.0;
+    for(int k=0; k<nSegments; k++)
+    {
+        x += Vx[k];
+        y += Vy[k];
+        z += Vz[k];
+    }
+    return fabs(x-V.x) + fabs(y-V.y) + fabs(z-V.z);
+}
+
+
+static void PrintHeader(char const *Title, char const *Reference, char const *Batch)
+{
+    printf("%-34s %11s %11s %9s %11s\n", Title, Reference, Batch, "speed-up", "difference");
+}
+
+
+static void Print(char const *Name, double tReference, double tBatch, double nInfluences, double Difference)
+{
+    printf("  %-32s %11.1f %11.1f %9.2f %11.2g\n", Name, tReference/nInfluences, tBatch/nInfluences, tReference/tBatch, Difference);
+}
+
+
+static void BenchVortices()
+{
+    // the velocities induced by the sail's vortex rings (VLM2) and horseshoes (VLM1)
+    // at the collocation points of all the panels
+    int p, pp;
+    Vector3d V;
+    Vector3d Wind(1.0, 0.0, 0.0);
+    VortexBatch Rings, Horseshoes;
+
+    for(pp=0; pp<s_nThin; pp++)
+    {
+        CPanel const &Panel = s_Panel[ulong(pp)];
+        Rings.AddRing(s_Node[ulong(Panel.m_iLA)], s_Node[ulong(Panel.m_iLB)], s_Node[ulong(Panel.m_iTA)], s_Node[ulong(Panel.m_iTB)]);
+        Horseshoes.AddHorseshoe(Panel.VA, Panel.VB, Wind);
+    }
+
+    std::vector<double> Vx(ulong(Rings.Size())), Vy(Vx.size()), Vz(Vx.size());
+    double DiffRing = 0.0, DiffHorseshoe = 0.0, Sum = 0.0;
+    double tRing = 0.0, tRingBatch = 0.0, tHorseshoe = 0.0, tHorseshoeBatch = 0.0;
+    double nInfluences = double(REPEAT) * double(s_Panel.size()) * double(s_nThin);
+
+    for(int r=0; r<REPEAT; r++)
+    {
+        for(p=0; p<int(s_Panel.size()); p++)
+        {
+            Vector3d const &C = s_Panel[ulong(p)].CollPt;
+
+            auto Start = std::chrono::steady_clock::now();
+            for(pp=0; pp<s_nThin; pp++)
+            {
+                CPanel const &Panel = s_Panel[ulong(pp)];
+                VLMQmn(s_Node[ulong(Panel.m_iLA)], s_Node[ulong(Panel.m_iLB)], s_Node[ulong(Panel.m_iTA)], s_Node[ulong(Panel.m_iTB)], C, V, CORESIZE);
+                Sum += V.x;
+            }
+            tRing += Elapsed(Start);
+
+            Start = std::chrono::steady_clock::now();
+            Rings.Velocities(C, 0, Rings.Size(), CORESIZE, Vx.data(), Vy.data(), Vz.data());
+            tRingBatch += Elapsed(Start);
+
+            Start = std::chrono::steady_clock::now();
+            for(pp=0; pp<s_nThin; pp++)
+            {
+                VLMCmn(s_Panel[ulong(pp)].VA, s_Panel[ulong(pp)].VB, Wind, C, V, true, CORESIZE);
+                Sum += V.x;
+            }
+            tHorseshoe += Elapsed(Start);
+
+            if(r==0)
+            {
+                for(pp=0; pp<s_nThin; pp++)
+                {
+                    CPanel const &Panel = s_Panel[ulong(pp)];
+                    VLMQmn(s_Node[ulong(Panel.m_iLA)], s_Node[ulong(Panel.m_iLB)], s_Node[ulong(Panel.m_iTA)], s_Node[ulong(Panel.m_iTB)], C, V, CORESIZE);
+                    DiffRing = qMax(DiffRing, Difference(V, Vx.data()+4*pp, Vy.data()+4*pp, Vz.data()+4*pp, 4));
+                }
+            }
+
+            Start = std::chrono::steady_clock::now();
+            Horseshoes.Velocities(C, 0, Horseshoes.Size(), CORESIZE, Vx.data(), Vy.data(), Vz.data());
+            tHorseshoeBatch += Elapsed(Start);
+
+            if(r==0)
+            {
+                for(pp=0; pp<s_nThin; pp++)
+                {
+                    VLMCmn(s_Panel[ulong(pp)].VA, s_Panel[ulong(pp)].VB, Wind, C, V, true, CORESIZE);
+                    DiffHorseshoe = qMax(DiffHorseshoe, Difference(V, Vx.data()+3*pp, Vy.data()+3*pp, Vz.data()+3*pp, 3));
+                }
+            }
+            Sum += Vx[0];
+        }
+    }
+
+    PrintHeader("Vortices, ns per panel", "scalar", "batch");
+    Print("VLMQmn / VortexBatch rings", tRing, tRingBatch, nInfluences, DiffRing);
+    Print("VLMCmn / VortexBatch horseshoes", tHorseshoe, tHorseshoeBatch, nInfluences, DiffHorseshoe);
+    printf("  checksum %g\n\n", Sum);
+}
+
+
+static void BenchPanels()
+{
+    // the doublet and source influences of the hull's panels at the collocation points of all the panels
+    int p, pp, k;
+    Vector3d V;
+    double phi;
+    int nThick = int(s_Panel.size()) - s_nThin;
+    PanelBatch Batch;
+
+    for(pp=s_nThin; pp<int(s_Panel.size()); pp++) Batch.AddPanel(s_Panel[ulong(pp)], s_Node.data());
+
+    std::vector<double> Vx(ulong(nThick), 0.0), Vy(Vx.size()), Vz(Vx.size()), Phi(Vx.size());
+    double Diff[2] = {0.0, 0.0}, Sum = 0.0;
+    double t[2] = {0.0, 0.0}, tBatch[2] = {0.0, 0.0};
+    double nInfluences = double(REPEAT) * double(s_Panel.size()) * double(nThick);
+
+    for(int r=0; r<REPEAT; r++)
+    {
+        for(p=0; p<int(s_Panel.size()); p++)
+        {
+            Vector3d const &C = s_Panel[ulong(p)].CollPt;
+            for(int iSource=0; iSource<2; iSource++)
+            {
+                auto Start = std::chrono::steady_clock::now();
+                for(pp=s_nThin; pp<int(s_Panel.size()); pp++)
+                {
+                    if(iSource) s_Panel[ulong(pp)].SourceNASA4023(C, V, phi, s_Node.data());
+                    else        s_Panel[ulong(pp)].DoubletNASA4023(C, V, phi, false, s_Node.data());
+                    Sum += phi;
+                }
+                t[iSource] += Elapsed(Start);
+
+                Start = std::chrono::steady_clock::now();
+                if(iSource) Batch.Sources(C, 0, nThick, Vx.data(), Vy.data(), Vz.data(), Phi.data());
+                else        Batch.Doublets(C, 0, nThick, Vx.data(), Vy.data(), Vz.data(), Phi.data());
+                tBatch[iSource] += Elapsed(Start);
+                Sum += Phi[0];
+
+                if(r==0)
+                {
+                    for(k=0; k<nThick; k++)
+                    {
+                        pp = s_nThin + k;
+                        if(iSource) s_Panel[ulong(pp)].SourceNASA4023(C, V, phi, s_Node.data());
+                        else        s_Panel[ulong(pp)].DoubletNASA4023(C, V, phi, false, s_Node.data());
+                        Diff[iSource] = qMax(Diff[iSource], Difference(V, Vx.data()+k, Vy.data()+k, Vz.data()+k, 1) + fabs(phi-Phi[ulong(k)]));
+                    }
+                }
+            }
+        }
+    }
+
+    PrintHeader("Thick panels, ns per panel", "scalar", "batch");
+    Print("DoubletNASA4023 / Doublets", t[0], tBatch[0], nInfluences, Diff[0]);
+    Print("SourceNASA4023 / Sources", t[1], tBatch[1], nInfluences, Diff[1]);
+    printf("  checksum %g\n\n", Sum);
+}
+
+
+//
+// The influence of a panel for the options of a polar, written as in BoatAnalysisDlg::GetDoubletInfluence(),
+// once with the options tested for each panel, and once with the options and the panel type fixed at compile time.
+// The wake of the trailing panels is left out in both cases.
+//
+struct PolarOptions
+{
+    bool bGround, bVLM1;
+    double Height;
+};
+
+
+static void ThinInfluence(bool bVLM1, CPanel const &Panel, Vector3d const &C, Vector3d &V)
+{
+    static Vector3d const Wind(1.0, 0.0, 0.0);
+    if(bVLM1) VLMCmn(Panel.VA, Panel.VB, Wind, C, V, true, CORESIZE);
+    else      VLMQmn(s_Node[ulong(Panel.m_iLA)], s_Node[ulong(Panel.m_iLB)], s_Node[ulong(Panel.m_iTA)], s_Node[ulong(Panel.m_iTB)], C, V, CORESIZE);
+}
+
+
+static void GenericInfluence(PolarOptions const &Polar, CPanel const &Panel, Vector3d const &C, Vector3d &V, double &phi)
+{
+    Vector3d VG, CG;
+    double phiG;
+
+    if(Panel.m_Pos!=MIDSURFACE) Panel.DoubletNASA4023(C, V, phi, false, s_Node.data());
+    else
+    {
+        ThinInfluence(Polar.bVLM1, Panel, C, V);
+        phi = 0.0;
+    }
+
+    if(Polar.bGround)
+    {
+        CG.Set(C.x, C.y, -C.z-2.0*Polar.Height);
+        if(Panel.m_Pos!=MIDSURFACE) Panel.DoubletNASA4023(CG, VG, phiG, false, s_Node.data());
+        else
+        {
+            ThinInfluence(Polar.bVLM1, Panel, CG, VG);
+            phiG = 0.0;
+        }
+        V.x += VG.x;
+        V.y += VG.y;
+        V.z -= VG.z;
+        phi += phiG;
+    }
+}
+
+
+template <bool bThin, bool bGround, bool bVLM1>
+static void SpecializedInfluence(double Height, CPanel const &Panel, Vector3d const &C, Vector3d &V, double &phi)
+{
+    Vector3d VG, CG;
+    double phiG = 0.0;
+
+    phi = 0.0;
+    if(bThin) ThinInfluence(bVLM1, Panel, C, V);
+    else      Panel.DoubletNASA4023(C, V, phi, false, s_Node.data());
+
+    if(bGround)
+    {
+        CG.Set(C.x, C.y, -C.z-2.0*Height);
+        if(bThin) ThinInfluence(bVLM1, Panel, CG, VG);
+        else      Panel.DoubletNASA4023(CG, VG, phiG, false, s_Node.data());
+        V.x += VG.x;
+        V.y += VG.y;
+        V.z -= VG.z;
+        phi += phiG;
+    }
+}
+
+
+static void GenericRow(PolarOptions const &Polar, Vector3d const &C, Vector3d const &Normal, double *aij)
+{
+    Vector3d V;
+    double phi;
+    for(int pp=0; pp<int(s_Panel.size()); pp++)
+    {
+        GenericInfluence(Polar, s_Panel[ulong(pp)], C, V, phi);
+        aij[pp] = V.x*Normal.x + V.y*Normal.y + V.z*Normal.z;
+    }
+}
+
+
+template <bool bGround, bool bVLM1>
+static void SpecializedRow(double Height, Vector3d const &C, Vector3d const &Normal, double *aij)
+{
+    // the thin panels are listed first, so that the type of the panels is fixed in each loop
+    Vector3d V;
+    double phi;
+    int pp;
+    for(pp=0; pp<s_nThin; pp++)
+    {
+        SpecializedInfluence<true, bGround, bVLM1>(Height, s_Panel[ulong(pp)], C, V, phi);
+        aij[pp] = V.x*Normal.x + V.y*Normal.y + V.z*Normal.z;
+    }
+    for(pp=s_nThin; pp<int(s_Panel.size()); pp++)
+    {
+        SpecializedInfluence<false, bGround, bVLM1>(Height, s_Panel[ulong(pp)], C, V, phi);
+        aij[pp] = V.x*Normal.x + V.y*Normal.y + V.z*Normal.z;
+    }
+}
+
+
+static void BenchOptions()
+{
+    // the rows of the influence matrix, with the options tested in the loop or fixed at compile time
+    typedef void (*RowFunction)(double, Vector3d const &, Vector3d const &, double *);
+    static RowFunction const Specialized[4] = {&SpecializedRow<false, false>, &SpecializedRow<false, true>,
+                                               &SpecializedRow<true,  false>, &SpecializedRow<true,  true>};
+    static char const *Name[4] = {"VLM2", "VLM1", "VLM2, ground effect", "VLM1, ground effect"};
+
+    int n = int(s_Panel.size());
+    std::vector<double> aij(ulong(n), 0.0), bij(ulong(n), 0.0);
+    double nInfluences = double(ROWREPEAT) * double(n) * double(n);
+
+    PrintHeader("Rows, ns per coefficient", "generic", "specialized");
+    for(int iOptions=0; iOptions<4; iOptions++)
+    {
+        PolarOptions Polar;
+        Polar.bGround = iOptions>=2;
+        Polar.bVLM1 = iOptions%2==1;
+        Polar.Height = 1.0;
+
+        double tGeneric = 0.0, tSpecialized = 0.0, Diff = 0.0;
+        for(int r=0; r<ROWREPEAT; r++)
+        {
+            for(int p=0; p<n; p++)
+            {
+                CPanel const &Panel = s_Panel[ulong(p)];
+
+                auto Start = std::chrono::steady_clock::now();
+                GenericRow(Polar, Panel.CollPt, Panel.Normal, aij.data());
+                tGeneric += Elapsed(Start);
+
+                Start = std::chrono::steady_clock::now();
+                Specialized[iOptions](Polar.Height, Panel.CollPt, Panel.Normal, bij.data());
+                tSpecialized += Elapsed(Start);
+
+                for(int pp=0; pp<n; pp++) Diff = qMax(Diff, fabs(aij[ulong(pp)]-bij[ulong(pp)]));
+            }
+        }
+        Print(Name[iOptions], tGeneric, tSpecialized, nInfluences, Diff);
+    }
+    printf("\n");
+}
+
+
+int main()
+{
+    MakeMesh();
+
+    printf("%d thin panels, %d thick panels, %d repetitions\n\n", s_nThin, int(s_Panel.size())-s_nThin, REPEAT);
+    BenchVortices();
+    BenchPanels();
+    BenchOptions();
+    return 0;
+}
@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+# Benchmark of the batch kernels of the influence matrix
+# against the per-panel functions, built with the same flags as sail7
+#
+#-------------------------------------------------
+CONFIG += qt c++11 console
+CONFIG -= app_bundle
+QT += opengl
+TEMPLATE = app
+TARGET = kernelbench
+
+SOURCES += \
+    kernelbench.cpp \
+    ../../globals.cpp \
+    ../panel.cpp \
+    ../panelbatch.cpp \
+    ../quaternion.cpp \
+    ../vector3d.cpp \
+    ../vortexbatch.cpp
+
+HEADERS += \
+    ../../globals.h \
+    ../../params.h \
+    ../panel.h \
+    ../panelbatch.h \
+    ../quaternion.h \
+    ../simdpack.h \
+    ../vector3d.h \
+    ../vortexbatch.h
+
+include(../simd.pri)
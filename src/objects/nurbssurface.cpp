@@ -63,7 +63,7 @@ double NURBSSurface::Getu(double pos, double v)
     if(fabs(m_pFrame.last()->m_Position[m_uAxis] - m_pFrame.first()->m_Position[m_uAxis])<0.0000001) return 0.0;
 
     int iter=0;
-    static double u2, u1, u, zz, zh;
+    double u2, u1, u, zz, zh;
     u1 = 0.0; u2 = 1.00;
 
 //    v = 0.0;//use top line, but doesn't matter
@@ -28,20 +28,10 @@
 double CPanel::s_pCoreSize = 0.0001; //0.1 mm
 double CPanel::s_VortexPos = 0.25;
 double CPanel::s_CtrlPos   = 0.75;
-double CPanel::mat[9];
-double CPanel::det;
-Vector3d CPanel::smp, CPanel::smq, CPanel::MidA, CPanel::MidB;
 Vector3d *CPanel::s_pNode;
-Vector3d CPanel::ILA, CPanel::ILB, CPanel::ITA, CPanel::ITB, CPanel::Tt, CPanel::V, CPanel::W;
-Vector3d CPanel::P;
-Vector3d CPanel::LATB, CPanel::TALB;
 
 double CPanel::RFF=10.0;
 double CPanel::eps= 1.e-7;
-double CPanel::side, CPanel::sign, CPanel::dist, CPanel::S, CPanel::GL;
-double CPanel::RNUM, CPanel::DNOM, CPanel::PN, CPanel::DA, CPanel::DB, CPanel::PA, CPanel::PB, CPanel::SM, CPanel::SL, CPanel::AM, CPanel::AL, CPanel::Al, CPanel::pjk, CPanel::CJKi;
-Vector3d CPanel::PJK, CPanel::a, CPanel::b, CPanel::s, CPanel::T, CPanel::T1, CPanel::T2, CPanel::h;
-Vector3d CPanel::m_R[5];
 
 
 
@@ -93,6 +83,8 @@ void CPanel::SetFrame()
 
 void CPanel::SetFrame(Vector3d const &LA, Vector3d const &LB, Vector3d const &TA, Vector3d const &TB)
 {
+    Vector3d LATB, TALB, MidA, MidB, smp, smq;
+
     LATB.x = TB.x - LA.x;
     LATB.y = TB.y - LA.y;
     LATB.z = TB.z - LA.z;
@@ -220,6 +212,7 @@ void CPanel::SetFrame(Vector3d const &LA, Vector3d const &LB, Vector3d const &TA
 
 bool CPanel::Invert33(double *l)
 {
+    double det, mat[9];
     memcpy(mat,l,sizeof(mat));
     /*        a0 b1 c2
         d3 e4 f5
@@ -285,6 +278,7 @@ bool CPanel::Intersect(Vector3d const &A, Vector3d const &U, Vector3d &I, double
 {
     bool b1, b2, b3, b4;
     double r,s;
+    Vector3d ILA, ILB, ITA, ITB, Tt, V, W, P;
 
     ILA.Copy(s_pNode[m_iLA]);
     ITA.Copy(s_pNode[m_iTA]);
@@ -376,6 +370,7 @@ void CPanel::RotateBC(Vector3d const &HA, Quaternion &Qt)
     // HA is the rotation center
     //rotates the panels properties which are used in control analysis
     //    Qt.Conjugate(Vortex);
+    Vector3d W;
 
     W.x = VortexPos.x - HA.x;
     W.y = VortexPos.y - HA.y;
@@ -424,13 +419,17 @@ void CPanel::RotateBC(Vector3d const &HA, Quaternion &Qt)
 
 
 
-void CPanel::DoubletNASA4023(Vector3d const &C, Vector3d &V, double &phi, bool )
+void CPanel::DoubletNASA4023(Vector3d const &C, Vector3d &V, double &phi, bool, Vector3d const *pNode) const
 {
     // VSAERO theory Manual
     // Influence of panel pp at coll pt of panel p
     // vectorial operations are written inline to save computing times
     // -->longer code, but 4x more efficient....
+    // all intermediate values are local, so that the method may be called concurrently from several threads
     int i;
+    double side, sign, GL;
+    double RNUM, DNOM, PN, DA, DB, PA, PB, SM, SL, AM, AL, Al, pjk, CJKi;
+    Vector3d R[5], PJK, a, b, s, T1, h;
     double CoreSize = 0.00000;
     if(fabs(s_pCoreSize)>1.e-10) CoreSize = s_pCoreSize;
 
@@ -440,19 +439,19 @@ void CPanel::DoubletNASA4023(Vector3d const &C, Vector3d &V, double &phi, bool )
 
     if(m_Pos>=MIDSURFACE)
     {
-        m_R[0] = s_pNode[m_iLA];
-        m_R[1] = s_pNode[m_iTA];
-        m_R[2] = s_pNode[m_iTB];
-        m_R[3] = s_pNode[m_iLB];
-        m_R[4] = s_pNode[m_iLA];
+        R[0] = pNode[m_iLA];
+        R[1] = pNode[m_iTA];
+        R[2] = pNode[m_iTB];
+        R[3] = pNode[m_iLB];
+        R[4] = pNode[m_iLA];
     }
     else
     {
-        m_R[0] = s_pNode[m_iLB];
-        m_R[1] = s_pNode[m_iTB];
-        m_R[2] = s_pNode[m_iTA];
-        m_R[3] = s_pNode[m_iLA];
-        m_R[4] = s_pNode[m_iLB];
+        R[0] = pNode[m_iLB];
+        R[1] = pNode[m_iTB];
+        R[2] = pNode[m_iTA];
+        R[3] = pNode[m_iLA];
+        R[4] = pNode[m_iLB];
     }
     PJK.x = C.x - CollPt.x;
     PJK.y = C.y - CollPt.y;
@@ -476,15 +475,15 @@ void CPanel::DoubletNASA4023(Vector3d const &C, Vector3d &V, double &phi, bool )
 
     for (i=0; i<4; i++)
     {
-        a.x  = C.x - m_R[i].x;
-        a.y  = C.y - m_R[i].y;
-        a.z  = C.z - m_R[i].z;
-        b.x  = C.x - m_R[i+1].x;
-        b.y  = C.y - m_R[i+1].y;
-        b.z  = C.z - m_R[i+1].z;
-        s.x  = m_R[i+1].x - m_R[i].x;
-        s.y  = m_R[i+1].y - m_R[i].y;
-        s.z  = m_R[i+1].z - m_R[i].z;
+        a.x  = C.x - R[i].x;
+        a.y  = C.y - R[i].y;
+        a.z  = C.z - R[i].z;
+        b.x  = C.x - R[i+1].x;
+        b.y  = C.y - R[i+1].y;
+        b.z  = C.z - R[i+1].z;
+        s.x  = R[i+1].x - R[i].x;
+        s.y  = R[i+1].y - R[i].y;
+        s.z  = R[i+1].z - R[i].z;
         DA    = sqrt(a.x*a.x + a.y*a.y + a.z*a.z);
         DB    = sqrt(b.x*b.x + b.y*b.y + b.z*b.z);
         SM   = s.x*m.x + s.y*m.y + s.z*m.z;
@@ -501,7 +500,7 @@ void CPanel::DoubletNASA4023(Vector3d const &C, Vector3d &V, double &phi, bool )
         h.z =  a.x*s.y - a.y*s.x;
 
         //first the potential
-        if(m_R[i].IsSame(m_R[i+1]))
+        if(R[i].IsSame(R[i+1]))
         {
             CJKi = 0.0;
             //no contribution to speed either
@@ -554,7 +553,7 @@ void CPanel::DoubletNASA4023(Vector3d const &C, Vector3d &V, double &phi, bool )
           +(C.y-CollPt.y)*(C.y-CollPt.y)
           +(C.z-CollPt.z)*(C.z-CollPt.z))<1.e-10)
     {
-        //        if(m_R[0]->IsSame(*m_R[1]) || m_R[1]->IsSame(*m_R[2]) || m_R[2]->IsSame(*m_R[3]) || m_R[3]->IsSame(*m_R[0]))
+        //        if(R[0]->IsSame(*R[1]) || R[1]->IsSame(*R[2]) || R[2]->IsSame(*R[3]) || R[3]->IsSame(*R[0]))
         //            phi = -3.0*pi/2.0;
         //        else
         phi  = -2.0*PI;
@@ -566,13 +565,17 @@ void CPanel::DoubletNASA4023(Vector3d const &C, Vector3d &V, double &phi, bool )
 
 
 
-void CPanel::SourceNASA4023(Vector3d const &C, Vector3d &V, double &phi)
+void CPanel::SourceNASA4023(Vector3d const &C, Vector3d &V, double &phi, Vector3d const *pNode) const
 {
     //VSAERO theory Manual
     //Influence of panel pp at coll pt of panel p
     //vectorial operations are written inline to save computing times
     //-->longer code, but 4x more efficient....
+    //all intermediate values are local, so that the method may be called concurrently from several threads
     int i;
+    double side, sign, S, GL;
+    double RNUM, DNOM, PN, DA, DB, PA, PB, SM, SL, AM, AL, Al, pjk, CJKi;
+    Vector3d R[5], PJK, a, b, s, T, T1, T2, h;
     double CoreSize = 0.00000;
     if(fabs(s_pCoreSize)>1.e-10) CoreSize = s_pCoreSize;
 
@@ -581,19 +584,19 @@ void CPanel::SourceNASA4023(Vector3d const &C, Vector3d &V, double &phi)
 
     if(m_Pos>=MIDSURFACE)
     {
-        m_R[0] = s_pNode[m_iLA];
-        m_R[1] = s_pNode[m_iTA];
-        m_R[2] = s_pNode[m_iTB];
-        m_R[3] = s_pNode[m_iLB];
-        m_R[4] = s_pNode[m_iLA];
+        R[0] = pNode[m_iLA];
+        R[1] = pNode[m_iTA];
+        R[2] = pNode[m_iTB];
+        R[3] = pNode[m_iLB];
+        R[4] = pNode[m_iLA];
     }
     else
     {
-        m_R[0] = s_pNode[m_iLB];
-        m_R[1] = s_pNode[m_iTB];
-        m_R[2] = s_pNode[m_iTA];
-        m_R[3] = s_pNode[m_iLA];
-        m_R[4] = s_pNode[m_iLB];
+        R[0] = pNode[m_iLB];
+        R[1] = pNode[m_iTB];
+        R[2] = pNode[m_iTA];
+        R[3] = pNode[m_iLA];
+        R[4] = pNode[m_iLB];
     }
 
     PJK.x = C.x - CollPt.x;
@@ -616,17 +619,17 @@ void CPanel::SourceNASA4023(Vector3d const &C, Vector3d &V, double &phi)
 
     for (i=0; i<4; i++)
     {
-        a.x  = C.x - m_R[i].x;
-        a.y  = C.y - m_R[i].y;
-        a.z  = C.z - m_R[i].z;
+        a.x  = C.x - R[i].x;
+        a.y  = C.y - R[i].y;
+        a.z  = C.z - R[i].z;
 
-        b.x  = C.x - m_R[i+1].x;
-        b.y  = C.y - m_R[i+1].y;
-        b.z  = C.z - m_R[i+1].z;
+        b.x  = C.x - R[i+1].x;
+        b.y  = C.y - R[i+1].y;
+        b.z  = C.z - R[i+1].z;
 
-        s.x  = m_R[i+1].x - m_R[i].x;
-        s.y  = m_R[i+1].y - m_R[i].y;
-        s.z  = m_R[i+1].z - m_R[i].z;
+        s.x  = R[i+1].x - R[i].x;
+        s.y  = R[i+1].y - R[i].y;
+        s.z  = R[i+1].z - R[i].z;
 
         DA    = sqrt(a.x*a.x + a.y*a.y + a.z*a.z);
         DB    = sqrt(b.x*b.x + b.y*b.y + b.z*b.z);
@@ -644,7 +647,7 @@ void CPanel::SourceNASA4023(Vector3d const &C, Vector3d &V, double &phi)
         h.y = -a.x*s.z + a.z*s.x;
         h.z =  a.x*s.y - a.y*s.x;
 
-        if(m_R[i].IsSame(m_R[i+1]))
+        if(R[i].IsSame(R[i+1]))
         {
             //no contribution from this side
             CJKi = 0.0;
@@ -659,6 +662,7 @@ void CPanel::SourceNASA4023(Vector3d const &C, Vector3d &V, double &phi)
         {
             //first the potential
             if(DA+DB-S>0.0)    GL = 1.0/S * log((DA+DB+S)/(DA+DB-S));
+            else               GL = 0.0;
 
             RNUM = SM*PN * (DB*PA-DA*PB);
             DNOM = PA*PB + PN*PN*DA*DB*SM*SM;
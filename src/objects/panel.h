@@ -38,6 +38,8 @@ class CPanel
     friend class BoatAnalysisDlg;
     friend class Sail;
     friend class Body;
+    friend class PanelTree;
+    friend class PanelBatch;
 
 public:
     CPanel();
@@ -48,7 +50,7 @@ public:
     void SetFrame(Vector3d const &LA, Vector3d const &LB, Vector3d const &TA, Vector3d const &TB);
 
     bool Intersect(Vector3d const &A, Vector3d const &U, Vector3d &I, double &dist);
-    bool Invert33(double *l);
+    static bool Invert33(double *l);
 
     bool IsBotSurface() {return m_Pos==BOTSURFACE;}
     bool IsMidSurface() {return m_Pos==MIDSURFACE;}
@@ -63,8 +65,8 @@ public:
     double Width();
     double GetArea();
 
-    void DoubletNASA4023(Vector3d const &C, Vector3d &V, double &phi, bool bWake);
-    void SourceNASA4023(Vector3d const &C, Vector3d &V, double &phi);
+    void DoubletNASA4023(Vector3d const &C, Vector3d &V, double &phi, bool bWake, Vector3d const *pNode=s_pNode) const;
+    void SourceNASA4023(Vector3d const &C, Vector3d &V, double &phi, Vector3d const *pNode=s_pNode) const;
 protected:
     bool m_bIsInSymPlane;
     bool m_bIsLeftPanel;
@@ -88,14 +90,10 @@ protected:
     double lij[9];
 
     static Vector3d *s_pNode;
-    static Vector3d smp, smq, MidA, MidB;
-    static Vector3d ILA, ILB, ITA, ITB, Tt, V, W, P, LATB, TALB;
 
     static double s_pCoreSize;
     static double s_VortexPos;//between 0 and 1
     static double s_CtrlPos;//between 0 and 1
-    static double det;
-    static double mat[9];
 
 public:
     enumPanelPosition m_Pos;
@@ -107,11 +105,7 @@ public:
     Vector3d CollPt;
     Vector3d VA, VB;
 
-    static Vector3d m_R[5];
     static double RFF, eps;
-    static double side, sign, dist, S, GL;
-    static double RNUM, DNOM, PN, DA, DB, PA, PB, SM, SL, AM, AL, Al, pjk, CJKi;
-    static Vector3d PJK, a, b, s, T, T1, T2, h;
 
 };
 
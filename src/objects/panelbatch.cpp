@@ -0,0 +1,314 @@
+/****************************************************************************
+
+    PanelBatch Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+#include <math.h>
+#include "panelbatch.h"
+#include "simdpack.h"
+#include "../params.h"
+
+
+PanelBatch::PanelBatch()
+{
+    m_bGround = false;
+    m_Height  = 0.0;
+}
+
+
+void PanelBatch::SetGround(bool bGround, double Height)
+{
+    // the images of the panels in the ground plane z=-Height are included in the influences if bGround is true
+    m_bGround = bGround;
+    m_Height  = Height;
+}
+
+
+void PanelBatch::Clear()
+{
+    for(int i=0; i<4; i++)
+    {
+        m_Rx[i].clear(); m_Ry[i].clear(); m_Rz[i].clear();
+        m_Side[i].clear();
+    }
+    m_Cx.clear(); m_Cy.clear(); m_Cz.clear();
+    m_Nx.clear(); m_Ny.clear(); m_Nz.clear();
+    m_Mx.clear(); m_My.clear(); m_Mz.clear();
+    m_Lx.clear(); m_Ly.clear(); m_Lz.clear();
+    m_Area.clear(); m_Size.clear();
+}
+
+
+void PanelBatch::AddPanel(CPanel const &Panel, Vector3d const *pNode)
+{
+    // the corners are listed in the same order as in CPanel::DoubletNASA4023()
+    Vector3d R[5];
+    if(Panel.m_Pos>=MIDSURFACE)
+    {
+        R[0] = pNode[Panel.m_iLA];
+        R[1] = pNode[Panel.m_iTA];
+        R[2] = pNode[Panel.m_iTB];
+        R[3] = pNode[Panel.m_iLB];
+    }
+    else
+    {
+        R[0] = pNode[Panel.m_iLB];
+        R[1] = pNode[Panel.m_iTB];
+        R[2] = pNode[Panel.m_iTA];
+        R[3] = pNode[Panel.m_iLA];
+    }
+    R[4] = R[0];
+
+    for(int i=0; i<4; i++)
+    {
+        m_Rx[i].push_back(R[i].x); m_Ry[i].push_back(R[i].y); m_Rz[i].push_back(R[i].z);
+        m_Side[i].push_back(R[i].IsSame(R[i+1]) ? 0.0 : 1.0);
+    }
+    m_Cx.push_back(Panel.CollPt.x); m_Cy.push_back(Panel.CollPt.y); m_Cz.push_back(Panel.CollPt.z);
+    m_Nx.push_back(Panel.Normal.x); m_Ny.push_back(Panel.Normal.y); m_Nz.push_back(Panel.Normal.z);
+    m_Mx.push_back(Panel.m.x);      m_My.push_back(Panel.m.y);      m_Mz.push_back(Panel.m.z);
+    m_Lx.push_back(Panel.l.x);      m_Ly.push_back(Panel.l.y);      m_Lz.push_back(Panel.l.z);
+    m_Area.push_back(Panel.Area);
+    m_Size.push_back(Panel.Size);
+}
+
+
+template <typename T, bool bSource, bool bGround>
+void PanelBatch::PackInfluences(int k, Vector3d const &C, double *Vx, double *Vy, double *Vz, double *Phi) const
+{
+    // the doublet or source influences at C of the panels k to k+PackSize<T>()-1, stored from Vx, Vy, Vz, Phi
+    // the formulas and the notations are those of CPanel::DoubletNASA4023() and CPanel::SourceNASA4023()
+    // if bGround is true, the influences at the image point of C are evaluated in the same pass and added,
+    // the data of the panels' sides being shared by the two points
+    int const nPoints = bGround ? 2 : 1;
+    T zero = PackSet<T>(0.0), one = PackSet<T>(1.0);
+    T cx[2], cy[2], cz[2];
+    cx[0] = cx[1] = PackSet<T>(C.x);
+    cy[0] = cy[1] = PackSet<T>(C.y);
+    cz[0] = PackSet<T>(C.z);
+    cz[1] = PackSet<T>(-C.z-2.0*m_Height);
+
+    T nx = PackLoad<T>(m_Nx.data()+k), ny = PackLoad<T>(m_Ny.data()+k), nz = PackLoad<T>(m_Nz.data()+k);
+    T colx = PackLoad<T>(m_Cx.data()+k), coly = PackLoad<T>(m_Cy.data()+k), colz = PackLoad<T>(m_Cz.data()+k);
+    T Area = PackLoad<T>(m_Area.data()+k);
+    T RFFSize = PackMul(PackSet<T>(CPanel::RFF), PackLoad<T>(m_Size.data()+k));
+
+    //the far field formulas
+    T PN[2], pjk[2], pjk2[2];
+    T fVx[2], fVy[2], fVz[2], fPhi[2];
+    T nNear = zero;
+    for(int ip=0; ip<nPoints; ip++)
+    {
+        T pjkx = PackSub(cx[ip], colx), pjky = PackSub(cy[ip], coly), pjkz = PackSub(cz[ip], colz);
+        PN[ip]   = PackAdd(PackAdd(PackMul(pjkx, nx), PackMul(pjky, ny)), PackMul(pjkz, nz));
+        pjk2[ip] = PackAdd(PackAdd(PackMul(pjkx, pjkx), PackMul(pjky, pjky)), PackMul(pjkz, pjkz));
+        pjk[ip]  = PackSqrt(pjk2[ip]);
+
+        T pjk3 = PackMul(pjk2[ip], pjk[ip]);
+        if(bSource)
+        {
+            T f = PackDiv(Area, pjk3);
+            fPhi[ip] = PackDiv(Area, pjk[ip]);
+            fVx[ip] = PackMul(pjkx, f);
+            fVy[ip] = PackMul(pjky, f);
+            fVz[ip] = PackMul(pjkz, f);
+        }
+        else
+        {
+            T f = PackDiv(Area, PackMul(pjk3, pjk2[ip]));
+            T PN3 = PackMul(PackSet<T>(3.0), PN[ip]);
+            fPhi[ip] = PackDiv(PackMul(PN[ip], Area), pjk3);
+            fVx[ip] = PackMul(PackSub(PackMul(pjkx, PN3), PackMul(nx, pjk2[ip])), f);
+            fVy[ip] = PackMul(PackSub(PackMul(pjky, PN3), PackMul(ny, pjk2[ip])), f);
+            fVz[ip] = PackMul(PackSub(PackMul(pjkz, PN3), PackMul(nz, pjk2[ip])), f);
+        }
+        nNear = PackAdd(nNear, PackIf(pjk[ip], RFFSize, zero, one));
+    }
+
+    T rVx[2], rVy[2], rVz[2], rPhi[2];
+    if(PackSum(nNear)==0.0)
+    {
+        // all the panels are in the far field
+        for(int ip=0; ip<nPoints; ip++)
+        {
+            rVx[ip] = fVx[ip]; rVy[ip] = fVy[ip]; rVz[ip] = fVz[ip]; rPhi[ip] = fPhi[ip];
+        }
+    }
+    else
+    {
+        //the near field formulas
+        double CoreSize = 0.0;
+        if(fabs(CPanel::s_pCoreSize)>1.e-10) CoreSize = CPanel::s_pCoreSize;
+        T core = PackSet<T>(CoreSize), core2 = PackSet<T>(CoreSize*CoreSize);
+        T eps = PackSet<T>(CPanel::eps);
+        T Pi = PackSet<T>(PI), HalfPi = PackSet<T>(PI/2.0);
+
+        T mx = PackLoad<T>(m_Mx.data()+k), my = PackLoad<T>(m_My.data()+k), mz = PackLoad<T>(m_Mz.data()+k);
+        T lx = PackLoad<T>(m_Lx.data()+k), ly = PackLoad<T>(m_Ly.data()+k), lz = PackLoad<T>(m_Lz.data()+k);
+        T PN2[2], PNSign[2], bPNSmall[2];
+        for(int ip=0; ip<nPoints; ip++)
+        {
+            PN2[ip] = PackMul(PN[ip], PN[ip]);
+            PNSign[ip] = PackIf(PN[ip], zero, one, PackSet<T>(-1.0));
+            bPNSmall[ip] = PackIf(eps, PackAbs(PN[ip]), one, zero);
+            rVx[ip] = rVy[ip] = rVz[ip] = rPhi[ip] = zero;
+        }
+
+        for(int i=0; i<4; i++)
+        {
+            //the side's data, shared by the point and its image
+            int j = (i+1)%4;
+            T rix = PackLoad<T>(m_Rx[i].data()+k), riy = PackLoad<T>(m_Ry[i].data()+k), riz = PackLoad<T>(m_Rz[i].data()+k);
+            T rjx = PackLoad<T>(m_Rx[j].data()+k), rjy = PackLoad<T>(m_Ry[j].data()+k), rjz = PackLoad<T>(m_Rz[j].data()+k);
+            T sx = PackSub(rjx, rix), sy = PackSub(rjy, riy), sz = PackSub(rjz, riz);
+            T SM = PackAdd(PackAdd(PackMul(sx, mx), PackMul(sy, my)), PackMul(sz, mz));
+            T SL = PackAdd(PackAdd(PackMul(sx, lx), PackMul(sy, ly)), PackMul(sz, lz));
+            T s2 = PackAdd(PackAdd(PackMul(sx, sx), PackMul(sy, sy)), PackMul(sz, sz));
+            T S  = bSource ? PackSqrt(s2) : zero;
+            T Side = PackLoad<T>(m_Side[i].data()+k);
+
+            for(int ip=0; ip<nPoints; ip++)
+            {
+                T ax = PackSub(cx[ip], rix), ay = PackSub(cy[ip], riy), az = PackSub(cz[ip], riz);
+                T bx = PackSub(cx[ip], rjx), by = PackSub(cy[ip], rjy), bz = PackSub(cz[ip], rjz);
+
+                T DA = PackSqrt(PackAdd(PackAdd(PackMul(ax, ax), PackMul(ay, ay)), PackMul(az, az)));
+                T DB = PackSqrt(PackAdd(PackAdd(PackMul(bx, bx), PackMul(by, by)), PackMul(bz, bz)));
+                T AM = PackAdd(PackAdd(PackMul(ax, mx), PackMul(ay, my)), PackMul(az, mz));
+                T AL = PackAdd(PackAdd(PackMul(ax, lx), PackMul(ay, ly)), PackMul(az, lz));
+                T Al = PackSub(PackMul(AM, SL), PackMul(AL, SM));
+                T PA = PackAdd(PackMul(PN2[ip], SL), PackMul(Al, AM));
+                T PB = PackSub(PA, PackMul(Al, SM));
+
+                //the distance of the point to the panel's side
+                T hx = PackSub(PackMul(ay, sz), PackMul(az, sy));
+                T hy = PackSub(PackMul(az, sx), PackMul(ax, sz));
+                T hz = PackSub(PackMul(ax, sy), PackMul(ay, sx));
+                T h2 = PackAdd(PackAdd(PackMul(hx, hx), PackMul(hy, hy)), PackMul(hz, hz));
+                T as = PackAdd(PackAdd(PackMul(ax, sx), PackMul(ay, sy)), PackMul(az, sz));
+                T bs = PackAdd(PackAdd(PackMul(bx, sx), PackMul(by, sy)), PackMul(bz, sz));
+
+                //the side contributes unless it is degenerate, or the point lies on it or close to its ends
+                T bSide = PackIf(PackMax(PackMax(PackSub(PackDiv(h2, s2), core2), PackSub(zero, as)), bs), zero, Side, zero);
+                bSide = PackIf(core, DA, zero, bSide);
+                bSide = PackIf(core, DB, zero, bSide);
+
+                //the solid angle
+                T RNUM = PackMul(PackMul(SM, PN[ip]), PackSub(PackMul(DB, PA), PackMul(DA, PB)));
+                T DNOM = PackAdd(PackMul(PA, PB), PackMul(PackMul(PN2[ip], PackMul(DA, DB)), PackMul(SM, SM)));
+                T side = PackAdd(PackAdd(PackMul(nx, hx), PackMul(ny, hy)), PackMul(nz, hz));
+                T sign = PackIf(zero, side, PackSet<T>(-1.0), one);
+                T CJKi = PackIf(zero, DNOM, Pi, PackIf(DNOM, zero, zero, HalfPi));
+                CJKi = PackMul(CJKi, PackMul(sign, PNSign[ip]));
+                CJKi = PackIf(bPNSmall[ip], PackSet<T>(0.5), CJKi, PackAtan2(RNUM, DNOM));
+
+                if(bSource)
+                {
+                    T DAB = PackAdd(DA, DB);
+                    T den = PackSub(DAB, S);
+                    T GL = PackDiv(PackLog(PackDiv(PackAdd(DAB, S), PackIf(den, zero, den, one))), S);
+                    GL = PackIf(den, zero, GL, zero);
+
+                    T SMGL = PackMul(SM, GL), SLGL = PackMul(SL, GL);
+                    rPhi[ip] = PackAdd(rPhi[ip], PackSelect(bSide, PackSet<T>(0.5), PackSub(PackMul(Al, GL), PackMul(PN[ip], CJKi))));
+                    rVx[ip]  = PackAdd(rVx[ip],  PackSelect(bSide, PackSet<T>(0.5), PackAdd(PackMul(nx, CJKi), PackSub(PackMul(lx, SMGL), PackMul(mx, SLGL)))));
+                    rVy[ip]  = PackAdd(rVy[ip],  PackSelect(bSide, PackSet<T>(0.5), PackAdd(PackMul(ny, CJKi), PackSub(PackMul(ly, SMGL), PackMul(my, SLGL)))));
+                    rVz[ip]  = PackAdd(rVz[ip],  PackSelect(bSide, PackSet<T>(0.5), PackAdd(PackMul(nz, CJKi), PackSub(PackMul(lz, SMGL), PackMul(mz, SLGL)))));
+                }
+                else
+                {
+                    T gx = PackSub(PackMul(ay, bz), PackMul(az, by));
+                    T gy = PackSub(PackMul(az, bx), PackMul(ax, bz));
+                    T gz = PackSub(PackMul(ax, by), PackMul(ay, bx));
+                    T DADB = PackMul(DA, DB);
+                    T ab = PackAdd(PackAdd(PackMul(ax, bx), PackMul(ay, by)), PackMul(az, bz));
+                    T GL = PackDiv(PackAdd(DA, DB), PackMul(DADB, PackAdd(DADB, ab)));
+
+                    rPhi[ip] = PackAdd(rPhi[ip], PackSelect(bSide, PackSet<T>(0.5), CJKi));
+                    rVx[ip]  = PackAdd(rVx[ip],  PackSelect(bSide, PackSet<T>(0.5), PackMul(gx, GL)));
+                    rVy[ip]  = PackAdd(rVy[ip],  PackSelect(bSide, PackSet<T>(0.5), PackMul(gy, GL)));
+                    rVz[ip]  = PackAdd(rVz[ip],  PackSelect(bSide, PackSet<T>(0.5), PackMul(gz, GL)));
+                }
+            }
+        }
+
+        for(int ip=0; ip<nPoints; ip++)
+        {
+            //the point is the panel's own collocation point
+            if(!bSource) rPhi[ip] = PackIf(PackSet<T>(1.e-10), pjk2[ip], PackSet<T>(-2.0*PI), rPhi[ip]);
+
+            rVx[ip]  = PackIf(pjk[ip], RFFSize, fVx[ip],  rVx[ip]);
+            rVy[ip]  = PackIf(pjk[ip], RFFSize, fVy[ip],  rVy[ip]);
+            rVz[ip]  = PackIf(pjk[ip], RFFSize, fVz[ip],  rVz[ip]);
+            rPhi[ip] = PackIf(pjk[ip], RFFSize, fPhi[ip], rPhi[ip]);
+        }
+    }
+
+    if(bGround)
+    {
+        // the image of the panel, seen from C, is the panel seen from the image of C
+        rVx[0]  = PackAdd(rVx[0],  rVx[1]);
+        rVy[0]  = PackAdd(rVy[0],  rVy[1]);
+        rVz[0]  = PackSub(rVz[0],  rVz[1]);
+        rPhi[0] = PackAdd(rPhi[0], rPhi[1]);
+    }
+    PackStore(Vx,  rVx[0]);
+    PackStore(Vy,  rVy[0]);
+    PackStore(Vz,  rVz[0]);
+    PackStore(Phi, rPhi[0]);
+}
+
+
+template <typename T, bool bSource>
+void PanelBatch::Influences(Vector3d const &C, int First, int Last, double *Vx, double *Vy, double *Vz, double *Phi) const
+{
+    int k = First;
+    int Width = PackSize<T>();
+    if(m_bGround)
+    {
+        for(; k+Width<=Last; k+=Width) PackInfluences<T, bSource, true>(k, C, Vx+k-First, Vy+k-First, Vz+k-First, Phi+k-First);
+        for(; k<Last; k++)             PackInfluences<double, bSource, true>(k, C, Vx+k-First, Vy+k-First, Vz+k-First, Phi+k-First);
+    }
+    else
+    {
+        for(; k+Width<=Last; k+=Width) PackInfluences<T, bSource, false>(k, C, Vx+k-First, Vy+k-First, Vz+k-First, Phi+k-First);
+        for(; k<Last; k++)             PackInfluences<double, bSource, false>(k, C, Vx+k-First, Vy+k-First, Vz+k-First, Phi+k-First);
+    }
+}
+
+
+void PanelBatch::Doublets(Vector3d const &C, int First, int Last, double *Vx, double *Vy, double *Vz, double *Phi) const
+{
+    //
+    // Sets in Vx[k-First], Vy[k-First], Vz[k-First] and Phi[k-First] the velocity and the potential
+    // induced at point C by the unit doublet of panel k and by its ground image if any, for k=First...Last-1
+    //
+    Influences<SimdPack, false>(C, First, Last, Vx, Vy, Vz, Phi);
+}
+
+
+void PanelBatch::Sources(Vector3d const &C, int First, int Last, double *Vx, double *Vy, double *Vz, double *Phi) const
+{
+    //
+    // Sets in Vx[k-First], Vy[k-First], Vz[k-First] and Phi[k-First] the velocity and the potential
+    // induced at point C by the unit source of panel k and by its ground image if any, for k=First...Last-1
+    //
+    Influences<SimdPack, true>(C, First, Last, Vx, Vy, Vz, Phi);
+}
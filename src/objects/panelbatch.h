@@ -0,0 +1,75 @@
+/****************************************************************************
+
+    PanelBatch Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+#ifndef PANELBATCH_H
+#define PANELBATCH_H
+
+#include <vector>
+#include "panel.h"
+#include "vector3d.h"
+
+
+//
+// The corners and the local frames of the thick panels, stored coordinate by coordinate
+// so that the doublet and source influences of the NASA 4023 method may be evaluated
+// several panels at a time with the SIMD instructions of the processor.
+//
+// The results are the same as those of CPanel::DoubletNASA4023() and CPanel::SourceNASA4023().
+// The near and far field formulas are both evaluated and the result is selected without branches ;
+// the near field formulas are skipped if all the panels of a pack are in the far field.
+//
+// With ground effect, the influences of the panels' images are evaluated in the same pass
+// as those of the panels, with the same data for the panels' sides, and are added to them.
+//
+class PanelBatch
+{
+public:
+    PanelBatch();
+
+    void Clear();
+    void AddPanel(CPanel const &Panel, Vector3d const *pNode);
+    void SetGround(bool bGround, double Height);
+
+    void Doublets(Vector3d const &C, int First, int Last, double *Vx, double *Vy, double *Vz, double *Phi) const;
+    void Sources(Vector3d const &C, int First, int Last, double *Vx, double *Vy, double *Vz, double *Phi) const;
+
+    int Size() const {return int(m_Area.size());}
+
+private:
+    template <typename T, bool bSource>
+    void Influences(Vector3d const &C, int First, int Last, double *Vx, double *Vy, double *Vz, double *Phi) const;
+    template <typename T, bool bSource, bool bGround>
+    void PackInfluences(int k, Vector3d const &C, double *Vx, double *Vy, double *Vz, double *Phi) const;
+
+    std::vector<double> m_Rx[4], m_Ry[4], m_Rz[4];  // the corners, in the order of the edges' loop
+    std::vector<double> m_Side[4];                  // 1 if the edge from corner i to corner i+1 is not degenerate, 0 otherwise
+    std::vector<double> m_Cx, m_Cy, m_Cz;           // the collocation points
+    std::vector<double> m_Nx, m_Ny, m_Nz;           // the local frames
+    std::vector<double> m_Mx, m_My, m_Mz;
+    std::vector<double> m_Lx, m_Ly, m_Lz;
+    std::vector<double> m_Area, m_Size;
+
+    bool m_bGround;
+    double m_Height;
+};
+
+#endif // PANELBATCH_H
@@ -0,0 +1,141 @@
+/****************************************************************************
+
+    PanelResultPool Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+
+#include <new>
+#include "panelresultpool.h"
+#include "../params.h"
+
+
+PanelResultPool::PanelResultPool()
+{
+    m_pCarved = nullptr;
+    m_pFree = nullptr;
+    m_nFree = 0;
+}
+
+
+PanelResultPool::~PanelResultPool()
+{
+    for(std::map<double*, Chunk>::iterator it=m_Chunk.begin(); it!=m_Chunk.end(); ++it) delete [] it->first;
+}
+
+
+PanelResultPool &PanelResultPool::Pool()
+{
+    static PanelResultPool s_Pool;
+    return s_Pool;
+}
+
+
+double *PanelResultPool::Allocate(int nValues)
+{
+    //
+    // Returns a block of nValues doubles, or nullptr if there is not enough memory
+    // The content of the block is not initialized
+    //
+    if(nValues<=0) return nullptr;
+
+    PanelResultPool &P = Pool();
+    std::lock_guard<std::mutex> Lock(P.m_Mutex);
+
+    std::vector<double*> &Free = P.m_Block[nValues];
+    if(Free.size())
+    {
+        double *pBlock = Free.back();
+        Free.pop_back();
+        std::map<double*, Chunk>::iterator it = P.m_Chunk.upper_bound(pBlock);
+        (--it)->second.nUsed++;
+        return pBlock;
+    }
+
+    if(nValues>P.m_nFree)
+    {
+        int ChunkSize = nValues>RESULTPOOLCHUNK ? nValues : RESULTPOOLCHUNK;
+        double *pChunk = new (std::nothrow) double[size_t(ChunkSize)];
+        if(!pChunk) return nullptr;
+        Chunk &C = P.m_Chunk[pChunk];
+        C.Size  = ChunkSize;
+        C.nUsed = 1;
+        if(ChunkSize==nValues) return pChunk;
+
+        // the end of the previous chunk is lost, which is less than one point's block
+        P.m_pCarved = pChunk;
+        P.m_pFree = pChunk + nValues;
+        P.m_nFree = ChunkSize - nValues;
+        return pChunk;
+    }
+
+    double *pBlock = P.m_pFree;
+    P.m_pFree += nValues;
+    P.m_nFree -= nValues;
+    P.m_Chunk[P.m_pCarved].nUsed++;
+    return pBlock;
+}
+
+
+void PanelResultPool::Release(double *pBlock, int nValues)
+{
+    // returns a block obtained from Allocate(nValues) to the pool
+    if(!pBlock) return;
+
+    PanelResultPool &P = Pool();
+    std::lock_guard<std::mutex> Lock(P.m_Mutex);
+
+    std::map<double*, Chunk>::iterator it = P.m_Chunk.upper_bound(pBlock);
+    --it;
+    if(--it->second.nUsed>0) P.m_Block[nValues].push_back(pBlock);
+    else                     P.ReleaseChunk(it);
+}
+
+
+void PanelResultPool::ReleaseChunk(std::map<double*, Chunk>::iterator it)
+{
+    // the chunk has no block in use any more : its released blocks are removed from the free lists,
+    // and it is freed, or carved again from its start if it is the chunk being carved
+    double *pStart = it->first;
+    double *pEnd   = pStart + it->second.Size;
+
+    for(std::map<int, std::vector<double*> >::iterator ib=m_Block.begin(); ib!=m_Block.end(); ++ib)
+    {
+        std::vector<double*> &Free = ib->second;
+        for(size_t i=0; i<Free.size(); )
+        {
+            if(Free[i]>=pStart && Free[i]<pEnd)
+            {
+                Free[i] = Free.back();
+                Free.pop_back();
+            }
+            else i++;
+        }
+    }
+
+    if(pStart==m_pCarved)
+    {
+        m_pFree = pStart;
+        m_nFree = it->second.Size;
+        return;
+    }
+
+    delete [] pStart;
+    m_Chunk.erase(it);
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+
+    PanelResultPool Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+
+#ifndef PANELRESULTPOOL_H
+#define PANELRESULTPOOL_H
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+
+//
+// The shared pool from which the operating points take the storage of their per-panel results.
+//
+// The blocks are carved out of chunks of RESULTPOOLCHUNK values, or of a chunk of their own
+// if they are larger, so that each point costs a single allocation of the size it needs.
+// A released block is kept in the list of the free blocks of its size, and is handed to the next
+// point of the same number of panels, which is the usual case in a polar. A chunk is returned
+// to the system as soon as none of its blocks is in use, except the chunk being carved,
+// which is then carved again from its start.
+//
+// Thread safe : the points are built by the analysis and deleted by the user interface.
+//
+class PanelResultPool
+{
+public:
+    static double *Allocate(int nValues);
+    static void Release(double *pBlock, int nValues);
+
+private:
+    PanelResultPool();
+    ~PanelResultPool();
+    static PanelResultPool &Pool();
+
+    struct Chunk
+    {
+        int Size;    // the number of values
+        int nUsed;   // the number of blocks in use
+    };
+
+    void ReleaseChunk(std::map<double*, Chunk>::iterator it);
+
+    std::mutex m_Mutex;
+    std::map<double*, Chunk> m_Chunk;              // the allocated chunks, by address
+    double *m_pCarved;                             // the chunk being carved
+    double *m_pFree;                               // its unused end
+    int m_nFree;
+    std::map<int, std::vector<double*> > m_Block;  // the released blocks, by size
+};
+
+#endif // PANELRESULTPOOL_H
@@ -0,0 +1,634 @@
+/****************************************************************************
+
+    PanelTree Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+#include <math.h>
+#include <algorithm>
+#include "paneltree.h"
+#include "../globals.h"
+
+
+#define ELEMENTDOUBLET  1 // uniform doublet on a thick surface panel
+#define ELEMENTSOURCE   2 // uniform source on a thick surface panel
+#define ELEMENTRING     4 // vortex ring of a VLM2 panel
+#define ELEMENTBOUND    8 // bound vortex of a horseshoe vortex
+#define ELEMENTLEGS    16 // the two trailing legs of a horseshoe vortex
+
+#define LEGLENGTH 50000.0 // same as in VLMCmn()
+
+
+static void SegmentVelocity(Vector3d const &A, Vector3d const &B, Vector3d const &C, Vector3d &V)
+{
+    // velocity induced at point C by a straight vortex of unit circulation from A to B
+    // no core : only used for points far from the segment
+    Vector3d r0, r1, r2, Psi;
+    double ftmp, Omega;
+
+    r0.x = B.x - A.x;    r0.y = B.y - A.y;    r0.z = B.z - A.z;
+    r1.x = C.x - A.x;    r1.y = C.y - A.y;    r1.z = C.z - A.z;
+    r2.x = C.x - B.x;    r2.y = C.y - B.y;    r2.z = C.z - B.z;
+
+    Psi.x = r1.y*r2.z - r1.z*r2.y;
+    Psi.y =-r1.x*r2.z + r1.z*r2.x;
+    Psi.z = r1.x*r2.y - r1.y*r2.x;
+
+    ftmp = Psi.x*Psi.x + Psi.y*Psi.y + Psi.z*Psi.z;
+    if(ftmp<1.e-20)
+    {
+        V.Set(0.0,0.0,0.0);
+        return;
+    }
+
+    Omega = (r0.x*r1.x + r0.y*r1.y + r0.z*r1.z)/sqrt(r1.x*r1.x + r1.y*r1.y + r1.z*r1.z)
+           -(r0.x*r2.x + r0.y*r2.y + r0.z*r2.z)/sqrt(r2.x*r2.x + r2.y*r2.y + r2.z*r2.z);
+
+    V.x = Psi.x * Omega/ftmp/4.0/PI;
+    V.y = Psi.y * Omega/ftmp/4.0/PI;
+    V.z = Psi.z * Omega/ftmp/4.0/PI;
+}
+
+
+static void SymmetricEigen33(double *a, double *lambda, Vector3d *e)
+{
+    // eigenvalues and eigenvectors of the symmetric 3x3 matrix a, using Jacobi rotations
+    // a is destroyed
+    double v[9] = {1.0,0.0,0.0, 0.0,1.0,0.0, 0.0,0.0,1.0};
+    int i, j, k, sweep;
+
+    for(sweep=0; sweep<50; sweep++)
+    {
+        double off = a[1]*a[1] + a[2]*a[2] + a[5]*a[5];
+        if(off<1.e-30*(a[0]*a[0]+a[4]*a[4]+a[8]*a[8]) || off<1.e-300) break;
+
+        for(i=0; i<2; i++)
+        {
+            for(j=i+1; j<3; j++)
+            {
+                double aij = a[i*3+j];
+                if(fabs(aij)<1.e-300) continue;
+
+                double theta = (a[j*3+j]-a[i*3+i])/2.0/aij;
+                double t = (theta>=0.0 ? 1.0 : -1.0)/(fabs(theta)+sqrt(theta*theta+1.0));
+                double c = 1.0/sqrt(t*t+1.0);
+                double s = t*c;
+
+                for(k=0; k<3; k++)
+                {
+                    double aki = a[k*3+i], akj = a[k*3+j];
+                    a[k*3+i] = c*aki - s*akj;
+                    a[k*3+j] = s*aki + c*akj;
+                }
+                for(k=0; k<3; k++)
+                {
+                    double aik = a[i*3+k], ajk = a[j*3+k];
+                    a[i*3+k] = c*aik - s*ajk;
+                    a[j*3+k] = s*aik + c*ajk;
+                }
+                for(k=0; k<3; k++)
+                {
+                    double vki = v[k*3+i], vkj = v[k*3+j];
+                    v[k*3+i] = c*vki - s*vkj;
+                    v[k*3+j] = s*vki + c*vkj;
+                }
+            }
+        }
+    }
+
+    for(k=0; k<3; k++)
+    {
+        lambda[k] = a[k*3+k];
+        e[k].Set(v[k], v[3+k], v[6+k]);
+    }
+}
+
+
+PanelTree::PanelTree()
+{
+    m_Mu = m_Sigma = nullptr;
+    m_nPanels = 0;
+    m_bGround = false;
+    m_Height  = 0.0;
+    m_Theta   = 0.5;
+    m_WindDirection.Set(1.0, 0.0, 0.0);
+}
+
+
+void PanelTree::Clear()
+{
+    m_Element.clear();
+    m_Node.clear();
+    m_Mu = m_Sigma = nullptr;
+    m_nPanels = 0;
+}
+
+
+void PanelTree::Build(CPanel const *pPanel, int nPanels, Vector3d const *pNode, bool bVLM1,
+                      Vector3d const &WindDirection, bool bGround, double Height, double Theta)
+{
+    //
+    // Builds the tree for the current geometry of the panels
+    // The thin surface elements are defined as in BoatAnalysisDlg::VLMGetVortexInfluence(),
+    // without wake roll-up
+    //
+    int p, k;
+    Vector3d Corner[4];
+
+    Clear();
+    m_nPanels       = nPanels;
+    m_WindDirection = WindDirection;
+    m_bGround       = bGround;
+    m_Height        = Height;
+    m_Theta         = Theta;
+
+    if(nPanels<=0) return;
+
+    m_Element.resize(size_t(nPanels));
+
+    for(p=0; p<nPanels; p++)
+    {
+        CPanel const &P = pPanel[p];
+        TreeElement &Elt = m_Element[size_t(p)];
+
+        Elt.pPanel = pPanel+p;
+        Elt.iPanel = p;
+        Elt.Flags  = 0;
+        Elt.Source = 0.0;
+        Elt.Doublet.Set(0.0,0.0,0.0);
+        Elt.Bound.Set(0.0,0.0,0.0);
+        Elt.Radius = 0.0;
+
+        if(P.m_Pos!=MIDSURFACE)
+        {
+            Elt.Flags   = ELEMENTDOUBLET | ELEMENTSOURCE;
+            Elt.Pos     = P.CollPt;
+            Elt.Doublet.Set(P.Normal.x*P.Area, P.Normal.y*P.Area, P.Normal.z*P.Area);
+            Elt.Source  = P.Area;
+            Elt.BoundPos = Elt.Pos;
+            Corner[0] = pNode[P.m_iLA];
+            Corner[1] = pNode[P.m_iLB];
+            Corner[2] = pNode[P.m_iTA];
+            Corner[3] = pNode[P.m_iTB];
+            for(k=0; k<4; k++) Elt.Radius = std::max(Elt.Radius, (Corner[k]-Elt.Pos).VAbs());
+            continue;
+        }
+
+        if(bVLM1)
+        {
+            // horseshoe vortex, bound vortex from VA to VB
+            Elt.Flags = ELEMENTBOUND | ELEMENTLEGS;
+            Elt.TA = P.VA;
+            Elt.TB = P.VB;
+        }
+        else
+        {
+            Elt.LA = P.VA;
+            Elt.LB = P.VB;
+            if(!P.m_bIsTrailing)
+            {
+                Elt.Flags = ELEMENTRING;
+                Elt.TA = pPanel[P.m_iElement-1].VA;
+                Elt.TB = pPanel[P.m_iElement-1].VB;
+            }
+            else
+            {
+                // the trailing ring is closed by a horseshoe vortex
+                Elt.Flags = ELEMENTRING | ELEMENTBOUND | ELEMENTLEGS;
+                Elt.TA.x = pNode[P.m_iTA].x + (pNode[P.m_iTA].x-P.VA.x)/3.0;
+                Elt.TA.y = pNode[P.m_iTA].y;
+                Elt.TA.z = pNode[P.m_iTA].z;
+                Elt.TB.x = pNode[P.m_iTB].x + (pNode[P.m_iTB].x-P.VB.x)/3.0;
+                Elt.TB.y = pNode[P.m_iTB].y;
+                Elt.TB.z = pNode[P.m_iTB].z;
+            }
+        }
+
+        if(Elt.Flags & ELEMENTRING)
+        {
+            // the far field of a vortex ring is that of a doublet of moment Gamma.S/4.PI,
+            // S being the vector area of the ring in the order LB, TB, TA, LA
+            Corner[0] = Elt.LB;
+            Corner[1] = Elt.TB;
+            Corner[2] = Elt.TA;
+            Corner[3] = Elt.LA;
+            Vector3d S(0.0,0.0,0.0);
+            for(k=0; k<4; k++) S += Corner[k] * Corner[(k+1)%4];
+            Elt.Doublet = S * (0.5/4.0/PI);
+            Elt.Pos = (Corner[0]+Corner[1]+Corner[2]+Corner[3])/4.0;
+        }
+        if(Elt.Flags & ELEMENTBOUND)
+        {
+            Elt.BoundPos = (Elt.TA+Elt.TB)/2.0;
+            Elt.Bound    = (Elt.TB-Elt.TA) * (1.0/4.0/PI);
+            if(!(Elt.Flags & ELEMENTRING)) Elt.Pos = Elt.BoundPos;
+        }
+        else Elt.BoundPos = Elt.Pos;
+
+        Elt.Radius = std::max((Elt.TA-Elt.Pos).VAbs(), (Elt.TB-Elt.Pos).VAbs());
+        if(Elt.Flags & ELEMENTRING)
+        {
+            Elt.Radius = std::max(Elt.Radius, (Elt.LA-Elt.Pos).VAbs());
+            Elt.Radius = std::max(Elt.Radius, (Elt.LB-Elt.Pos).VAbs());
+        }
+    }
+
+    m_Node.reserve(size_t(2*nPanels/TREELEAFSIZE+2));
+    BuildNode(0, nPanels);
+}
+
+
+int PanelTree::BuildNode(int First, int Last)
+{
+    //
+    // Creates the node holding the elements First to Last-1, and its children
+    // The elements are split in two halves along the largest dimension of their bounding box
+    //
+    int i;
+    Vector3d Min, Max;
+
+    int iNode = int(m_Node.size());
+    m_Node.push_back(TreeNode());
+
+    Min = Max = m_Element[size_t(First)].Pos;
+    for(i=First; i<Last; i++)
+    {
+        Vector3d const &Pos = m_Element[size_t(i)].Pos;
+        Min.x = std::min(Min.x, Pos.x);    Max.x = std::max(Max.x, Pos.x);
+        Min.y = std::min(Min.y, Pos.y);    Max.y = std::max(Max.y, Pos.y);
+        Min.z = std::min(Min.z, Pos.z);    Max.z = std::max(Max.z, Pos.z);
+    }
+
+    TreeNode Node;
+    Node.Center = (Min+Max)/2.0;
+    Node.Radius = 0.0;
+    Node.First  = First;
+    Node.Last   = Last;
+    Node.Child[0] = Node.Child[1] = -1;
+    Node.bLegs  = false;
+    for(i=First; i<Last; i++)
+    {
+        TreeElement const &Elt = m_Element[size_t(i)];
+        Node.Radius = std::max(Node.Radius, (Elt.Pos-Node.Center).VAbs() + Elt.Radius);
+        if(Elt.Flags & ELEMENTLEGS) Node.bLegs = true;
+    }
+
+    if(Last-First>TREELEAFSIZE)
+    {
+        int Axis = 0;
+        if(Max.y-Min.y > Max.x-Min.x) Axis = 1;
+        if(Max.z-Min.z > std::max(Max.x-Min.x, Max.y-Min.y)) Axis = 2;
+
+        int Mid = (First+Last)/2;
+        std::nth_element(m_Element.begin()+First, m_Element.begin()+Mid, m_Element.begin()+Last,
+                         [Axis](TreeElement const &a, TreeElement const &b)
+        {
+            if(Axis==0) return a.Pos.x<b.Pos.x;
+            if(Axis==1) return a.Pos.y<b.Pos.y;
+            return a.Pos.z<b.Pos.z;
+        });
+
+        Node.Child[0] = BuildNode(First, Mid);
+        Node.Child[1] = BuildNode(Mid, Last);
+    }
+    m_Node[size_t(iNode)] = Node;
+    return iNode;
+}
+
+
+void PanelTree::SetStrengths(double const *Mu, double const *Sigma)
+{
+    //
+    // Sets the doublet and source strengths, and updates the moments of all the nodes
+    // The arrays are indexed by panel, and must remain valid while the tree is evaluated
+    // Mu or Sigma may be null if there are no doublets or no sources
+    //
+    m_Mu    = Mu;
+    m_Sigma = Sigma;
+
+    ParallelFor(int(m_Node.size()), [this](int in)
+    {
+        TreeNode &Node = m_Node[size_t(in)];
+        int a, b, k;
+        double Q[9];
+
+        Node.Doublet.Set(0.0,0.0,0.0);
+        Node.Ring.Set(0.0,0.0,0.0);
+        Node.Source1.Set(0.0,0.0,0.0);
+        Node.Bound.Set(0.0,0.0,0.0);
+        Node.Legs1.Set(0.0,0.0,0.0);
+        Node.Source0 = 0.0;
+        for(k=0; k<9; k++) Node.TDoublet[k] = Node.TRing[k] = Node.TBound[k] = Q[k] = 0.0;
+
+        for(int i=Node.First; i<Node.Last; i++)
+        {
+            TreeElement const &Elt = m_Element[size_t(i)];
+            double mu = m_Mu ? m_Mu[Elt.iPanel] : 0.0;
+            Vector3d d = Elt.Pos - Node.Center;
+
+            if(Elt.Flags & ELEMENTDOUBLET)
+            {
+                Vector3d m = Elt.Doublet;
+                m *= mu;
+                Node.Doublet += m;
+                for(a=0; a<3; a++) for(b=0; b<3; b++) Node.TDoublet[a*3+b] += m[a] * d[b];
+            }
+            if((Elt.Flags & ELEMENTSOURCE) && m_Sigma)
+            {
+                double q = Elt.Source * m_Sigma[Elt.iPanel];
+                Node.Source0 += q;
+                Node.Source1 += d * q;
+            }
+            if(Elt.Flags & ELEMENTRING)
+            {
+                Vector3d m = Elt.Doublet;
+                m *= mu;
+                Node.Ring += m;
+                for(a=0; a<3; a++) for(b=0; b<3; b++) Node.TRing[a*3+b] += m[a] * d[b];
+            }
+            if(Elt.Flags & ELEMENTBOUND)
+            {
+                Vector3d l = Elt.Bound;
+                l *= mu;
+                Vector3d db = Elt.BoundPos - Node.Center;
+                Node.Bound += l;
+                for(a=0; a<3; a++) for(b=0; b<3; b++) Node.TBound[a*3+b] += l[a] * db[b];
+            }
+            if(Elt.Flags & ELEMENTLEGS)
+            {
+                // the left leg has a negative circulation, the right leg a positive circulation
+                Vector3d dA = Elt.TA - Node.Center;
+                Vector3d dB = Elt.TB - Node.Center;
+                Node.Legs1 += (dB - dA) * mu;
+                for(a=0; a<3; a++) for(b=0; b<3; b++) Q[a*3+b] += mu * (dB[a]*dB[b] - dA[a]*dA[b]);
+            }
+        }
+
+        if(Node.bLegs)
+        {
+            // The monopole of the legs is zero, so that their far field is that of the first and
+            // second moments, which are reproduced exactly by a set of seven weighted legs
+            // placed at the center and on the principal axes of the second moment
+            double lambda[3];
+            Vector3d e[3];
+            double h = std::max(Node.Radius, 1.e-6);
+            SymmetricEigen33(Q, lambda, e);
+
+            Node.LegPos[0]    = Node.Center;
+            Node.LegWeight[0] = 0.0;
+            for(k=0; k<3; k++)
+            {
+                double wsum  = lambda[k]/h/h;
+                double wdiff = Node.Legs1.dot(e[k])/h;
+                Node.LegPos[2*k+1]    = Node.Center + e[k]*h;
+                Node.LegPos[2*k+2]    = Node.Center - e[k]*h;
+                Node.LegWeight[2*k+1] = (wsum+wdiff)/2.0;
+                Node.LegWeight[2*k+2] = (wsum-wdiff)/2.0;
+                Node.LegWeight[0]    -= wsum;
+            }
+        }
+    });
+}
+
+
+void PanelTree::LegVelocity(Vector3d const &P, Vector3d const &C, Vector3d &V) const
+{
+    // velocity induced at point C by a trailing leg of unit circulation starting at P
+    Vector3d Far(P.x + m_WindDirection.x*LEGLENGTH, P.y + m_WindDirection.y*LEGLENGTH, P.z + m_WindDirection.z*LEGLENGTH);
+    SegmentVelocity(P, Far, C, V);
+}
+
+
+void PanelTree::ElementVelocity(TreeElement const &Elt, Vector3d const &C, Vector3d &V, double &phi, bool bAll) const
+{
+    // exact influence of the element at point C, scaled by its strengths
+    // if bAll is false, only the trailing legs of the thin surfaces are included, as in VLMCmn()
+    Vector3d V1;
+    double phi1;
+    int p = Elt.iPanel;
+
+    V.Set(0.0,0.0,0.0);
+    phi = 0.0;
+
+    if(Elt.Flags & ELEMENTDOUBLET)
+    {
+        if(m_Mu)
+        {
+            Elt.pPanel->DoubletNASA4023(C, V1, phi1, false);
+            V   += V1 * m_Mu[p];
+            phi += phi1 * m_Mu[p];
+        }
+        if(m_Sigma)
+        {
+            Elt.pPanel->SourceNASA4023(C, V1, phi1);
+            V   += V1 * m_Sigma[p];
+            phi += phi1 * m_Sigma[p];
+        }
+        return;
+    }
+
+    if(!m_Mu) return;
+
+    if((Elt.Flags & ELEMENTRING) && bAll)
+    {
+        VLMQmn(Elt.LA, Elt.LB, Elt.TA, Elt.TB, C, V1, CPanel::s_pCoreSize);
+        V += V1 * m_Mu[p];
+    }
+    if(Elt.Flags & ELEMENTBOUND)
+    {
+        VLMCmn(Elt.TA, Elt.TB, m_WindDirection, C, V1, bAll, CPanel::s_pCoreSize);
+        V += V1 * m_Mu[p];
+    }
+}
+
+
+void PanelTree::NodeVelocity(TreeNode const &Node, Vector3d const &C, Vector3d &V, double &phi, bool bAll) const
+{
+    //
+    // far field of the node's elements at point C, expanded to first order about the node's center
+    // the first order terms are obtained by differentiation of the point kernels with respect to the source point
+    //
+    Vector3d r = C - Node.Center;
+    double r2  = r.x*r.x + r.y*r.y + r.z*r.z;
+    double r1  = sqrt(r2);
+    double ir3 = 1.0/r2/r1;
+    double ir5 = ir3/r2;
+    double ir7 = ir5/r2;
+    Vector3d Tr, Ttr, Vl;
+    double trT, rTr;
+    int k;
+
+    V.Set(0.0,0.0,0.0);
+    phi = 0.0;
+
+    // point doublets, on thick surfaces then on thin surfaces
+    for(int id=0; id<(bAll ? 2 : 1); id++)
+    {
+        Vector3d M = id==0 ? Node.Doublet  : Node.Ring;
+        double const   *T = id==0 ? Node.TDoublet : Node.TRing;
+
+        Tr.Set( T[0]*r.x + T[1]*r.y + T[2]*r.z,  T[3]*r.x + T[4]*r.y + T[5]*r.z,  T[6]*r.x + T[7]*r.y + T[8]*r.z);
+        Ttr.Set(T[0]*r.x + T[3]*r.y + T[6]*r.z,  T[1]*r.x + T[4]*r.y + T[7]*r.z,  T[2]*r.x + T[5]*r.y + T[8]*r.z);
+        trT = T[0] + T[4] + T[8];
+        rTr = r.dot(Tr);
+        double mr = M.dot(r);
+
+        V += (r*(3.0*mr) - M*r2) * ir5;
+        V -= (r*trT + Ttr + Tr) * (3.0*ir5) - r * (15.0*rTr*ir7);
+        if(id==0) phi += mr*ir3 - (trT*ir3 - 3.0*rTr*ir5);
+    }
+
+    // point sources
+    Vector3d D = Node.Source1;
+    double Dr = D.dot(r);
+    V   += r * (Node.Source0*ir3) - (D*ir3 - r*(3.0*Dr*ir5));
+    phi += Node.Source0/r1 + Dr*ir3;
+
+    // bound vortices
+    if(bAll)
+    {
+        double const *T = Node.TBound;
+        Tr.Set(T[0]*r.x + T[1]*r.y + T[2]*r.z,  T[3]*r.x + T[4]*r.y + T[5]*r.z,  T[6]*r.x + T[7]*r.y + T[8]*r.z);
+        Vector3d w(T[5]-T[7], T[6]-T[2], T[1]-T[3]);
+        Vector3d L = Node.Bound;
+        V += (L * r) * ir3;
+        V -= w*ir3 - (Tr * r)*(3.0*ir5);
+    }
+
+    // trailing legs
+    if(Node.bLegs)
+    {
+        for(k=0; k<7; k++)
+        {
+            if(Node.LegWeight[k]==0.0) continue;
+            LegVelocity(Node.LegPos[k], C, Vl);
+            V += Vl * Node.LegWeight[k];
+        }
+    }
+}
+
+
+void PanelTree::EvaluateTree(Vector3d const *C, int nPoints, Vector3d *V, double *phi, bool bAll) const
+{
+    //
+    // Evaluates the tree at nPoints points in a single traversal, usually a point and its ground image
+    // Each stack entry carries the mask of the points for which the node is still near,
+    // so that the nodes and the elements are fetched once for all the points which need them
+    //
+    int Stack[128], Mask[128];
+    int nStack = 0;
+    int i, j;
+    Vector3d V1;
+    double phi1;
+
+    for(j=0; j<nPoints; j++)
+    {
+        V[j].Set(0.0,0.0,0.0);
+        phi[j] = 0.0;
+    }
+    if(m_Node.empty()) return;
+
+    double Theta2 = m_Theta*m_Theta;
+    Mask[nStack]    = (1<<nPoints)-1;
+    Stack[nStack++] = 0;
+
+    while(nStack>0)
+    {
+        nStack--;
+        TreeNode const &Node = m_Node[size_t(Stack[nStack])];
+        int Active = Mask[nStack];
+        int Near = 0;
+        double R2 = Node.Radius*Node.Radius;
+
+        for(j=0; j<nPoints; j++)
+        {
+            if(!(Active & (1<<j))) continue;
+
+            Vector3d r = C[j] - Node.Center;
+            double r2 = r.x*r.x + r.y*r.y + r.z*r.z;
+
+            bool bFar = R2 < Theta2*r2;
+            if(bFar && Node.bLegs)
+            {
+                // the legs extend downstream of the node : use the distance to the swept volume
+                double rpar = r.dot(m_WindDirection);
+                if(rpar>0.0) bFar = R2 < Theta2*(r2-rpar*rpar);
+            }
+
+            if(bFar)
+            {
+                NodeVelocity(Node, C[j], V1, phi1, bAll);
+                V[j]   += V1;
+                phi[j] += phi1;
+            }
+            else Near |= 1<<j;
+        }
+
+        if(!Near) continue;
+
+        if(Node.Child[0]<0)
+        {
+            for(i=Node.First; i<Node.Last; i++)
+            {
+                TreeElement const &Elt = m_Element[size_t(i)];
+                for(j=0; j<nPoints; j++)
+                {
+                    if(!(Near & (1<<j))) continue;
+                    ElementVelocity(Elt, C[j], V1, phi1, bAll);
+                    V[j]   += V1;
+                    phi[j] += phi1;
+                }
+            }
+        }
+        else
+        {
+            Mask[nStack]    = Near;
+            Stack[nStack++] = Node.Child[0];
+            Mask[nStack]    = Near;
+            Stack[nStack++] = Node.Child[1];
+        }
+    }
+}
+
+
+void PanelTree::GetVelocity(Vector3d const &C, Vector3d &V, double &phi, bool bAll) const
+{
+    //
+    // Returns the velocity and the doublet and source potential induced at point C
+    // by all the panels with the current strengths, including the ground image if any
+    // If bAll is false, the vortex rings and the bound vortices of the thin surfaces are ignored,
+    // as in BoatAnalysisDlg::GetSpeedVector()
+    // With the ground, the point and its image share the same traversal of the tree
+    // Thread safe : may be called concurrently once the strengths have been set
+    //
+    Vector3d Pt[2], Vt[2];
+    double phit[2];
+
+    Pt[0] = C;
+    if(!m_bGround)
+    {
+        EvaluateTree(Pt, 1, &V, &phi, bAll);
+        return;
+    }
+
+    Pt[1].Set(C.x, C.y, -C.z-2.0*m_Height);
+    EvaluateTree(Pt, 2, Vt, phit, bAll);
+    V.Set(Vt[0].x+Vt[1].x, Vt[0].y+Vt[1].y, Vt[0].z-Vt[1].z);
+    phi = phit[0] + phit[1];
+}
@@ -0,0 +1,102 @@
+/****************************************************************************
+
+    PanelTree Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+#ifndef PANELTREE_H
+#define PANELTREE_H
+
+#include <vector>
+#include "panel.h"
+#include "vector3d.h"
+
+
+//
+// Hierarchical evaluation of the velocity and potential induced by the panels,
+// without building the influence matrix.
+//
+// The panels are sorted in a binary tree of boxes. Seen from a point far enough,
+// the panels of a box are replaced by the moments of their doublets, sources,
+// bound vortices and trailing legs, expanded about the box's center to first order.
+// The nearby panels are evaluated with the exact panel formulas.
+// The cost of one evaluation is thus of the order of log(N) instead of N.
+//
+class PanelTree
+{
+public:
+    PanelTree();
+
+    void Build(CPanel const *pPanel, int nPanels, Vector3d const *pNode, bool bVLM1,
+               Vector3d const &WindDirection, bool bGround, double Height, double Theta);
+    void SetStrengths(double const *Mu, double const *Sigma);
+    void GetVelocity(Vector3d const &C, Vector3d &V, double &phi, bool bAll=true) const;
+    void Clear();
+
+    int PanelCount() const {return m_nPanels;}
+
+private:
+    struct TreeElement
+    {
+        CPanel const *pPanel;
+        int iPanel;             // the index of the panel in the strength arrays
+        int Flags;              // the parts of the element, combination of the ELEMENT... flags
+        Vector3d Pos;           // the reference position of the doublet and of the source
+        Vector3d Doublet;       // the moment of the doublet or of the vortex ring for a unit strength
+        double Source;          // the strength of the source for a unit strength, i.e. the panel's area
+        Vector3d BoundPos;      // the mid point of the bound vortex
+        Vector3d Bound;         // the bound vortex' vector for a unit circulation, divided by 4.PI
+        Vector3d LA, LB, TA, TB;// the vortex ring's corners ; the horseshoe's bound vortex is TA-TB
+        double Radius;          // the extent of the element about Pos
+    };
+
+    struct TreeNode
+    {
+        Vector3d Center;
+        double Radius;
+        int First, Last;        // the range of the node's elements in m_Element
+        int Child[2];           // -1 if the node is a leaf
+        bool bLegs;             // true if the node holds trailing legs
+
+        // the moments of the node's elements about Center
+        Vector3d Doublet, Ring, Source1, Bound, Legs1;
+        double TDoublet[9], TRing[9], TBound[9];
+        double Source0;
+        Vector3d LegPos[7];     // the equivalent legs, with the same first and second moments
+        double LegWeight[7];
+    };
+
+    int BuildNode(int First, int Last);
+    void EvaluateTree(Vector3d const *C, int nPoints, Vector3d *V, double *phi, bool bAll) const;
+    void ElementVelocity(TreeElement const &Elt, Vector3d const &C, Vector3d &V, double &phi, bool bAll) const;
+    void NodeVelocity(TreeNode const &Node, Vector3d const &C, Vector3d &V, double &phi, bool bAll) const;
+    void LegVelocity(Vector3d const &P, Vector3d const &C, Vector3d &V) const;
+
+    std::vector<TreeElement> m_Element;
+    std::vector<TreeNode> m_Node;
+
+    double const *m_Mu, *m_Sigma;     // the current strengths, owned by the caller
+    int m_nPanels;
+    bool m_bGround;
+    double m_Height;
+    double m_Theta;                     // a box is expanded if Radius/Distance < m_Theta
+    Vector3d m_WindDirection;
+};
+
+#endif // PANELTREE_H
@@ -55,8 +55,8 @@ void PointSpline::DrawSpline(QPainter & painter, double scalex, double , QPoint
 
 double PointSpline::GetY(double const &x)
 {
-    static int i;
-    static double y;
+    int i;
+    double y;
 
     if(x<=0.0 || x>=1.0) return 0.0;
 
@@ -84,7 +84,7 @@ Vector3d PointSpline::GetNormal(double )
 
 void PointSpline::GetCamber(double &Camber, double &xc)
 {
-    static int i;
+    int i;
     Camber = xc =0.0;
 
     for (i=0; i<m_CtrlPoint.size()-1; i++)
@@ -47,9 +47,11 @@ void Sail::PanelTrefftz(Vector3d VInf, double *Mu, double *Sigma, int pos, Vecto
     // calculates the induced lift and drag from the vortices or wake panels strength
     // using a farfield method
     // Downwash is evaluated at a distance 1km downstream (i.e. infinite)
+    // The downwash is induced by the trailing vortices in the Trefftz plane, which is set by the caller
 
     int l, p;
     Vector3d C, Wg, dF, StripForce, WindDirection, WindNormal;
+    std::vector<Vector3d> Pts, Wgs;
 
 
     //lift and drag are calculated in wind axis
@@ -58,11 +60,22 @@ void Sail::PanelTrefftz(Vector3d VInf, double *Mu, double *Sigma, int pos, Vecto
     WindNormal.Set(-VInf.y, VInf.x, VInf.z);
     WindNormal.Normalize();
 
-    p=0;
-
     FFForce.Set(0.0,0.0,0.0);
 
+    for(p=0; p<m_NXPanels*m_NZPanels; p++)
+    {
+        if(pBoatPolar->m_bVLM1 || m_pPanel[p].m_bIsTrailing)
+        {
+            C = m_pPanel[p].CtrlPt;
+            C += WindDirection *1000.0;
+            Pts.push_back(C);
+        }
+    }
+    Wgs.resize(Pts.size());
+    s_pBoatAnalysisDlg->m_TrefftzPlane.GetVelocities(Pts.data(), int(Pts.size()), CPanel::s_pCoreSize, Wgs.data());
 
+    int iPt=0;
+    p=0;
     for (int m=0; m<m_NZPanels; m++)
     {
         StripForce.Set(0.0,0.0,0.0);
@@ -71,11 +84,9 @@ void Sail::PanelTrefftz(Vector3d VInf, double *Mu, double *Sigma, int pos, Vecto
         {
             if(pBoatPolar->m_bVLM1 || m_pPanel[p].m_bIsTrailing)
             {
-                C = m_pPanel[p].CtrlPt;
-                C += WindDirection *1000.0;
-
-                s_pBoatAnalysisDlg->GetSpeedVector(C, Mu, Sigma, Wg, false);
-                //                qDebug()<<Wg.x<<Wg.y<<Wg.z;
+                C  = Pts[ulong(iPt)];
+                Wg = Wgs[ulong(iPt)];
+                iPt++;
 
                 if(m_pPanel[p].m_bIsTrailing) m_Vd[m] = Wg;
                 Wg += VInf * pBoatPolar->WindFactor(C.z); //total speed vector
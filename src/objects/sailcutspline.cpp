@@ -293,11 +293,11 @@ void SailcutSpline::ComputeAKVR4(double slope0, double slope1, double c)
     // assumes an initial state has been set and that the current input parameters
     // correspond to the sailcut spline parameters.
 
-    static double e, v, r, k;
-    static double e1,v1,r1,k1;
-    static double ff0, ff1, ff2, ff3;
+    double e, v, r, k;
+    double e1,v1,r1,k1;
+    double ff0, ff1, ff2, ff3;
 
-    static double cg[16], cgin[16];
+    double cg[16], cgin[16];
     double dmax = 1000.0;
     double dd;
     int iter = 0;
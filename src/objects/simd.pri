@@ -0,0 +1,6 @@
+#the vortex and panel batch kernels use AVX2, or AVX-512, if the compiler is allowed to
+#the executables then require an x86-64 processor with AVX2 and FMA, i.e. Intel Haswell or AMD Excavator and later
+contains(QT_ARCH, x86_64) {
+    *-g++*|*-clang*: QMAKE_CXXFLAGS += -mavx2 -mfma
+    win32-msvc*: QMAKE_CXXFLAGS += /arch:AVX2
+}
@@ -0,0 +1,217 @@
+/****************************************************************************
+
+    SIMD packs of doubles
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+#ifndef SIMDPACK_H
+#define SIMDPACK_H
+
+#include <math.h>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+//
+// The batch kernels are written once, as templates on the type of a pack of doubles.
+// The pack is the widest vector type the compiler has been allowed to use,
+// i.e. AVX-512 with -mavx512f, AVX2 with -mavx2 -mfma, or a plain double otherwise.
+// The plain double is also used for the elements left over at the end of a batch.
+//
+// The Select functions return x where a>b, and zero elsewhere, without branches.
+// The If functions return x where a>b, and y elsewhere.
+// The value discarded by the test may hold infinities or NaNs.
+//
+// The Frexp functions return the mantissa in [0.5, 1[ of a positive and normal value, and set its exponent in e.
+// The Log and Atan2 functions of the packs are evaluated lane by lane by polynomials, and by the library for a plain double.
+//
+
+template <typename T> inline T PackLoad(double const *p);
+template <typename T> inline T PackSet(double a);
+template <typename T> inline int PackSize();
+
+template <> inline double PackLoad<double>(double const *p) {return *p;}
+template <> inline double PackSet<double>(double a)         {return a;}
+template <> inline int    PackSize<double>()                {return 1;}
+
+inline void   PackStore(double *p, double a)             {*p = a;}
+inline double PackAdd(double a, double b)                {return a+b;}
+inline double PackSub(double a, double b)                {return a-b;}
+inline double PackMul(double a, double b)                {return a*b;}
+inline double PackDiv(double a, double b)                {return a/b;}
+inline double PackSqrt(double a)                         {return sqrt(a);}
+inline double PackSelect(double a, double b, double x)   {return a>b ? x : 0.0;}
+inline double PackIf(double a, double b, double x, double y) {return a>b ? x : y;}
+inline double PackMax(double a, double b)                {return a>b ? a : b;}
+inline double PackAbs(double a)                          {return fabs(a);}
+inline double PackCopySign(double a, double b)           {return copysign(a, b);}
+inline double PackFrexp(double a, double &e)             {int i; double m = frexp(a, &i); e = i; return m;}
+inline double PackLog(double a)                          {return log(a);}
+inline double PackAtan2(double a, double b)              {return atan2(a, b);}
+inline double PackSum(double a)                          {return a;}
+
+
+#if defined(__AVX512F__)
+
+typedef __m512d SimdPack;
+
+template <> inline __m512d PackLoad<__m512d>(double const *p) {return _mm512_loadu_pd(p);}
+template <> inline __m512d PackSet<__m512d>(double a)         {return _mm512_set1_pd(a);}
+template <> inline int     PackSize<__m512d>()                {return 8;}
+
+inline void    PackStore(double *p, __m512d a)              {_mm512_storeu_pd(p, a);}
+inline __m512d PackAdd(__m512d a, __m512d b)                {return _mm512_add_pd(a, b);}
+inline __m512d PackSub(__m512d a, __m512d b)                {return _mm512_sub_pd(a, b);}
+inline __m512d PackMul(__m512d a, __m512d b)                {return _mm512_mul_pd(a, b);}
+inline __m512d PackDiv(__m512d a, __m512d b)                {return _mm512_div_pd(a, b);}
+inline __m512d PackSqrt(__m512d a)                          {return _mm512_sqrt_pd(a);}
+inline __m512d PackSelect(__m512d a, __m512d b, __m512d x)  {return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ), x);}
+inline __m512d PackIf(__m512d a, __m512d b, __m512d x, __m512d y) {return _mm512_mask_mov_pd(y, _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ), x);}
+inline __m512d PackMax(__m512d a, __m512d b)                {return _mm512_max_pd(a, b);}
+inline __m512d PackAbs(__m512d a)                           {return _mm512_abs_pd(a);}
+inline __m512d PackCopySign(__m512d a, __m512d b)
+{
+    __m512i sign = _mm512_set1_epi64(0x8000000000000000LL);
+    return _mm512_castsi512_pd(_mm512_or_si512(_mm512_andnot_si512(sign, _mm512_castpd_si512(a)),
+                                                _mm512_and_si512(sign, _mm512_castpd_si512(b))));
+}
+inline __m512d PackFrexp(__m512d a, __m512d &e)
+{
+    __m512i bits = _mm512_castpd_si512(a);
+    // the biased exponent, converted exactly by adding it to the mantissa of 2^52
+    __m512i exponent = _mm512_or_si512(_mm512_srli_epi64(bits, 52), _mm512_set1_epi64(0x4330000000000000LL));
+    e = _mm512_sub_pd(_mm512_castsi512_pd(exponent), _mm512_set1_pd(4503599627370496.0+1022.0));
+    bits = _mm512_and_si512(bits, _mm512_set1_epi64(0x000FFFFFFFFFFFFFLL));
+    return _mm512_castsi512_pd(_mm512_or_si512(bits, _mm512_set1_epi64(0x3FE0000000000000LL)));
+}
+inline double  PackSum(__m512d a)                           {return _mm512_reduce_add_pd(a);}
+
+#elif defined(__AVX2__)
+
+typedef __m256d SimdPack;
+
+template <> inline __m256d PackLoad<__m256d>(double const *p) {return _mm256_loadu_pd(p);}
+template <> inline __m256d PackSet<__m256d>(double a)         {return _mm256_set1_pd(a);}
+template <> inline int     PackSize<__m256d>()                {return 4;}
+
+inline void    PackStore(double *p, __m256d a)              {_mm256_storeu_pd(p, a);}
+inline __m256d PackAdd(__m256d a, __m256d b)                {return _mm256_add_pd(a, b);}
+inline __m256d PackSub(__m256d a, __m256d b)                {return _mm256_sub_pd(a, b);}
+inline __m256d PackMul(__m256d a, __m256d b)                {return _mm256_mul_pd(a, b);}
+inline __m256d PackDiv(__m256d a, __m256d b)                {return _mm256_div_pd(a, b);}
+inline __m256d PackSqrt(__m256d a)                          {return _mm256_sqrt_pd(a);}
+inline __m256d PackSelect(__m256d a, __m256d b, __m256d x)  {return _mm256_and_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ), x);}
+inline __m256d PackIf(__m256d a, __m256d b, __m256d x, __m256d y) {return _mm256_blendv_pd(y, x, _mm256_cmp_pd(a, b, _CMP_GT_OQ));}
+inline __m256d PackMax(__m256d a, __m256d b)                {return _mm256_max_pd(a, b);}
+inline __m256d PackAbs(__m256d a)                           {return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);}
+inline __m256d PackCopySign(__m256d a, __m256d b)
+{
+    __m256d sign = _mm256_set1_pd(-0.0);
+    return _mm256_or_pd(_mm256_andnot_pd(sign, a), _mm256_and_pd(sign, b));
+}
+inline __m256d PackFrexp(__m256d a, __m256d &e)
+{
+    __m256i bits = _mm256_castpd_si256(a);
+    // the biased exponent, converted exactly by adding it to the mantissa of 2^52
+    __m256i exponent = _mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x4330000000000000LL));
+    e = _mm256_sub_pd(_mm256_castsi256_pd(exponent), _mm256_set1_pd(4503599627370496.0+1022.0));
+    bits = _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+    return _mm256_castsi256_pd(_mm256_or_si256(bits, _mm256_set1_epi64x(0x3FE0000000000000LL)));
+}
+inline double  PackSum(__m256d a)
+{
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+#else
+
+typedef double SimdPack;
+
+#endif
+
+
+template <typename T>
+inline T PackLog(T x)
+{
+    //
+    // The natural logarithm of the positive and normal values x, to within a few units of the last place.
+    // x = m.2^e with m in [sqrt(1/2), sqrt(2)[, and log(m) = 2.atanh(s) with s=(m-1)/(m+1), |s|<0.172
+    // The series of atanh is truncated after s^23, the next term being less than 1.e-18
+    //
+    T one = PackSet<T>(1.0);
+    T e;
+    T m = PackFrexp(x, e);
+    T t = PackIf(PackSet<T>(0.70710678118654752440), m, one, PackSet<T>(0.0));
+    m = PackAdd(m, PackMul(m, t));
+    e = PackSub(e, t);
+
+    T s = PackDiv(PackSub(m, one), PackAdd(m, one));
+    T z = PackMul(s, s);
+    T p = PackSet<T>(1.0/23.0);
+    for(int k=10; k>=0; k--) p = PackAdd(PackMul(p, z), PackSet<T>(1.0/double(2*k+1)));
+
+    T ln2hi = PackSet<T>(6.93145751953125E-1), ln2lo = PackSet<T>(1.42860682030941723212E-6);
+    return PackAdd(PackAdd(PackMul(e, ln2lo), PackMul(PackAdd(s, s), p)), PackMul(e, ln2hi));
+}
+
+
+template <typename T>
+inline T PackAtan2(T y, T x)
+{
+    //
+    // The same as atan2(y, x), including the signs of the zeros, to within a few units of the last place.
+    // The ratio of the smallest to the largest of |x| and |y| is reduced to [0, 0.66],
+    // then its arc tangent is approximated by the rational function of the Cephes library.
+    //
+    T zero = PackSet<T>(0.0), one = PackSet<T>(1.0);
+    T MoreBits = PackSet<T>(6.123233995736765886130E-17);
+    T ay = PackAbs(y), ax = PackAbs(x);
+    T num = PackIf(ay, ax, ax, ay);
+    T den = PackIf(ay, ax, ay, ax);
+    T r = PackDiv(num, PackIf(den, zero, den, one));
+
+    T big = PackIf(r, PackSet<T>(0.66), one, zero);
+    r = PackIf(r, PackSet<T>(0.66), PackDiv(PackSub(r, one), PackAdd(r, one)), r);
+
+    T z = PackMul(r, r);
+    T P = PackSet<T>(-8.750608600031904122785E-1);
+    P = PackAdd(PackMul(P, z), PackSet<T>(-1.615753718733365076637E1));
+    P = PackAdd(PackMul(P, z), PackSet<T>(-7.500855792314704667340E1));
+    P = PackAdd(PackMul(P, z), PackSet<T>(-1.228866684490136173410E2));
+    P = PackAdd(PackMul(P, z), PackSet<T>(-6.485021904942025371773E1));
+    T Q = PackAdd(z, PackSet<T>(2.485846490142306297962E1));
+    Q = PackAdd(PackMul(Q, z), PackSet<T>(1.650270098316988542046E2));
+    Q = PackAdd(PackMul(Q, z), PackSet<T>(4.328810604912902668951E2));
+    Q = PackAdd(PackMul(Q, z), PackSet<T>(4.853903996359136964868E2));
+    Q = PackAdd(PackMul(Q, z), PackSet<T>(1.945506571482613964425E2));
+
+    T t = PackAdd(PackMul(r, PackDiv(PackMul(z, P), Q)), r);
+    t = PackAdd(t, PackMul(big, PackAdd(PackSet<T>(7.85398163397448309616E-1), PackMul(PackSet<T>(0.5), MoreBits))));
+
+    // back to the octant, then to the quadrant
+    t = PackIf(ay, ax, PackAdd(PackSub(PackSet<T>(1.57079632679489661923), t), MoreBits), t);
+    t = PackIf(zero, PackCopySign(one, x), PackAdd(PackSub(PackSet<T>(3.14159265358979323846), t), PackAdd(MoreBits, MoreBits)), t);
+    return PackCopySign(t, y);
+}
+
+
+#endif // SIMDPACK_H
@@ -0,0 +1,138 @@
+/****************************************************************************
+
+    TrefftzPlane Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+
+#include <math.h>
+#include <algorithm>
+#include "trefftzplane.h"
+#include "../globals.h"
+#include "../params.h"
+
+
+TrefftzPlane::TrefftzPlane()
+{
+    m_WindDirection.Set(1.0, 0.0, 0.0);
+    m_bGround = false;
+    m_Height  = 0.0;
+}
+
+
+void TrefftzPlane::Clear()
+{
+    m_Px.clear();
+    m_Py.clear();
+    m_Pz.clear();
+    m_Gamma.clear();
+}
+
+
+void TrefftzPlane::SetWind(Vector3d const &WindDirection, bool bGround, double Height)
+{
+    // the filaments are aligned with the wind direction, as the legs of VLMCmn()
+    // their images in the ground plane z=-Height are included in the velocities if bGround is true
+    m_WindDirection = WindDirection;
+    m_bGround = bGround;
+    m_Height  = Height;
+}
+
+
+void TrefftzPlane::AddLeg(Vector3d const &P, double Gamma)
+{
+    // a trailing leg from P to the far point, of circulation Gamma
+    // an incoming leg, such as the left leg of a horseshoe vortex, is added with -Gamma
+    Vector3d Q;
+    for(size_t k=m_Gamma.size(); k>0; k--)
+    {
+        Q.Set(m_Px[k-1], m_Py[k-1], m_Pz[k-1]);
+        if(Q.IsSame(P))
+        {
+            m_Gamma[k-1] += Gamma;
+            return;
+        }
+    }
+
+    m_Px.push_back(P.x);
+    m_Py.push_back(P.y);
+    m_Pz.push_back(P.z);
+    m_Gamma.push_back(Gamma);
+}
+
+
+void TrefftzPlane::GetVelocity(Vector3d const &C, double CoreSize, Vector3d &V) const
+{
+    //
+    // Returns the velocity induced at point C by the filaments, and by their images if any
+    // For a filament of length L from P, with r=C-P=d+xi.W and d normal to the wind direction W :
+    //    V = Gamma/4/PI * (W x d)/|d|^2 * ( xi/sqrt(xi^2+d^2) + (L-xi)/sqrt((L-xi)^2+d^2) )
+    // which tends to the 2D point vortex Gamma/2/PI * (W x d)/|d|^2 in the Trefftz plane
+    // The image point is evaluated in the same pass over the filaments
+    // Thread safe : may be called concurrently once the filaments have been added
+    //
+    double const L = 50000.0; // as in VLMCmn()
+    double const W[3] = {m_WindDirection.x, m_WindDirection.y, m_WindDirection.z};
+    double const cz[2] = {C.z, -C.z-2.0*m_Height};
+    double u[2][3] = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+    int nPoints = m_bGround ? 2 : 1;
+
+    for(size_t k=0; k<m_Gamma.size(); k++)
+    {
+        double rx = C.x - m_Px[k];
+        double ry = C.y - m_Py[k];
+        double xiy = rx*W[0] + ry*W[1];
+
+        for(int i=0; i<nPoints; i++)
+        {
+            double rz = cz[i] - m_Pz[k];
+
+            // the core about the line parallel to x through P, as in VLMCmn()
+            if(ry*ry+rz*rz <= CoreSize*CoreSize) continue;
+
+            double xi = xiy + rz*W[2];
+            double dx = rx - xi*W[0];
+            double dy = ry - xi*W[1];
+            double dz = rz - xi*W[2];
+            double d2 = dx*dx + dy*dy + dz*dz;
+
+            double f = xi/sqrt(xi*xi+d2) + (L-xi)/sqrt((L-xi)*(L-xi)+d2);
+            f *= m_Gamma[k]/4.0/PI/d2;
+
+            u[i][0] += (W[1]*dz - W[2]*dy) * f;
+            u[i][1] += (W[2]*dx - W[0]*dz) * f;
+            u[i][2] += (W[0]*dy - W[1]*dx) * f;
+        }
+    }
+
+    // the image's velocity is mirrored in the ground plane
+    V.Set(u[0][0]+u[1][0], u[0][1]+u[1][1], u[0][2]-u[1][2]);
+}
+
+
+void TrefftzPlane::GetVelocities(Vector3d const *C, int nPoints, double CoreSize, Vector3d *V) const
+{
+    // Same as GetVelocity() for a set of points, which are evaluated in parallel
+    int nBlocks = (nPoints+MATRIXTILESIZE-1)/MATRIXTILESIZE;
+    ParallelFor(nBlocks, [&](int ib)
+    {
+        int iEnd = std::min((ib+1)*MATRIXTILESIZE, nPoints);
+        for(int i=ib*MATRIXTILESIZE; i<iEnd; i++) GetVelocity(C[i], CoreSize, V[i]);
+    });
+}
@@ -0,0 +1,66 @@
+/****************************************************************************
+
+    TrefftzPlane Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+
+#ifndef TREFFTZPLANE_H
+#define TREFFTZPLANE_H
+
+#include <vector>
+#include "vector3d.h"
+
+
+//
+// The wake of the thin surfaces seen in the Trefftz plane, i.e. far downstream.
+//
+// The wake is reduced to its trailing vortex filaments, which cross the plane as point vortices.
+// The filaments which start at the same point, such as the legs of two adjacent strips, are merged
+// into one filament with the net circulation, so that the downwash of a sail's span stations is
+// obtained in one pass over the filaments, without the bound vortices and the panels of the bodies,
+// whose influences vanish far downstream.
+//
+// Each filament keeps the finite extent of the legs of VLMCmn(), and the same core size about the
+// line parallel to x through its origin, so that the velocities are those of the 3D legs.
+//
+class TrefftzPlane
+{
+public:
+    TrefftzPlane();
+
+    void Clear();
+    void SetWind(Vector3d const &WindDirection, bool bGround, double Height);
+    void AddLeg(Vector3d const &P, double Gamma);
+
+    void GetVelocity(Vector3d const &C, double CoreSize, Vector3d &V) const;
+    void GetVelocities(Vector3d const *C, int nPoints, double CoreSize, Vector3d *V) const;
+
+    int Size() const {return int(m_Gamma.size());}
+
+private:
+    std::vector<double> m_Px, m_Py, m_Pz;     // the filaments' origins
+    std::vector<double> m_Gamma;               // the filaments' circulations, positive downstream
+
+    Vector3d m_WindDirection;
+    bool m_bGround;
+    double m_Height;
+};
+
+#endif // TREFFTZPLANE_H
@@ -0,0 +1,193 @@
+/****************************************************************************
+
+    VortexBatch Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+#include <math.h>
+#include "vortexbatch.h"
+#include "simdpack.h"
+#include "../params.h"
+
+
+VortexBatch::VortexBatch()
+{
+    m_bGround = false;
+    m_Height  = 0.0;
+}
+
+
+void VortexBatch::SetGround(bool bGround, double Height)
+{
+    // the images of the segments in the ground plane z=-Height are included in the velocities if bGround is true
+    m_bGround = bGround;
+    m_Height  = Height;
+}
+
+
+void VortexBatch::Clear()
+{
+    m_P1x.clear(); m_P1y.clear(); m_P1z.clear();
+    m_P2x.clear(); m_P2y.clear(); m_P2z.clear();
+    m_Qx.clear();  m_Qy.clear();  m_Qz.clear();
+    m_Ux.clear();  m_Uy.clear();  m_Uz.clear();
+}
+
+
+void VortexBatch::AddSegment(Vector3d const &P1, Vector3d const &P2, Vector3d const &Q, Vector3d const &U)
+{
+    m_P1x.push_back(P1.x); m_P1y.push_back(P1.y); m_P1z.push_back(P1.z);
+    m_P2x.push_back(P2.x); m_P2y.push_back(P2.y); m_P2z.push_back(P2.z);
+    m_Qx.push_back(Q.x);   m_Qy.push_back(Q.y);   m_Qz.push_back(Q.z);
+    m_Ux.push_back(U.x);   m_Uy.push_back(U.y);   m_Uz.push_back(U.z);
+}
+
+
+void VortexBatch::AddSegment(Vector3d const &P1, Vector3d const &P2)
+{
+    // a bound vortex, desingularized around its own line
+    Vector3d U(P2.x-P1.x, P2.y-P1.y, P2.z-P1.z);
+    double l = sqrt(U.x*U.x + U.y*U.y + U.z*U.z);
+    if(l>0.0)
+    {
+        U.x /= l;
+        U.y /= l;
+        U.z /= l;
+    }
+    AddSegment(P1, P2, P1, U);
+}
+
+
+void VortexBatch::AddLeg(Vector3d const &P, Vector3d const &WindDirection, bool bIncoming)
+{
+    // a trailing leg, from the far point to P if bIncoming, or from P to the far point otherwise
+    // the far point is set as in VLMCmn(), and the leg is desingularized around the line parallel to x through P
+    Vector3d Far(P.x + WindDirection.x*50000.0, P.y + WindDirection.y*50000.0, P.z + WindDirection.z*50000.0);
+    Vector3d X(1.0, 0.0, 0.0);
+    if(bIncoming) AddSegment(Far, P, P, X);
+    else          AddSegment(P, Far, P, X);
+}
+
+
+void VortexBatch::AddRing(Vector3d const &LA, Vector3d const &LB, Vector3d const &TA, Vector3d const &TB)
+{
+    // the four sides of the vortex ring, in the order of VLMQmn()
+    AddSegment(LB, TB);
+    AddSegment(TB, TA);
+    AddSegment(TA, LA);
+    AddSegment(LA, LB);
+}
+
+
+void VortexBatch::AddHorseshoe(Vector3d const &A, Vector3d const &B, Vector3d const &WindDirection)
+{
+    // the bound vortex and the two trailing legs of VLMCmn()
+    AddSegment(A, B);
+    AddLeg(A, WindDirection, true);
+    AddLeg(B, WindDirection, false);
+}
+
+
+template <typename T, bool bGround>
+void VortexBatch::PackVelocities(int k, Vector3d const &C, double CoreSize, double *Vx, double *Vy, double *Vz) const
+{
+    // the velocities induced at C by the unit segments k to k+PackSize<T>()-1, stored from Vx, Vy, Vz
+    // if bGround is true, the velocities induced at the image point of C are evaluated in the same pass and added,
+    // the data of the segments being shared by the two points
+    int const nPoints = bGround ? 2 : 1;
+    T cx = PackSet<T>(C.x), cy = PackSet<T>(C.y);
+    T cz[2];
+    cz[0] = PackSet<T>(C.z);
+    cz[1] = PackSet<T>(-C.z-2.0*m_Height);
+
+    T p1x = PackLoad<T>(m_P1x.data()+k), p1y = PackLoad<T>(m_P1y.data()+k), p1z = PackLoad<T>(m_P1z.data()+k);
+    T p2x = PackLoad<T>(m_P2x.data()+k), p2y = PackLoad<T>(m_P2y.data()+k), p2z = PackLoad<T>(m_P2z.data()+k);
+    T qx = PackSub(cx, PackLoad<T>(m_Qx.data()+k));
+    T qy = PackSub(cy, PackLoad<T>(m_Qy.data()+k));
+    T ux = PackLoad<T>(m_Ux.data()+k), uy = PackLoad<T>(m_Uy.data()+k), uz = PackLoad<T>(m_Uz.data()+k);
+    T r0x = PackSub(p2x, p1x), r0y = PackSub(p2y, p1y), r0z = PackSub(p2z, p1z);
+    T r1x = PackSub(cx, p1x),  r1y = PackSub(cy, p1y);
+    T r2x = PackSub(cx, p2x),  r2y = PackSub(cy, p2y);
+    T core2 = PackSet<T>(CoreSize*CoreSize);
+    T four_pi = PackSet<T>(4.0*PI);
+
+    T V[2][3];
+    for(int ip=0; ip<nPoints; ip++)
+    {
+        T r1z = PackSub(cz[ip], p1z);
+        T r2z = PackSub(cz[ip], p2z);
+
+        T Psix = PackSub(PackMul(r1y, r2z), PackMul(r1z, r2y));
+        T Psiy = PackSub(PackMul(r1z, r2x), PackMul(r1x, r2z));
+        T Psiz = PackSub(PackMul(r1x, r2y), PackMul(r1y, r2x));
+        T ftmp = PackAdd(PackAdd(PackMul(Psix, Psix), PackMul(Psiy, Psiy)), PackMul(Psiz, Psiz));
+
+        T r1v = PackSqrt(PackAdd(PackAdd(PackMul(r1x, r1x), PackMul(r1y, r1y)), PackMul(r1z, r1z)));
+        T r2v = PackSqrt(PackAdd(PackAdd(PackMul(r2x, r2x), PackMul(r2y, r2y)), PackMul(r2z, r2z)));
+        T Omega = PackSub(PackDiv(PackAdd(PackAdd(PackMul(r0x, r1x), PackMul(r0y, r1y)), PackMul(r0z, r1z)), r1v),
+                          PackDiv(PackAdd(PackAdd(PackMul(r0x, r2x), PackMul(r0y, r2y)), PackMul(r0z, r2z)), r2v));
+
+        //the square of the distance to the core axis
+        T qz = PackSub(cz[ip], PackLoad<T>(m_Qz.data()+k));
+        T tx = PackSub(PackMul(qy, uz), PackMul(qz, uy));
+        T ty = PackSub(PackMul(qz, ux), PackMul(qx, uz));
+        T tz = PackSub(PackMul(qx, uy), PackMul(qy, ux));
+        T d2 = PackAdd(PackAdd(PackMul(tx, tx), PackMul(ty, ty)), PackMul(tz, tz));
+
+        T f = PackDiv(Omega, PackMul(ftmp, four_pi));
+        f = PackSelect(d2, core2, f);
+
+        V[ip][0] = PackMul(Psix, f);
+        V[ip][1] = PackMul(Psiy, f);
+        V[ip][2] = PackMul(Psiz, f);
+    }
+
+    if(bGround)
+    {
+        // the image of the segment, seen from C, is the segment seen from the image of C
+        V[0][0] = PackAdd(V[0][0], V[1][0]);
+        V[0][1] = PackAdd(V[0][1], V[1][1]);
+        V[0][2] = PackSub(V[0][2], V[1][2]);
+    }
+    PackStore(Vx, V[0][0]);
+    PackStore(Vy, V[0][1]);
+    PackStore(Vz, V[0][2]);
+}
+
+
+template <bool bGround>
+void VortexBatch::BatchVelocities(Vector3d const &C, int First, int Last, double CoreSize, double *Vx, double *Vy, double *Vz) const
+{
+    int k = First;
+    int Width = PackSize<SimdPack>();
+    for(; k+Width<=Last; k+=Width) PackVelocities<SimdPack, bGround>(k, C, CoreSize, Vx+k-First, Vy+k-First, Vz+k-First);
+    for(; k<Last; k++)             PackVelocities<double, bGround>(k, C, CoreSize, Vx+k-First, Vy+k-First, Vz+k-First);
+}
+
+
+void VortexBatch::Velocities(Vector3d const &C, int First, int Last, double CoreSize, double *Vx, double *Vy, double *Vz) const
+{
+    //
+    // Sets in Vx[k-First], Vy[k-First], Vz[k-First] the velocity induced at point C by the unit segment k,
+    // and by its ground image if any, for k=First...Last-1
+    // The segments are processed by packs of the widest SIMD type available, then one at a time
+    //
+    if(m_bGround) BatchVelocities<true>(C, First, Last, CoreSize, Vx, Vy, Vz);
+    else          BatchVelocities<false>(C, First, Last, CoreSize, Vx, Vy, Vz);
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+
+    VortexBatch Class
+    Copyright (C) 2012 Andre Deperrois
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*****************************************************************************/
+
+
+#ifndef VORTEXBATCH_H
+#define VORTEXBATCH_H
+
+#include <vector>
+#include "vector3d.h"
+
+
+//
+// The straight vortex segments of the thin panels, stored coordinate by coordinate
+// so that the velocities they induce at a point may be evaluated several segments at a time
+// with the SIMD instructions of the processor.
+//
+// Each segment is oriented from P1 to P2, and is desingularized as in VLMCmn() and VLMQmn() :
+// its influence is cancelled if the point lies within the core size of the core axis,
+// which is the segment's own line for the bound vortices, and the line parallel to x through
+// the panel's corner for the trailing legs.
+//
+// With ground effect, the velocities induced by the segments' images are evaluated in the same pass
+// as those of the segments, and are added to them.
+//
+class VortexBatch
+{
+public:
+    VortexBatch();
+
+    void Clear();
+    void AddSegment(Vector3d const &P1, Vector3d const &P2);
+    void AddLeg(Vector3d const &P, Vector3d const &WindDirection, bool bIncoming);
+    void AddRing(Vector3d const &LA, Vector3d const &LB, Vector3d const &TA, Vector3d const &TB);
+    void AddHorseshoe(Vector3d const &A, Vector3d const &B, Vector3d const &WindDirection);
+    void SetGround(bool bGround, double Height);
+
+    void Velocities(Vector3d const &C, int First, int Last, double CoreSize, double *Vx, double *Vy, double *Vz) const;
+
+    int Size() const {return int(m_P1x.size());}
+
+private:
+    void AddSegment(Vector3d const &P1, Vector3d const &P2, Vector3d const &Q, Vector3d const &U);
+
+    template <bool bGround>
+    void BatchVelocities(Vector3d const &C, int First, int Last, double CoreSize, double *Vx, double *Vy, double *Vz) const;
+    template <typename T, bool bGround>
+    void PackVelocities(int k, Vector3d const &C, double CoreSize, double *Vx, double *Vy, double *Vz) const;
+
+    std::vector<double> m_P1x, m_P1y, m_P1z;  // the segments' origins
+    std::vector<double> m_P2x, m_P2y, m_P2z;  // the segments' ends
+    std::vector<double> m_Qx, m_Qy, m_Qz;     // a point of the core axis
+    std::vector<double> m_Ux, m_Uy, m_Uz;     // the unit vector of the core axis
+
+    bool m_bGround;
+    double m_Height;
+};
+
+#endif // VORTEXBATCH_H
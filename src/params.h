@@ -6,6 +6,8 @@
 #define PI             3.14159265358979
 #define MAXRECENTFILES         8
 #define SETTINGSFORMAT    100623
+#define AUTOSAVEINTERVAL  10 // default number of minutes between the automatic saves of the project
+#define MAXSAVEAPPENDS    32 // number of saves appended to a project file before it is written anew
 #define PRECISION  0.0000001 //values are assumed 0 if less than this value
 #define MAXCOLORS     30
 #define MAXSTACKPOS   50 // max number of undo pictures on the stack in direct design
@@ -42,9 +44,21 @@
 
 //3D analysis parameters
 #define MAXCHORDPANELS       50
-#define VLMMAXMATSIZE    5000
 #define VLMHALF          2500
 #define VLMMAXRHS         100 // max number of points which may be calculated in a single sequence
+#define LUBLOCKSIZE        64 // number of columns of the panels in the blocked LU factorization
+#define LUCHUNKSIZE       256 // number of columns of the tiles updated by each thread in the blocked LU factorization
+#define MATRIXTILESIZE     64 // number of rows and columns of the tiles of the influence matrix built by each thread
+#define GMRESRESTART       60 // number of Krylov vectors before the GMRES iterations are restarted
+#define GMRESMAXITER      600 // max number of GMRES iterations for each right hand side
+#define REFINEMENTMAXITER  10 // max number of refinement iterations of the single precision LU solver
+#define REFINEMENTTOLERANCE 1.e-12 // relative residual at which the refinement of the single precision LU solver is stopped
+#define PRECONDBLOCKSIZE  256 // max size of the diagonal blocks of the GMRES preconditioner when the influence matrix is not built
+#define TREELEAFSIZE       16 // max number of panels in the leaves of the tree used by the matrix-free solver
+#define HMATRIXLEAFSIZE    32 // max number of panels in the leaf clusters of the hierarchical influence matrix
+#define HMATRIXETA        2.0 // a block is approximated if the diameter of its smaller cluster is less than HMATRIXETA x their distance
+#define RESULTPOOLCHUNK 65536 // number of values of the chunks from which the operating points take their panel results
+#define SWEEPMEMORYFRACTION 0.75 // fraction of the available memory which the workers of a parallel polar sweep may use
 #define MAXPICTURESIZE     40 // maximum number of undo operations in direct design
 #define MAXBODYFRAMES      60
 #define MAXSIDELINES       40
@@ -20,9 +20,17 @@
 #include <QTextEdit>
 #include <QPushButton>
 #include <QCheckBox>
+#include <atomic>
+#include <vector>
 #include "../objects/boatpolar.h"
+#include "../objects/boatopp.h"
 #include "../objects/boat.h"
 #include "../objects/panel.h"
+#include "../objects/paneltree.h"
+#include "../objects/hmatrix.h"
+#include "../objects/panelbatch.h"
+#include "../objects/trefftzplane.h"
+#include "../objects/vortexbatch.h"
 #include "../objects/vector3d.h"
 
 
@@ -39,32 +47,93 @@ class BoatAnalysisDlg : public QDialog
 
 public:
     BoatAnalysisDlg();
+    ~BoatAnalysisDlg();
 
     void InitDialog();
 
     QSize sizeHint() const {return QSize(900,550);}
 
+signals:
+    void AnalysisMessage(QString strong);
+    void AnalysisProgress(int Progress);
+    void AnalysisBoatOpp(BoatOpp *pBoatOpp);
+    void AnalysisFinished();
+
 private slots:
     void OnCancelAnalysis();
-    void OnProgress();
+    void OnMessage(QString strong);
+    void OnProgress(int Progress);
+    void OnBoatOpp(BoatOpp *pBoatOpp);
 
 
 private:
 
+    // the context of a worker of a parallel polar sweep : a copy of the geometry of its current point
+    // and of the batches of this geometry, and its own influence matrix, factorized in place
+    struct SweepWorker
+    {
+        std::vector<CPanel> Panel;
+        std::vector<Vector3d> Node;
+        Vector3d WindDirection;
+        VortexBatch Vortices;
+        std::vector<int> SegmentStart;
+        PanelBatch Thick;
+        std::vector<int> ThickStart;
+        std::vector<double> aij;
+        std::vector<int> Index;
+        std::vector<double> RHS, Mu;
+    };
+
+    // the influences evaluated by the batch kernels at the BC point of a row of the influence matrix
+    struct BatchBuffer
+    {
+        std::vector<double> Vx, Vy, Vz;             // the velocities induced by the vortex segments
+        std::vector<double> DVx, DVy, DVz, DPhi;    // the doublet influences of the thick panels
+    };
+
     QTextEdit *m_pctrlTextOutput;
     QPushButton *m_pctrlCancel;
     QProgressBar *m_pctrlProgress;
 
     void keyPressEvent(QKeyEvent *event);
 
-    bool Solve();
-    bool UnitLoop();
+    bool Solve(bool bFactorize=true, int nRHS=1, bool bRotated=false);
+    bool UnitLoop(int nrhs);
+    int SweepWorkerCount(int nrhs);
+    bool ParallelSweep(int nrhs, int nWorkers);
+    bool SolveSweepPoint(SweepWorker &W);
 
     void AddString(QString strong);
-    void BuildInfluenceMatrix();
+    bool AllocateArrays(int MatSize);
+    void ReleaseArrays();
+    void BuildInfluenceMatrix(bool const *pbMoved=nullptr, bool bColumnsOnly=false);
+    void UpdateInfluenceMatrix();
+    void BuildVortexBatch(SweepWorker *pWorker=nullptr);
+    void BuildPanelBatch(SweepWorker *pWorker=nullptr);
+    void BatchInfluenceRow(int p, int ppStart, int ppEnd, double *aij, bool bVortices, BatchBuffer &Buffer,
+                           SweepWorker const *pWorker) const;
+    void BuildTrefftzPlane(double const *Mu);
+    void InfluenceRow(int p, int ppStart, int ppEnd, double *aij, bool const *pbColumns, bool bThinOnly) const;
+    bool HasTrailingLegs(int p) const;
+    void RecordLegColumns();
+    bool CorrectRotatedLegs();
+    bool SolveRotated(int nRHS);
+    void SetTrimSolver(int nrhs);
+    bool FactorizeMixedPrecision();
+    bool SolveMixedPrecision(int nRHS);
+    bool FactorizeSchurComplement();
+    bool SolveSchurComplement(int nRHS);
+    void BuildPanelTree();
+    void BuildHMatrix();
+    double InfluenceCoefficient(int p, int pp) const;
+    void TreeProduct(double const *x, double *y);
 
     void ComputeOnBody();
     void ComputeBoat();
+    void ComputeDoubletDerivatives();
+    bool FactorizePreconditioner();
+    void Precondition(double *v, double *w);
+    bool SolveIterative(int nRHS);
     void ComputeSurfSpeeds(double *Mu, double *Sigma);
     void ComputeFarField();
     void CreateSourceStrength();
@@ -72,17 +141,20 @@ private:
     void CreateWakeContribution();
     void CreateWakeContribution(double *pWakeContrib);
 
-    void GetDoubletInfluence(Vector3d const &C, CPanel *pPanel, Vector3d &V, double &phi, bool bWake=false, bool bAll=true);
-    void GetSourceInfluence(Vector3d const &C, CPanel *pPanel, Vector3d &V, double &phi);
-    void GetSpeedVector(Vector3d const &C, double *Mu, double *Sigma, Vector3d &VT, bool bAll=true, bool bTrace=false);
+    void GetDoubletInfluence(Vector3d const &C, CPanel const *pPanel, Vector3d &V, double &phi, bool bWake=false, bool bAll=true) const;
+    void GetSourceInfluence(Vector3d const &C, CPanel const *pPanel, Vector3d &V, double &phi) const;
+    void GetSpeedVector(Vector3d const &C, double *Mu, double *Sigma, Vector3d &VT, bool bAll=true, bool bTrace=false) const;
+    void GetSpeedVectors(Vector3d const *C, int nPoints, double *Mu, double *Sigma, Vector3d *VT, bool bAll=true, bool bBuildTree=true);
     void SetFileHeader();
-    void SourceNASA4023(Vector3d const &C, CPanel *pPanel, Vector3d &V, double &phi);
     void SetAngles(BoatPolar *pBoatPolar, double Ctrl, bool bBCOnly=true);
+    bool IsSameGeometry();
+    bool IsRigidRotation();
+    void SetProgress(double Progress);
     void SetupLayout();
     void StartAnalysis();
     void UpdateView();
     void WriteString(QString strong);
-    void VLMGetVortexInfluence(CPanel *pPanel, const Vector3d &C, Vector3d &V, bool bAll);
+    void VLMGetVortexInfluence(CPanel const *pPanel, const Vector3d &C, Vector3d &V, bool bAll) const;
 
     void GetDoubletDerivative(const int &p, double *Mu, double &Cp, Vector3d &VTotl, double const &QInf, double Vx, double Vy, double Vz);
 
@@ -103,6 +175,7 @@ private:
     static Vector3d *s_pRefWakeNode; // a copy of the reference wake node array if wake needs to be reset
 
     static double *s_aij, *s_aijWake;
+    static double *s_aijRef;     // the assembled influence matrix, s_aij holding its LU decomposition or its Schur complement's
     static double *s_RHS, *s_RHSRef;
 
     QFile *m_pXFile;
@@ -112,7 +185,8 @@ private:
     //    bool m_bDirichlet;// true if Dirichlet boundary conditions, false if Neumann
     bool m_bTrefftz;
     bool m_bSequence;
-    bool m_bSkip, m_bExit, m_bCancel, m_bWarning;
+    bool m_bSkip, m_bExit, m_bWarning;
+    std::atomic<bool> m_bCancel; // set by the GUI thread, polled by the analysis thread
     bool m_bWakeRollUp;
 
     int m_State;
@@ -124,30 +198,97 @@ private:
     int m_WakeInterNodes;
     int m_MaxWakeIter;
 
-    double m_Progress;
+    double m_Progress;   // owned by the analysis thread, sent to the GUI with AnalysisProgress()
+    int m_iProgress;     // the last value sent
 
     Vector3d m_VInf;
     Vector3d m_WindDirection, m_WindNormal, m_WindSide;
     double m_Ctrl, m_QInf, m_Beta, m_Phi; // the parameters for  the current iteration
+    double m_SailAngle[MAXSAILS];          // the sail angles for the current iteration
+
+    // the parameters of the matrix currently held in LU form in s_aij
+    // the factorization is reused as long as the geometry and the wind direction are unchanged
+    bool m_bMatrixReady;
+    double m_MatrixBeta, m_MatrixPhi;
+    double m_MatrixSailAngle[MAXSAILS];
+
+    // without ground effect, heeling or heading the boat as a whole only changes the columns of the
+    // panels with trailing legs, which follow the wind direction
+    // m_LegColumns holds these columns as they were when s_aij was factorized, and the LU decomposition
+    // is corrected for their new values with the Woodbury formula rather than being recomputed
+    bool m_bLegsReady, m_bRotated;
+    std::vector<int> m_LegPanels;
+    std::vector<double> m_LegColumns;  // the columns of the factorized matrix, m_MatSize values each
+    std::vector<double> m_RotatedZ;    // s_aij^-1 applied to the changes of the columns
+    std::vector<double> m_RotatedC;    // the LU decomposition of the capacitance matrix
+    std::vector<int> m_RotatedIndex;
+
+    // the parameters of the assembled matrix held in s_aijRef
+    // if only some sails have been trimmed since, only their rows and columns are rebuilt
+    bool m_bRefMatrix;
+    double m_RefBeta, m_RefPhi;
+    double m_RefSailAngle[MAXSAILS];
+
+    // the split of the panels between the fixed surfaces and the sails trimmed along the polar
+    // if m_bTrimSolver, the block of the fixed surfaces is factorized once per analysis
+    bool m_bTrimSolver, m_bRestReady;
+
+    // with the mixed precision solver, s_aij holds the single precision LU decomposition of s_aijRef
+    // if the refinement fails to converge, the matrix is factorized in double precision in place in s_aijRef
+    // for the remainder of the analysis
+    bool m_bMixedFallback;
+
+    std::vector<int> m_TrimRest, m_TrimMoved;
     double m_ControlMin, m_ControlMax, m_ControlDelta;
 
     double eps;
 
     double *m_pCoreSize;
 
-    double m_Sigma[VLMMAXMATSIZE*VLMMAXRHS];        // Source strengths
-    double m_Mu[VLMMAXMATSIZE*VLMMAXRHS];            // Doublet strengths, or vortex circulations if panel is located on a thin surface
-    double m_Cp[VLMMAXMATSIZE*VLMMAXRHS];            // lift coef per panel
+    // work arrays, sized to the panel count by AllocateArrays() and kept between analysis
+    int m_MaxMatSize;
+    double *m_Sigma;             // Source strengths
+    double *m_Mu;                // Doublet strengths, or vortex circulations if panel is located on a thin surface
+    double *m_Cp;                // lift coef per panel
+
+    Vector3d *m_VMuDerivative;
+    double *m_RHS;               // right hand sides, one column of m_MatSize per point of a batch
+    double *m_uWake, *m_wWake;
+
+    int *m_Index;
+
+    Vector3d *m_Speed;
 
-    Vector3d m_VMuDerivative[VLMMAXMATSIZE];
-    double m_RHS[VLMMAXMATSIZE];
-    double m_uWake[VLMMAXMATSIZE], m_wWake[VLMMAXMATSIZE];
+    // block-Jacobi preconditioner of the GMRES solver : one diagonal block per sail and per hull,
+    // factorized in LU form and stored one after the other in m_pBlockLU
+    // without full influence matrix, the sails and hulls are split in blocks of at most PRECONDBLOCKSIZE panels
+    int m_nBlocks;
+    std::vector<int> m_BlockStart;
+    std::vector<size_t> m_BlockOffset;
+    size_t m_BlockLUSize;
+    double *m_pBlockLU;
 
-    int m_Index[VLMMAXMATSIZE];
+    // the panels sorted in a tree, used by the matrix-free solver and for the velocity evaluations
+    PanelTree m_PanelTree;
 
-    Vector3d m_Speed[VLMMAXMATSIZE];
+    // the influence matrix in hierarchical form, used instead of s_aij if the polar requires it
+    HMatrix m_HMatrix;
 
-    Vector3d *m_pR[5];
+    // the vortex segments of the thin panels, evaluated by batches when building the influence matrix
+    // the segments of panel p are m_SegmentStart[p] to m_SegmentStart[p+1]-1 ; the thick panels have none
+    VortexBatch m_VortexBatch;
+    std::vector<int> m_SegmentStart;
+
+    // the thick panels, evaluated by batches when building the influence matrix and the RHS
+    // the thick panel p is m_PanelBatch's panel m_ThickStart[p] ; the thin panels have none
+    PanelBatch m_PanelBatch;
+    std::vector<int> m_ThickStart;
+
+    // the trailing vortices of the thin surfaces, used by the sails' far field force calculations
+    TrefftzPlane m_TrefftzPlane;
+
+    // the workers of a parallel polar sweep, allocated for the duration of the sweep only
+    std::vector<SweepWorker> m_SweepWorker;
 
     QString m_strOut;
     QString m_VersionName;
@@ -156,14 +297,6 @@ private:
     BoatPolar *m_pBoatPolar;
     Boat *m_pBoat;
 
-    //temp data
-    Vector3d VG, CG;
-    double phiG;
-    CPanel m_SymPanel;
-    Vector3d R[5];
-    Vector3d r0, r1, r2, Psi, t, Far;
-    double r1v,r2v,ftmp, Omega;
-
 public:
     Vector3d m_Vd[ 4*VLMMAXRHS * MAXSAILSTATIONS];
     Vector3d m_SailForce[4*VLMMAXRHS];
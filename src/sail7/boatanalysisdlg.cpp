@@ -13,9 +13,15 @@
 #include <QApplication>
 #include <QDateTime>
 #include <QDesktopWidget>
-#include <QTimer>
+#include <QEventLoop>
 #include <QDir>
 #include <math.h>
+#include <algorithm>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "boatanalysisDlg.h"
 #include "../mainframe.h"
@@ -39,6 +45,7 @@ Vector3d *BoatAnalysisDlg::s_pRefWakeNode = nullptr; // a copy of the reference
 
 double *BoatAnalysisDlg::s_aij = nullptr;
 double *BoatAnalysisDlg::s_aijWake = nullptr;
+double *BoatAnalysisDlg::s_aijRef = nullptr;
 double *BoatAnalysisDlg::s_RHS = nullptr;
 double *BoatAnalysisDlg::s_RHSRef = nullptr;
 
@@ -50,6 +57,12 @@ BoatAnalysisDlg::BoatAnalysisDlg()
 
     SetupLayout();
 
+    //The analysis runs in its own thread, and reports to the GUI thread through queued signals
+    qRegisterMetaType<BoatOpp*>("BoatOpp*");
+    connect(this, SIGNAL(AnalysisMessage(QString)),   this, SLOT(OnMessage(QString)),   Qt::QueuedConnection);
+    connect(this, SIGNAL(AnalysisProgress(int)),      this, SLOT(OnProgress(int)),      Qt::QueuedConnection);
+    connect(this, SIGNAL(AnalysisBoatOpp(BoatOpp*)),  this, SLOT(OnBoatOpp(BoatOpp*)),  Qt::QueuedConnection);
+
     m_bSequence      = false;
     m_bIsFinished    = false;
     m_bSequence      = false;
@@ -60,9 +73,21 @@ BoatAnalysisDlg::BoatAnalysisDlg()
 
     m_MatSize = m_nNodes = 0;
 
+    m_Progress  = 0.0;
+    m_iProgress = 0;
+
     m_Ctrl = 0.0;
     m_ControlMin  = m_ControlMax = m_ControlDelta  = 0.0;
 
+    m_bMatrixReady = false;
+    m_MatrixBeta = m_MatrixPhi = 0.0;
+    for(int is=0; is<MAXSAILS; is++) m_SailAngle[is] = m_MatrixSailAngle[is] = 0.0;
+    m_bRefMatrix = false;
+    m_bTrimSolver = m_bRestReady = false;
+    m_bLegsReady = m_bRotated = false;
+    m_RefBeta = m_RefPhi = 0.0;
+    for(int is=0; is<MAXSAILS; is++) m_RefSailAngle[is] = 0.0;
+
     m_MatSize        = 0;
     m_nNodes         = 0;
 
@@ -79,20 +104,91 @@ BoatAnalysisDlg::BoatAnalysisDlg()
     m_pBoatPolar = nullptr;
     m_pBoat  = nullptr;
 
-    memset(m_Sigma,  0, sizeof(m_Sigma));
-    memset(m_Mu,     0, sizeof(m_Mu));
-    memset(m_Cp,     0, sizeof(m_Cp));
-    memset(m_Speed,  0, sizeof(m_Speed));
+    m_MaxMatSize = 0;
+    m_Sigma = m_Mu = m_Cp = m_RHS = m_uWake = m_wWake = nullptr;
+    m_VMuDerivative = m_Speed = nullptr;
+    m_Index = nullptr;
+
+    m_nBlocks = 0;
+    m_BlockLUSize = 0;
+    m_pBlockLU = nullptr;
+    m_bMixedFallback = false;
+}
+
+
+BoatAnalysisDlg::~BoatAnalysisDlg()
+{
+    ReleaseArrays();
+}
+
+
+bool BoatAnalysisDlg::AllocateArrays(int MatSize)
+{
+    //
+    // Makes sure the work arrays can hold MatSize panels
+    // The arrays are only grown, so that the memory is reused from one analysis to the next
+    //
+    if(MatSize<=m_MaxMatSize) return true;
+
+    ReleaseArrays();
+
+    size_t RHSSize = size_t(MatSize) * size_t(VLMMAXRHS);
 
-    memset(m_Cp,0,sizeof(m_Cp));
-    memset(m_RHS, 0, sizeof(m_RHS));
+    m_Sigma         = new (std::nothrow) double[RHSSize];
+    m_Mu            = new (std::nothrow) double[RHSSize];
+    m_Cp            = new (std::nothrow) double[RHSSize];
+    m_VMuDerivative = new (std::nothrow) Vector3d[MatSize];
+    m_RHS           = new (std::nothrow) double[RHSSize];
+    m_uWake         = new (std::nothrow) double[MatSize];
+    m_wWake         = new (std::nothrow) double[MatSize];
+    m_Index         = new (std::nothrow) int[MatSize];
+    m_Speed         = new (std::nothrow) Vector3d[MatSize];
 
-    memset(m_VMuDerivative, 0, sizeof(m_VMuDerivative));
+    if(!m_Sigma || !m_Mu || !m_Cp || !m_VMuDerivative || !m_RHS ||
+       !m_uWake || !m_wWake || !m_Index || !m_Speed)
+    {
+        ReleaseArrays();
+        return false;
+    }
+
+    memset(m_Sigma, 0, RHSSize*sizeof(double));
+    memset(m_Mu,    0, RHSSize*sizeof(double));
+    memset(m_Cp,    0, RHSSize*sizeof(double));
+    memset(m_RHS,   0, RHSSize*sizeof(double));
+
+    m_MaxMatSize = MatSize;
+    return true;
+}
+
+
+void BoatAnalysisDlg::ReleaseArrays()
+{
+    delete [] m_Sigma;          m_Sigma         = nullptr;
+    delete [] m_Mu;             m_Mu            = nullptr;
+    delete [] m_Cp;             m_Cp            = nullptr;
+    delete [] m_VMuDerivative;  m_VMuDerivative = nullptr;
+    delete [] m_RHS;            m_RHS           = nullptr;
+    delete [] m_uWake;          m_uWake         = nullptr;
+    delete [] m_wWake;          m_wWake         = nullptr;
+    delete [] m_Index;          m_Index         = nullptr;
+    delete [] m_Speed;          m_Speed         = nullptr;
+    delete [] m_pBlockLU;       m_pBlockLU      = nullptr;
+    m_BlockLUSize = 0;
+    m_HMatrix.Clear();
+
+    m_MaxMatSize = 0;
 }
 
 
 
 void BoatAnalysisDlg::AddString(QString strong)
+{
+    //may be called from the analysis thread
+    emit AnalysisMessage(strong);
+}
+
+
+void BoatAnalysisDlg::OnMessage(QString strong)
 {
     m_pctrlTextOutput->insertPlainText(strong);
     m_pctrlTextOutput->ensureCursorVisible();
@@ -101,48 +197,737 @@ void BoatAnalysisDlg::AddString(QString strong)
 
 
 
-void BoatAnalysisDlg::BuildInfluenceMatrix()
+void BoatAnalysisDlg::BuildInfluenceMatrix(bool const *pbMoved, bool bColumnsOnly)
+{
+    //The matrix is built in s_aijRef by square tiles of MATRIXTILESIZE rows and columns,
+    //which are distributed between the available threads.
+    //Each coefficient is computed independently of the others, so that the result
+    //does not depend on the number of threads nor on the order of the tiles.
+    //If pbMoved is set, only the rows and columns of the panels which have moved are rebuilt,
+    //the other coefficients are those of the previous geometry.
+    //If bColumnsOnly is also set, only the columns of these panels are rebuilt.
+    //The vortices of the thin panels and the doublets of the thick panels of each tile
+    //are evaluated together by the batch kernels.
+    int nTiles;
+    std::atomic<int> nDone(0);
+    std::vector<int> nMoved(m_MatSize+1, 0); // the number of moved panels before each panel
+
+    bool bBatch = !m_bWakeRollUp;
+    if(bBatch) BuildVortexBatch();
+    BuildPanelBatch();
+
+    if(pbMoved)
+    {
+        for(int p=0; p<m_MatSize; p++) nMoved[ulong(p+1)] = nMoved[ulong(p)] + (pbMoved[p] ? 1 : 0);
+    }
+    else AddString("      Creating the influence matrix...\n");
+
+    nTiles = (m_MatSize+MATRIXTILESIZE-1)/MATRIXTILESIZE;
+    double Progress0 = m_Progress;
+
+    ParallelFor(nTiles*nTiles, [&](int it)
+    {
+        int pStart  = (it/nTiles) * MATRIXTILESIZE;
+        int pEnd    = std::min(pStart+MATRIXTILESIZE, m_MatSize);
+        int ppStart = (it%nTiles) * MATRIXTILESIZE;
+        int ppEnd   = std::min(ppStart+MATRIXTILESIZE, m_MatSize);
+
+        bool bColsMoved = true;
+        if(pbMoved)
+        {
+            bColsMoved = nMoved[ulong(ppEnd)]>nMoved[ulong(ppStart)];
+            if(!bColsMoved && (bColumnsOnly || nMoved[ulong(pEnd)]==nMoved[ulong(pStart)]))
+            {
+                //nothing has changed in this tile
+                nDone++;
+                return;
+            }
+        }
+
+        BatchBuffer Buffer;
+
+        for(int p=pStart; p<pEnd; p++)
+        {
+            //for each Boundary Condition point
+            bool bRowMoved = !pbMoved || (!bColumnsOnly && pbMoved[p]);
+            if(!bRowMoved && !bColsMoved) continue;
+
+            double *aij = s_aijRef + p*m_MatSize;
+            if(!bRowMoved)
+            {
+                //only the columns of the moved panels are rebuilt
+                InfluenceRow(p, ppStart, ppEnd, aij, pbMoved, false);
+                continue;
+            }
+
+            BatchInfluenceRow(p, ppStart, ppEnd, aij, bBatch, Buffer, nullptr);
+
+            //the thin panels which are not batched, i.e. with wake roll-up
+            if(!bBatch) InfluenceRow(p, ppStart, ppEnd, aij, nullptr, true);
+        }
+        nDone++;
+    },
+    [&]()
+    {
+        //called from the analysis thread only
+        SetProgress(Progress0 + 10.0*double(m_MatSize)/400. * double(nDone)/double(nTiles*nTiles));
+        return !m_bCancel;
+    });
+}
+
+
+void BoatAnalysisDlg::BuildTrefftzPlane(double const *Mu)
+{
+    //
+    // Lists the trailing legs of the thin panels with their current strengths,
+    // as evaluated by VLMGetVortexInfluence() with bAll=false and without wake roll-up
+    // The hulls shed no wake, and the influence of their panels vanishes far downstream
+    //
+    Vector3d AA1, BB1;
+
+    m_TrefftzPlane.Clear();
+    m_TrefftzPlane.SetWind(m_WindDirection, m_pBoatPolar->m_bGround, m_pBoatPolar->m_Height);
+
+    for(int pp=0; pp<m_MatSize; pp++)
+    {
+        CPanel const *pPanel = s_pPanel+pp;
+        if(pPanel->m_Pos!=MIDSURFACE) continue;
+
+        if(m_pBoatPolar->m_bVLM1)
+        {
+            m_TrefftzPlane.AddLeg(pPanel->VA, -Mu[pp]);
+            m_TrefftzPlane.AddLeg(pPanel->VB,  Mu[pp]);
+        }
+        else if(pPanel->m_bIsTrailing)
+        {
+            AA1.x = s_pNode[pPanel->m_iTA].x + (s_pNode[pPanel->m_iTA].x-pPanel->VA.x)/3.0;
+            AA1.y = s_pNode[pPanel->m_iTA].y;
+            AA1.z = s_pNode[pPanel->m_iTA].z;
+            BB1.x = s_pNode[pPanel->m_iTB].x + (s_pNode[pPanel->m_iTB].x-pPanel->VB.x)/3.0;
+            BB1.y = s_pNode[pPanel->m_iTB].y;
+            BB1.z = s_pNode[pPanel->m_iTB].z;
+            m_TrefftzPlane.AddLeg(AA1, -Mu[pp]);
+            m_TrefftzPlane.AddLeg(BB1,  Mu[pp]);
+        }
+    }
+}
+
+
+void BoatAnalysisDlg::InfluenceRow(int p, int ppStart, int ppEnd, double *aij, bool const *pbColumns, bool bThinOnly) const
 {
+    //
+    // Sets the coefficients aij[pp] of the row p of the influence matrix, for the columns pp=ppStart...ppEnd-1
+    // which are set in pbColumns if it is not null, and which are thin if bThinOnly is true.
+    //
+    CPanel const *pPanel = s_pPanel;
     Vector3d C, V;
-    int m, mm, p, pp;
     double phi;
 
-    AddString("      Creating the influence matrix...\n");
+    if(pPanel[p].m_Pos!=MIDSURFACE) C = pPanel[p].CollPt;
+    else                            C = pPanel[p].CtrlPt;
 
-    m=0;
-    for(p=0; p<m_MatSize; p++)
+    //the BC is set on the potential for the thick panels with Dirichlet BC, on the normal velocity otherwise
+    bool bPotential = m_pBoatPolar->m_bDirichlet && pPanel[p].m_Pos!=MIDSURFACE;
+    Vector3d const &Normal = pPanel[p].Normal;
+
+    for(int pp=ppStart; pp<ppEnd; pp++)
     {
-        if(m_bCancel) return;
+        if(pbColumns && !pbColumns[pp]) continue;
+        if(bThinOnly && pPanel[pp].m_Pos!=MIDSURFACE) continue;
 
-        //for each Boundary Condition point
-        if(s_pPanel[p].m_Pos!=MIDSURFACE)
+        GetDoubletInfluence(C, pPanel+pp, V, phi, false, true);
+        if(bPotential) aij[pp] = phi;
+        else           aij[pp] = V.x*Normal.x + V.y*Normal.y + V.z*Normal.z;
+    }
+}
+
+
+void BoatAnalysisDlg::BatchInfluenceRow(int p, int ppStart, int ppEnd, double *aij, bool bVortices, BatchBuffer &Buffer,
+                                        SweepWorker const *pWorker) const
+{
+    //
+    // Sets the coefficients aij[pp] of the row p of the influence matrix, for the columns pp=ppStart...ppEnd-1,
+    // with the batch kernels : those of the thick panels, and those of the thin panels if bVortices is true.
+    // If pWorker is set, the panels and the batches are those of the worker's geometry.
+    //
+    CPanel const *pPanel = pWorker ? pWorker->Panel.data() : s_pPanel;
+    VortexBatch const &Vortices       = pWorker ? pWorker->Vortices     : m_VortexBatch;
+    std::vector<int> const &SegStart  = pWorker ? pWorker->SegmentStart : m_SegmentStart;
+    PanelBatch const &Thick           = pWorker ? pWorker->Thick        : m_PanelBatch;
+    std::vector<int> const &ThickStart = pWorker ? pWorker->ThickStart  : m_ThickStart;
+    Vector3d C, V;
+
+    //Thick surfaces, 3D-panel type BC, use collocation point
+    //Thin surface, VLM type BC, use control point
+    if(pPanel[p].m_Pos!=MIDSURFACE) C = pPanel[p].CollPt;
+    else                            C = pPanel[p].CtrlPt;
+
+    //the segments of the columns, and their velocities at the BC point
+    int s0 = 0, s1 = 0, nSegments = 0;
+    if(bVortices)
+    {
+        s0 = SegStart[ulong(ppStart)];
+        s1 = SegStart[ulong(ppEnd)];
+        nSegments = s1-s0;
+        Buffer.Vx.resize(ulong(nSegments));  Buffer.Vy.resize(ulong(nSegments));  Buffer.Vz.resize(ulong(nSegments));
+    }
+    //the thick panels of the columns, and their doublet influences at the BC point
+    int t0 = ThickStart[ulong(ppStart)];
+    int t1 = ThickStart[ulong(ppEnd)];
+    int nThick = t1-t0;
+    Buffer.DVx.resize(ulong(nThick));  Buffer.DVy.resize(ulong(nThick));
+    Buffer.DVz.resize(ulong(nThick));  Buffer.DPhi.resize(ulong(nThick));
+
+    //the velocities induced by the vortices of the thin panels, and by their images
+    //the vortices have no potential, hence no influence on the thick panels with Dirichlet BC
+    bool bVelocity = !m_pBoatPolar->m_bDirichlet || pPanel[p].m_Pos==MIDSURFACE;
+    if(bVortices && bVelocity && nSegments>0)
+        Vortices.Velocities(C, s0, s1, CPanel::s_pCoreSize, Buffer.Vx.data(), Buffer.Vy.data(), Buffer.Vz.data());
+
+    //the doublet influences of the thick panels, and of their images
+    if(nThick>0)
+        Thick.Doublets(C, t0, t1, Buffer.DVx.data(), Buffer.DVy.data(), Buffer.DVz.data(), Buffer.DPhi.data());
+
+    for(int pp=ppStart; pp<ppEnd; pp++)
+    {
+        if(pPanel[pp].m_Pos==MIDSURFACE)
         {
-            //Thick surfaces, 3D-panel type BC, use collocation point
-            C = s_pPanel[p].CollPt;
+            if(!bVortices) continue;
+            if(!bVelocity)
+            {
+                aij[pp] = 0.0;
+                continue;
+            }
+            V.Set(0.0, 0.0, 0.0);
+            for(int k=SegStart[ulong(pp)]-s0; k<SegStart[ulong(pp+1)]-s0; k++)
+            {
+                V.x += Buffer.Vx[ulong(k)];
+                V.y += Buffer.Vy[ulong(k)];
+                V.z += Buffer.Vz[ulong(k)];
+            }
+            aij[pp] = V.dot(pPanel[p].Normal);
         }
         else
         {
-            //Thin surface, VLM type BC, use control point
-            C = s_pPanel[p].CtrlPt;
+            ulong k = ulong(ThickStart[ulong(pp)]-t0);
+            V.Set(Buffer.DVx[k], Buffer.DVy[k], Buffer.DVz[k]);
+            if(bVelocity) aij[pp] = V.dot(pPanel[p].Normal);
+            else          aij[pp] = Buffer.DPhi[k];
         }
+    }
+}
 
-        mm = 0;
-        for(pp=0; pp<m_MatSize; pp++)
+
+void BoatAnalysisDlg::BuildVortexBatch(SweepWorker *pWorker)
+{
+    //
+    // Lists the vortex segments of the thin panels, as evaluated one panel at a time by VLMGetVortexInfluence()
+    // without wake roll-up
+    // If pWorker is set, the segments are those of the worker's geometry, and are stored in the worker
+    //
+    Vector3d AA1, BB1;
+
+    CPanel const *pPanelArray     = pWorker ? pWorker->Panel.data() : s_pPanel;
+    Vector3d const *pNode         = pWorker ? pWorker->Node.data()  : s_pNode;
+    Vector3d const &WindDirection = pWorker ? pWorker->WindDirection : m_WindDirection;
+    VortexBatch &Vortices         = pWorker ? pWorker->Vortices     : m_VortexBatch;
+    std::vector<int> &SegStart    = pWorker ? pWorker->SegmentStart : m_SegmentStart;
+
+    Vortices.Clear();
+    Vortices.SetGround(m_pBoatPolar->m_bGround, m_pBoatPolar->m_Height);
+    SegStart.resize(ulong(m_MatSize+1));
+
+    for(int pp=0; pp<m_MatSize; pp++)
+    {
+        SegStart[ulong(pp)] = Vortices.Size();
+        CPanel const *pPanel = pPanelArray+pp;
+        if(pPanel->m_Pos!=MIDSURFACE) continue;
+
+        if(m_pBoatPolar->m_bVLM1)
         {
-            if(m_bCancel) return;
+            Vortices.AddHorseshoe(pPanel->VA, pPanel->VB, WindDirection);
+        }
+        else if(!pPanel->m_bIsTrailing)
+        {
+            int p = pPanel->m_iElement;
+            Vortices.AddRing(pPanel->VA, pPanel->VB, pPanelArray[p-1].VA, pPanelArray[p-1].VB);
+        }
+        else
+        {
+            AA1.x = pNode[pPanel->m_iTA].x + (pNode[pPanel->m_iTA].x-pPanel->VA.x)/3.0;
+            AA1.y = pNode[pPanel->m_iTA].y;
+            AA1.z = pNode[pPanel->m_iTA].z;
+            BB1.x = pNode[pPanel->m_iTB].x + (pNode[pPanel->m_iTB].x-pPanel->VB.x)/3.0;
+            BB1.y = pNode[pPanel->m_iTB].y;
+            BB1.z = pNode[pPanel->m_iTB].z;
+            Vortices.AddRing(pPanel->VA, pPanel->VB, AA1, BB1);
+            Vortices.AddHorseshoe(AA1, BB1, WindDirection);
+        }
+    }
+    SegStart[ulong(m_MatSize)] = Vortices.Size();
+}
 
-            //for each panel, get the unit doublet or vortex influence at the boundary condition pt
-            GetDoubletInfluence(C, s_pPanel+pp, V, phi);
-            if(!m_pBoatPolar->m_bDirichlet || s_pPanel[p].m_Pos==MIDSURFACE) s_aij[m*m_MatSize+mm] = V.dot(s_pPanel[p].Normal);
-            else if(m_pBoatPolar->m_bDirichlet)                               s_aij[m*m_MatSize+mm] = phi;
 
-            mm++;
+void BoatAnalysisDlg::BuildPanelBatch(SweepWorker *pWorker)
+{
+    //
+    // Lists the thick panels, as evaluated one panel at a time by GetDoubletInfluence() and GetSourceInfluence()
+    // If pWorker is set, the panels are those of the worker's geometry, and are stored in the worker
+    //
+    CPanel const *pPanel         = pWorker ? pWorker->Panel.data() : s_pPanel;
+    Vector3d const *pNode        = pWorker ? pWorker->Node.data()  : s_pNode;
+    PanelBatch &Thick            = pWorker ? pWorker->Thick        : m_PanelBatch;
+    std::vector<int> &ThickStart = pWorker ? pWorker->ThickStart   : m_ThickStart;
+
+    Thick.Clear();
+    Thick.SetGround(m_pBoatPolar->m_bGround, m_pBoatPolar->m_Height);
+    ThickStart.resize(ulong(m_MatSize+1));
+
+    for(int pp=0; pp<m_MatSize; pp++)
+    {
+        ThickStart[ulong(pp)] = Thick.Size();
+        if(pPanel[pp].m_Pos!=MIDSURFACE) Thick.AddPanel(pPanel[pp], pNode);
+    }
+    ThickStart[ulong(m_MatSize)] = Thick.Size();
+}
+
+
+void BoatAnalysisDlg::UpdateInfluenceMatrix()
+{
+    //
+    // Brings the assembled matrix s_aijRef up to date with the current geometry
+    // If only the angles of some sails have changed since it was built, only the rows and columns
+    // of these sails' panels are rebuilt : the influences between the hull and the other sails are unchanged
+    // If the boat has only been heeled or headed as a whole, and without ground effect, only the columns
+    // of the panels with trailing legs are rebuilt : the other influences are invariant by rotation
+    //
+    QString strong;
+    int is, p;
+
+    bool bSameSails = m_bRefMatrix;
+    for(is=0; is<m_pBoat->m_poaSail.size(); is++)
+    {
+        if(m_SailAngle[is]!=m_RefSailAngle[is]) bSameSails = false;
+    }
+
+    if(m_bRefMatrix && m_Beta==m_RefBeta && m_Phi==m_RefPhi)
+    {
+        bool *pbMoved = new bool[ulong(m_MatSize)];
+        memset(pbMoved, 0, ulong(m_MatSize)*sizeof(bool));
+
+        int nMoved = 0, nSails = 0;
+        for(is=0; is<m_pBoat->m_poaSail.size(); is++)
+        {
+            if(m_SailAngle[is]==m_RefSailAngle[is]) continue;
+            Sail *pSail = m_pBoat->m_poaSail.at(is);
+            for(p=pSail->m_FirstPanel; p<pSail->m_FirstPanel+pSail->m_NElements; p++) pbMoved[p] = true;
+            nMoved += pSail->m_NElements;
+            nSails++;
         }
-        m++;
 
-        m_Progress += 10.0*double(m_MatSize)/400./double(m_MatSize);
-        qApp->processEvents();
+        double Fraction = double(nMoved)/double(m_MatSize);
+        strong = QString("      Updating the influence matrix for %1 trimmed sail(s), i.e. %2% of the coefficients...\n")
+                 .arg(nSails).arg((1.0-(1.0-Fraction)*(1.0-Fraction))*100.0, 0, 'f', 1);
+        AddString(strong);
+
+        BuildInfluenceMatrix(pbMoved);
+        delete [] pbMoved;
+    }
+    else if(bSameSails && !m_pBoatPolar->m_bGround)
+    {
+        bool *pbMoved = new bool[ulong(m_MatSize)];
+
+        int nLegs = 0;
+        for(p=0; p<m_MatSize; p++)
+        {
+            pbMoved[p] = HasTrailingLegs(p);
+            if(pbMoved[p]) nLegs++;
+        }
+
+        strong = QString("      Updating the influence matrix for the %1 panels with trailing legs...\n").arg(nLegs);
+        AddString(strong);
+
+        BuildInfluenceMatrix(pbMoved, true);
+        delete [] pbMoved;
+    }
+    else BuildInfluenceMatrix();
+
+    if(m_bCancel)
+    {
+        m_bRefMatrix = false;
+        return;
+    }
+
+    m_bRefMatrix = true;
+    m_RefBeta = m_Beta;
+    m_RefPhi  = m_Phi;
+    for(is=0; is<m_pBoat->m_poaSail.size(); is++) m_RefSailAngle[is] = m_SailAngle[is];
+}
+
+
+bool BoatAnalysisDlg::HasTrailingLegs(int p) const
+{
+    //
+    // Returns true if the influence of panel p includes trailing legs along the wind direction
+    //
+    if(s_pPanel[p].m_Pos!=MIDSURFACE) return false;
+    return m_pBoatPolar->m_bVLM1 || s_pPanel[p].m_bIsTrailing;
+}
+
+
+void BoatAnalysisDlg::RecordLegColumns()
+{
+    //
+    // Records the columns of the panels with trailing legs of the matrix which has just been factorized,
+    // so that the LU decomposition may be corrected when the boat is heeled or headed as a whole.
+    // This is only worthwhile if these panels are less than about a third of the total.
+    //
+    m_bLegsReady = false;
+    m_bRotated   = false;
+    m_LegPanels.clear();
+    m_LegColumns.clear();
+    if(m_pBoatPolar->m_bGround) return;
+
+    for(int p=0; p<m_MatSize; p++)
+    {
+        if(HasTrailingLegs(p)) m_LegPanels.push_back(p);
+    }
+    int nLegs = int(m_LegPanels.size());
+    if(3*nLegs>m_MatSize)
+    {
+        m_LegPanels.clear();
+        return;
+    }
+
+    m_LegColumns.resize(ulong(nLegs*m_MatSize));
+    for(int j=0; j<nLegs; j++)
+    {
+        double *pCol = m_LegColumns.data() + j*m_MatSize;
+        for(int i=0; i<m_MatSize; i++) pCol[i] = s_aijRef[i*m_MatSize + m_LegPanels[ulong(j)]];
+    }
+    m_bLegsReady = true;
+}
+
+
+bool BoatAnalysisDlg::CorrectRotatedLegs()
+{
+    //
+    // The matrix A of the rotated boat differs from the factorized matrix A0 by the columns of the panels
+    // with trailing legs only, i.e. A = A0 + D.E^T, where D holds the changes of these nL columns,
+    // and E selects them. The Woodbury formula then gives
+    //      A^-1.b = y - Z.(I + E^T.Z)^-1.E^T.y     with y = A0^-1.b  and  Z = A0^-1.D
+    // which requires nL solves with the existing LU decomposition, and the decomposition of
+    // the nL x nL capacitance matrix I + E^T.Z.
+    //
+    int nLegs = int(m_LegPanels.size());
+
+    m_bRotated = false;
+    AddString(QString("      Correcting the LU decomposition for the %1 rotated trailing legs...\n").arg(nLegs));
+    if(nLegs==0)
+    {
+        m_bRotated = true;
+        return true;
+    }
+
+    m_RotatedZ.resize(ulong(nLegs*m_MatSize));
+    for(int j=0; j<nLegs; j++)
+    {
+        double *pZ = m_RotatedZ.data() + j*m_MatSize;
+        double const *pCol = m_LegColumns.data() + j*m_MatSize;
+        for(int i=0; i<m_MatSize; i++) pZ[i] = s_aijRef[i*m_MatSize + m_LegPanels[ulong(j)]] - pCol[i];
+    }
+    if(!Crout_LU_with_Pivoting_Solve_Multiple(s_aij, m_RotatedZ.data(), m_Index, m_RotatedZ.data(), m_MatSize, nLegs, &m_bCancel))
+        return false;
+
+    m_RotatedC.resize(ulong(nLegs*nLegs));
+    m_RotatedIndex.resize(ulong(nLegs));
+    for(int i=0; i<nLegs; i++)
+    {
+        for(int j=0; j<nLegs; j++)
+        {
+            m_RotatedC[ulong(i*nLegs+j)] = (i==j ? 1.0 : 0.0) + m_RotatedZ[ulong(j*m_MatSize + m_LegPanels[ulong(i)])];
+        }
+    }
+    if(!Crout_LU_Decomposition_with_Pivoting(m_RotatedC.data(), m_RotatedIndex.data(), nLegs, &m_bCancel))
+        return false;
+
+    m_bRotated = true;
+    return true;
+}
+
+
+bool BoatAnalysisDlg::SolveRotated(int nRHS)
+{
+    //
+    // Solves the nRHS right hand sides with the LU decomposition of s_aij corrected by CorrectRotatedLegs()
+    // The solutions are returned in s_RHS
+    //
+    int nLegs = int(m_LegPanels.size());
+
+    if(!Crout_LU_with_Pivoting_Solve_Multiple(s_aij, m_RHS, m_Index, s_RHS, m_MatSize, nRHS, &m_bCancel))
+        return false;
+    if(nLegs==0) return true;
+
+    std::vector<double> w(nLegs), t(nLegs);
+    for(int r=0; r<nRHS; r++)
+    {
+        double *y = s_RHS + r*m_MatSize;
+        for(int i=0; i<nLegs; i++) w[ulong(i)] = y[m_LegPanels[ulong(i)]];
+        if(!Crout_LU_with_Pivoting_Solve(m_RotatedC.data(), w.data(), m_RotatedIndex.data(), t.data(), nLegs, &m_bCancel))
+            return false;
+
+        for(int j=0; j<nLegs; j++)
+        {
+            double const *pZ = m_RotatedZ.data() + j*m_MatSize;
+            for(int i=0; i<m_MatSize; i++) y[i] -= pZ[i]*t[ulong(j)];
+        }
     }
+    return true;
+}
+
+
+void BoatAnalysisDlg::SetTrimSolver(int nrhs)
+{
+    //
+    // If only some sails are trimmed along the polar, with the heel and the wind direction unchanged,
+    // the block of the influence matrix between the other panels is the same for all the points.
+    // This block is factorized once, and each point only factorizes the Schur complement over the
+    // panels of the trimmed sails. This is cheaper than a full LU decomposition as long as
+    // these panels are less than about a third of the total.
+    // With a single control point, the block would be factorized for nothing.
+    //
+    int is, p;
+
+    m_bTrimSolver = false;
+    m_bRestReady  = false;
+    m_TrimRest.clear();
+    m_TrimMoved.clear();
+
+    if(nrhs<2 || m_ControlMin==m_ControlMax) return;
+    if(m_pBoatPolar->m_bIterativeSolver || m_pBoatPolar->m_bMixedPrecision) return;
+    if(m_pBoatPolar->m_PhiMin!=m_pBoatPolar->m_PhiMax || m_pBoatPolar->m_BetaMin!=m_pBoatPolar->m_BetaMax) return;
+
+    std::vector<bool> bMoved(m_MatSize, false);
+    for(is=0; is<m_pBoat->m_poaSail.size(); is++)
+    {
+        if(m_pBoatPolar->m_SailAngleMin[is]==m_pBoatPolar->m_SailAngleMax[is]) continue;
+        Sail *pSail = m_pBoat->m_poaSail.at(is);
+        for(p=pSail->m_FirstPanel; p<pSail->m_FirstPanel+pSail->m_NElements; p++) bMoved[ulong(p)] = true;
+    }
+    for(p=0; p<m_MatSize; p++)
+    {
+        if(bMoved[ulong(p)]) m_TrimMoved.push_back(p);
+        else                 m_TrimRest.push_back(p);
+    }
+
+    if(m_TrimMoved.empty() || m_TrimRest.empty() || 3*int(m_TrimMoved.size())>m_MatSize)
+    {
+        m_TrimRest.clear();
+        m_TrimMoved.clear();
+        return;
+    }
+    m_bTrimSolver = true;
+}
+
+
+bool BoatAnalysisDlg::FactorizeSchurComplement()
+{
+    //
+    // The unknowns are split in the panels R of the fixed surfaces and the panels S of the trimmed sails
+    // s_aij holds successively the LU decomposition of A_RR, X = A_RR^-1.A_RS column by column,
+    // and the LU decomposition of the Schur complement A_SS - A_SR.X
+    // The pivots are stored in m_Index, first those of A_RR then those of the Schur complement
+    //
+    int nR = int(m_TrimRest.size());
+    int nS = int(m_TrimMoved.size());
+    size_t N = size_t(m_MatSize);
+    double *LURest = s_aij;
+    double *X      = LURest + size_t(nR)*size_t(nR);
+    double *Schur  = X + size_t(nR)*size_t(nS);
+
+    if(!m_bRestReady)
+    {
+        AddString(QString("      Performing LU decomposition for the %1 panels of the fixed surfaces...\n").arg(nR));
+        ParallelFor(nR, [&](int i)
+        {
+            double const *a = s_aijRef + size_t(m_TrimRest[ulong(i)])*N;
+            double *l = LURest + size_t(i)*size_t(nR);
+            for(int j=0; j<nR; j++) l[j] = a[m_TrimRest[ulong(j)]];
+        });
+        if(!Crout_LU_Decomposition_with_Pivoting(LURest, m_Index, nR, &m_bCancel)) return false;
+        m_bRestReady = true;
+    }
+
+    AddString(QString("      Factorizing the Schur complement for the %1 panels of the trimmed sails...\n").arg(nS));
+
+    ParallelFor(nS, [&](int j)
+    {
+        int pp = m_TrimMoved[ulong(j)];
+        double *x = X + size_t(j)*size_t(nR);
+        for(int i=0; i<nR; i++) x[i] = s_aijRef[size_t(m_TrimRest[ulong(i)])*N + size_t(pp)];
+    });
+    if(!Crout_LU_with_Pivoting_Solve_Multiple(LURest, X, m_Index, X, nR, nS, &m_bCancel)) return false;
+
+    ParallelFor(nS, [&](int i)
+    {
+        double const *a = s_aijRef + size_t(m_TrimMoved[ulong(i)])*N;
+        double *s = Schur + size_t(i)*size_t(nS);
+        std::vector<double> aR(nR);
+        for(int r=0; r<nR; r++) aR[ulong(r)] = a[m_TrimRest[ulong(r)]];
+        for(int j=0; j<nS; j++)
+        {
+            double const *x = X + size_t(j)*size_t(nR);
+            double sum = a[m_TrimMoved[ulong(j)]];
+            for(int r=0; r<nR; r++) sum -= aR[ulong(r)] * x[r];
+            s[j] = sum;
+        }
+    });
+    if(m_bCancel) return false;
+
+    return Crout_LU_Decomposition_with_Pivoting(Schur, m_Index+nR, nS, &m_bCancel);
+}
+
+
+bool BoatAnalysisDlg::SolveSchurComplement(int nRHS)
+{
+    //
+    // Solves the nRHS systems with the factorization of FactorizeSchurComplement() :
+    //     y_R = A_RR^-1.b_R
+    //     x_S = Schur^-1.(b_S - A_SR.y_R)
+    //     x_R = y_R - X.x_S
+    // The solutions are returned in s_RHS
+    //
+    int nR = int(m_TrimRest.size());
+    int nS = int(m_TrimMoved.size());
+    size_t N = size_t(m_MatSize);
+    double *LURest = s_aij;
+    double *X      = LURest + size_t(nR)*size_t(nR);
+    double *Schur  = X + size_t(nR)*size_t(nS);
+    int i, r;
+
+    std::vector<double> BR(size_t(nR)*size_t(nRHS)), BS(size_t(nS)*size_t(nRHS));
+    for(r=0; r<nRHS; r++)
+    {
+        for(i=0; i<nR; i++) BR[size_t(r)*nR+i] = m_RHS[size_t(r)*N+size_t(m_TrimRest[ulong(i)])];
+        for(i=0; i<nS; i++) BS[size_t(r)*nS+i] = m_RHS[size_t(r)*N+size_t(m_TrimMoved[ulong(i)])];
+    }
+
+    if(!Crout_LU_with_Pivoting_Solve_Multiple(LURest, BR.data(), m_Index, BR.data(), nR, nRHS, &m_bCancel)) return false;
+
+    ParallelFor(nS, [&](int is)
+    {
+        double const *a = s_aijRef + size_t(m_TrimMoved[ulong(is)])*N;
+        for(int rr=0; rr<nRHS; rr++)
+        {
+            double const *y = BR.data() + size_t(rr)*nR;
+            double sum = 0.0;
+            for(int k=0; k<nR; k++) sum += a[m_TrimRest[ulong(k)]] * y[k];
+            BS[size_t(rr)*nS+is] -= sum;
+        }
+    });
+
+    if(!Crout_LU_with_Pivoting_Solve_Multiple(Schur, BS.data(), m_Index+nR, BS.data(), nS, nRHS, &m_bCancel)) return false;
+
+    for(r=0; r<nRHS; r++)
+    {
+        double *y = BR.data() + size_t(r)*nR;
+        double const *z = BS.data() + size_t(r)*nS;
+        for(int j=0; j<nS; j++)
+        {
+            double const *x = X + size_t(j)*size_t(nR);
+            for(i=0; i<nR; i++) y[i] -= x[i] * z[j];
+        }
+        for(i=0; i<nR; i++) s_RHS[size_t(r)*N+size_t(m_TrimRest[ulong(i)])]  = y[i];
+        for(i=0; i<nS; i++) s_RHS[size_t(r)*N+size_t(m_TrimMoved[ulong(i)])] = z[i];
+    }
+    return true;
+}
+
+
+void BoatAnalysisDlg::BuildPanelTree()
+{
+    //
+    // Sorts the panels of the current geometry in the tree used to evaluate their influences
+    // The far field expansions are used only by the matrix-free solver ; otherwise all the panels
+    // are evaluated exactly, so that the results are the same as with the influence matrix
+    //
+    double Accuracy = m_pBoatPolar->m_bMatrixFree ? m_pBoatPolar->m_TreeAccuracy : 0.0;
+    m_PanelTree.Build(s_pPanel, m_MatSize, s_pNode, m_pBoatPolar->m_bVLM1, m_WindDirection,
+                      m_pBoatPolar->m_bGround, m_pBoatPolar->m_Height, Accuracy);
+}
+
+
+void BoatAnalysisDlg::BuildHMatrix()
+{
+    //
+    // Builds the influence matrix in hierarchical form, with the same coefficients as in BuildInfluenceMatrix()
+    //
+    QString strong;
+
+    AddString("      Creating the hierarchical influence matrix...\n");
+
+    double Progress0 = m_Progress;
+    bool bDone = m_HMatrix.Build(s_pPanel, m_MatSize, m_pBoatPolar->m_bVLM1, m_WindDirection,
+                                 [this](int p, int pp){return InfluenceCoefficient(p, pp);},
+                                 m_pBoatPolar->m_HMatrixAccuracy,
+                                 [&](double Done)
+    {
+        //called from the analysis thread only
+        SetProgress(Progress0 + 10.0*double(m_MatSize)/400. * Done);
+        return !m_bCancel;
+    });
+    if(!bDone) return;
+
+    double Ratio = double(m_HMatrix.StorageSize())/double(m_MatSize)/double(m_MatSize);
+    strong = QString("      The hierarchical matrix uses %1 MB, i.e. %2% of the full matrix\n")
+             .arg(double(m_HMatrix.StorageSize())*sizeof(double)/1024./1024., 0, 'f', 1)
+             .arg(Ratio*100.0, 0, 'f', 1);
+    AddString(strong);
+}
+
+
+double BoatAnalysisDlg::InfluenceCoefficient(int p, int pp) const
+{
+    // returns the coefficient (p, pp) of the influence matrix, as set in BuildInfluenceMatrix()
+    Vector3d C, V;
+    double phi;
+
+    if(s_pPanel[p].m_Pos!=MIDSURFACE) C = s_pPanel[p].CollPt;
+    else                              C = s_pPanel[p].CtrlPt;
+
+    GetDoubletInfluence(C, s_pPanel+pp, V, phi);
+    if(!m_pBoatPolar->m_bDirichlet || s_pPanel[p].m_Pos==MIDSURFACE) return V.dot(s_pPanel[p].Normal);
+    return phi;
+}
+
+
+void BoatAnalysisDlg::TreeProduct(double const *x, double *y)
+{
+    //
+    // y = A.x, where A is the influence matrix which is not built
+    // The doublet strengths x are set in the panel tree, and their influence
+    // is evaluated at each boundary condition point
+    //
+    int nBlocks = (m_MatSize+MATRIXTILESIZE-1)/MATRIXTILESIZE;
+
+    m_PanelTree.SetStrengths(x, nullptr);
+
+    ParallelFor(nBlocks, [&](int ib)
+    {
+        Vector3d C, V;
+        double phi;
+        int pStart = ib*MATRIXTILESIZE;
+        int pEnd   = std::min(pStart+MATRIXTILESIZE, m_MatSize);
+        for(int p=pStart; p<pEnd; p++)
+        {
+            if(s_pPanel[p].m_Pos!=MIDSURFACE) C = s_pPanel[p].CollPt;
+            else                              C = s_pPanel[p].CtrlPt;
+
+            m_PanelTree.GetVelocity(C, V, phi);
+            if(!m_pBoatPolar->m_bDirichlet || s_pPanel[p].m_Pos==MIDSURFACE) y[p] = V.dot(s_pPanel[p].Normal);
+            else                                                              y[p] = phi;
+        }
+    });
 }
 
 
@@ -181,6 +966,53 @@ void BoatAnalysisDlg::CreateRHS(double *RHS)
 
     m = 0;
 
+    if(m_pBoatPolar->m_bMatrixFree)
+    {
+        // The source strengths depend on the wind factor at the boundary condition point,
+        // which only scales their influence : evaluate the influence of the sources for the unit wind
+        // factor with the panel tree, then scale it at each point
+        std::vector<double> Sigma(m_MatSize), Factor(m_MatSize);
+        for (pp=0; pp<m_MatSize; pp++)
+        {
+            if(s_pPanel[pp].m_Pos!=MIDSURFACE) Sigma[ulong(pp)] = -1.0/4.0/PI * s_pPanel[pp].Normal.dot(m_VInf);
+            else                               Sigma[ulong(pp)] = 0.0;
+
+            if(s_pPanel[pp].m_Pos!=MIDSURFACE) Factor[ulong(pp)] = m_pBoatPolar->WindFactor(s_pPanel[pp].CollPt.z);
+            else                               Factor[ulong(pp)] = m_pBoatPolar->WindFactor(s_pPanel[pp].CtrlPt.z);
+        }
+        m_PanelTree.SetStrengths(nullptr, Sigma.data());
+
+        int nBlocks = (m_MatSize+MATRIXTILESIZE-1)/MATRIXTILESIZE;
+        ParallelFor(nBlocks, [&](int ib)
+        {
+            Vector3d C, V, VPanel;
+            double phi;
+            int pStart = ib*MATRIXTILESIZE;
+            int pEnd   = std::min(pStart+MATRIXTILESIZE, m_MatSize);
+            for(int p=pStart; p<pEnd; p++)
+            {
+                if(s_pPanel[p].m_Pos!=MIDSURFACE) C = s_pPanel[p].CollPt;
+                else                              C = s_pPanel[p].CtrlPt;
+
+                double factor = Factor[ulong(p)];
+                VPanel = m_VInf * factor;
+                m_PanelTree.GetVelocity(C, V, phi);
+
+                if(!m_pBoatPolar->m_bDirichlet || s_pPanel[p].m_Pos==MIDSURFACE)
+                    RHS[p] = -s_pPanel[p].Normal.dot(VPanel) - V.dot(s_pPanel[p].Normal) * factor;
+                else
+                    RHS[p] = -phi * factor;
+            }
+        });
+        SetProgress(m_Progress + 10.0);
+        return;
+    }
+
+    //the source influences of all the thick panels at the current BC point, evaluated by batches
+    BuildPanelBatch();
+    int nThick = m_PanelBatch.Size();
+    std::vector<double> SVx(ulong(nThick)), SVy(ulong(nThick)), SVz(ulong(nThick)), SPhi(ulong(nThick));
+
     for (p=0; p<m_MatSize; p++)
     {
         if(m_bCancel) return;
@@ -190,6 +1022,8 @@ void BoatAnalysisDlg::CreateRHS(double *RHS)
 
         VPanel = m_VInf* m_pBoatPolar->WindFactor(C.z);
 
+        if(nThick>0) m_PanelBatch.Sources(C, 0, nThick, SVx.data(), SVy.data(), SVz.data(), SPhi.data());
+
         if(!m_pBoatPolar->m_bDirichlet || s_pPanel[p].m_Pos==MIDSURFACE)
         {
             // first term of RHS is -V.n
@@ -207,7 +1041,9 @@ void BoatAnalysisDlg::CreateRHS(double *RHS)
                 sigmapp = -1.0/4.0/PI * s_pPanel[pp].Normal.dot(VPanel);
 
                 // Add to RHS the source influence of panel pp on panel p
-                GetSourceInfluence(C, s_pPanel+pp, V, phi);
+                ulong k = ulong(m_ThickStart[ulong(pp)]);
+                V.Set(SVx[k], SVy[k], SVz[k]);
+                phi = SPhi[k];
 
                 if(!m_pBoatPolar->m_bDirichlet || s_pPanel[p].m_Pos==MIDSURFACE)
                 {
@@ -225,8 +1061,7 @@ void BoatAnalysisDlg::CreateRHS(double *RHS)
         }
         m++;
 
-        m_Progress += 10.0/double(m_MatSize);
-        qApp->processEvents();
+        SetProgress(m_Progress + 10.0/double(m_MatSize));
     }
 }
 
@@ -350,8 +1185,7 @@ void BoatAnalysisDlg::CreateWakeContribution()
 
         }
         m++;
-        m_Progress += 1.0/double(m_MatSize);
-        qApp->processEvents();
+        SetProgress(m_Progress + 1.0/double(m_MatSize));
     }
 }
 
@@ -464,8 +1298,7 @@ void BoatAnalysisDlg::CreateWakeContribution(double *pWakeContrib)
         }
         m++;
 
-        m_Progress += 1.0/double(m_MatSize);
-        qApp->processEvents();
+        SetProgress(m_Progress + 1.0/double(m_MatSize));
     }
 }
 
@@ -479,6 +1312,8 @@ void BoatAnalysisDlg::ComputeFarField()
 
     pos = 0;
 
+    //the downwash is evaluated in the Trefftz plane, from the trailing vortices only
+    BuildTrefftzPlane(m_Mu);
 
     for(int is=0; is<MAXSAILS; is++)
     {
@@ -493,8 +1328,7 @@ void BoatAnalysisDlg::ComputeFarField()
 
             pos += m_pSailList[is]->m_NElements;
 
-            m_Progress += 1.0/400.;
-            qApp->processEvents();
+            SetProgress(m_Progress + 1.0/400.);
             if(m_bCancel)return;
         }
     }
@@ -543,16 +1377,55 @@ void BoatAnalysisDlg::ComputeBoat()
         }
     }
 
-    if(m_pBoat) s_pSail7->AddBoatOpp(m_Cp, m_Mu, m_Sigma, F, M, ForceTrefftz);
+    if(m_pBoat)
+    {
+        //the operating point is built here, and handed over to the GUI thread which stores it
+        BoatOpp *pBoatOpp = new BoatOpp;
+        if(!pBoatOpp->AllocateResults(m_MatSize))
+        {
+            delete pBoatOpp;
+            AddString(tr("Not enough memory to store the operating point")+"\n");
+            m_bWarning = true;
+            return;
+        }
+
+        pBoatOpp->m_bVLM1       = m_pBoatPolar->m_bVLM1;
+        pBoatOpp->m_Beta        = m_Beta;
+        pBoatOpp->m_Phi         = m_Phi;
+        pBoatOpp->m_QInf        = m_QInf;
+        pBoatOpp->m_Ctrl        = m_Ctrl;
+        for(int is=0; is<m_pBoat->m_poaSail.size(); is++)
+        {
+            pBoatOpp->m_SailAngle[is] = m_SailAngle[is];
+        }
+
+        pBoatOpp->F  = F;
+        pBoatOpp->M  = M;
+        pBoatOpp->ForceTrefftz = ForceTrefftz;
+
+        memcpy(pBoatOpp->m_Cp,    m_Cp,    ulong(m_MatSize)*sizeof(double));
+        memcpy(pBoatOpp->m_G,     m_Mu,    ulong(m_MatSize)*sizeof(double));
+        memcpy(pBoatOpp->m_Sigma, m_Sigma, ulong(m_MatSize)*sizeof(double));
+
+        pBoatOpp->m_nWakeNodes     = 0;
+        pBoatOpp->m_NXWakePanels   = 1;
+        pBoatOpp->m_WakeFactor     = 1.0;
+
+        emit AnalysisBoatOpp(pBoatOpp);
+    }
     AddString("\n");
+}
+
+
+void BoatAnalysisDlg::OnBoatOpp(BoatOpp *pBoatOpp)
+{
+    s_pSail7->AddBoatOpp(pBoatOpp);
 
     if(s_pSail7->m_iView==SAILPOLARVIEW)
     {
         s_pSail7->CreateBoatPolarCurves();
         s_pSail7->UpdateView();
     }
-
-    qApp->processEvents();
 }
 
 
@@ -756,8 +1629,7 @@ void BoatAnalysisDlg::ComputeOnBody()
         if(m_bCancel) return;
     }
     if(m_bCancel) return;
-    m_Progress += 1.0;
-    qApp->processEvents();
+    SetProgress(m_Progress + 1.0);
 }
 
 
@@ -765,16 +1637,20 @@ void BoatAnalysisDlg::ComputeOnBody()
 void BoatAnalysisDlg::ComputeSurfSpeeds(double *Mu, double *Sigma)
 {
     int p;
-    Vector3d C;
+    std::vector<Vector3d> C(m_MatSize);
 
     for (p=0; p<m_MatSize; p++)
     {
-        if(m_bCancel) return;
-        C = s_pPanel[p].CollPt;//+ s_pPanel[p].Normal*s_pPanel[p].Size/100.0;
-        C += s_pPanel[p].Normal*0.001;
+        C[ulong(p)] = s_pPanel[p].CollPt;//+ s_pPanel[p].Normal*s_pPanel[p].Size/100.0;
+        C[ulong(p)] += s_pPanel[p].Normal*0.001;
+    }
 
-        GetSpeedVector(C, Mu, Sigma, m_Speed[p]);
-        m_Speed[p] += m_VInf * m_pBoatPolar->WindFactor(C.z);
+    GetSpeedVectors(C.data(), m_MatSize, Mu, Sigma, m_Speed);
+    if(m_bCancel) return;
+
+    for (p=0; p<m_MatSize; p++)
+    {
+        m_Speed[p] += m_VInf * m_pBoatPolar->WindFactor(C[ulong(p)].z);
     }
 }
 
@@ -782,11 +1658,13 @@ void BoatAnalysisDlg::ComputeSurfSpeeds(double *Mu, double *Sigma)
 
 
 
-void BoatAnalysisDlg::GetDoubletInfluence(Vector3d const &C, CPanel *pPanel, Vector3d &V, double &phi, bool bWake, bool bAll)
+void BoatAnalysisDlg::GetDoubletInfluence(Vector3d const &C, CPanel const *pPanel, Vector3d &V, double &phi, bool bWake, bool bAll) const
 {
     // returns the influence of the panel pPanel at point C
     // if the panel pPanel is located on a thin surface, then its the influence of a vortex
     // if it is on a thick surface, then its a doublet
+    Vector3d VG, CG;
+    double phiG;
 
     if(pPanel->m_Pos!=MIDSURFACE || pPanel->m_bIsWakePanel)
     {
@@ -818,10 +1696,12 @@ void BoatAnalysisDlg::GetDoubletInfluence(Vector3d const &C, CPanel *pPanel, Vec
 }
 
 
-void BoatAnalysisDlg::GetSourceInfluence(Vector3d const &C, CPanel *pPanel, Vector3d &V, double &phi)
+void BoatAnalysisDlg::GetSourceInfluence(Vector3d const &C, CPanel const *pPanel, Vector3d &V, double &phi) const
 {
     // returns the influence of a uniform source distribution on the panel pPanel at point C
     // The panel is necessarily located on a thick surface, else the source strength is zero
+    Vector3d VG, CG;
+    double phiG;
 
 
     pPanel->SourceNASA4023(C, V, phi);
@@ -838,7 +1718,7 @@ void BoatAnalysisDlg::GetSourceInfluence(Vector3d const &C, CPanel *pPanel, Vect
 }
 
 
-void BoatAnalysisDlg::GetSpeedVector(Vector3d const &C, double *Mu, double *Sigma, Vector3d &VT, bool bAll, bool )
+void BoatAnalysisDlg::GetSpeedVector(Vector3d const &C, double *Mu, double *Sigma, Vector3d &VT, bool bAll, bool ) const
 {
     Vector3d V;
     int pp, pw, lw;
@@ -875,10 +1755,64 @@ void BoatAnalysisDlg::GetSpeedVector(Vector3d const &C, double *Mu, double *Sigm
 }
 
 
+void BoatAnalysisDlg::GetSpeedVectors(Vector3d const *C, int nPoints, double *Mu, double *Sigma, Vector3d *VT, bool bAll, bool bBuildTree)
+{
+    //
+    // Same as GetSpeedVector() for a set of points, which are evaluated in parallel with the panel tree
+    // If bBuildTree is false, the tree is assumed to have been built for the current geometry
+    // with the same strengths, e.g. by a previous call for other points
+    //
+    int pp;
+    std::vector<int> TrailingPanels;
+
+    if(bBuildTree)
+    {
+        BuildPanelTree();
+        m_PanelTree.SetStrengths(Mu, Sigma);
+    }
+
+    for (pp=0; pp<m_MatSize; pp++)
+    {
+        if(s_pPanel[pp].m_bIsTrailing && s_pPanel[pp].m_Pos!=MIDSURFACE) TrailingPanels.push_back(pp);
+    }
+
+    int nBlocks = (nPoints+MATRIXTILESIZE-1)/MATRIXTILESIZE;
+    ParallelFor(nBlocks, [&](int ib)
+    {
+        Vector3d V;
+        double phi, sign;
+        int iStart = ib*MATRIXTILESIZE;
+        int iEnd   = std::min(iStart+MATRIXTILESIZE, nPoints);
+        for(int i=iStart; i<iEnd; i++)
+        {
+            m_PanelTree.GetVelocity(C[i], VT[i], phi, bAll);
+
+            //add the contribution of the wake columns shedded by the thick surfaces
+            for(uint it=0; it<TrailingPanels.size(); it++)
+            {
+                int p = TrailingPanels[it];
+                if(s_pPanel[p].m_Pos==BOTSURFACE) sign=-1.0; else sign=1.0;
+                int pw = s_pPanel[p].m_iWake;
+                for(int lw=0; lw<m_pBoatPolar->m_NXWakePanels; lw++)
+                {
+                    GetDoubletInfluence(C[i], s_pWakePanel+pw+lw, V, phi, true, bAll);
+                    VT[i] += V * Mu[p]*sign;
+                }
+            }
+        }
+    },
+    [&]()
+    {
+        return !m_bCancel;
+    });
+}
+
+
 void BoatAnalysisDlg::InitDialog()
 {
-    m_Progress = 0.0;
-    m_pctrlProgress->setValue(int(m_Progress));
+    m_Progress  = 0.0;
+    m_iProgress = 0;
+    m_pctrlProgress->setValue(0);
     QString FileName = QDir::tempPath() + "/sail7.log";
     m_pXFile = new QFile(FileName);
     if (!m_pXFile->open(QIODevice::WriteOnly | QIODevice::Text)) m_pXFile = nullptr;
@@ -959,9 +1893,21 @@ void BoatAnalysisDlg::SetFileHeader()
 }
 
 
-void BoatAnalysisDlg::OnProgress()
+void BoatAnalysisDlg::OnProgress(int Progress)
 {
-    m_pctrlProgress->setValue(int(m_Progress));
+    m_pctrlProgress->setValue(Progress);
+}
+
+
+void BoatAnalysisDlg::SetProgress(double Progress)
+{
+    //called from the analysis thread; the GUI is notified only when the displayed value changes
+    m_Progress = Progress;
+    if(int(m_Progress)!=m_iProgress)
+    {
+        m_iProgress = int(m_Progress);
+        emit AnalysisProgress(m_iProgress);
+    }
 }
 
 
@@ -984,50 +1930,431 @@ void BoatAnalysisDlg::SetupLayout()
     m_pctrlProgress->setMaximum(100);
     m_pctrlProgress->setValue(0);
 
-    m_pctrlCancel = new QPushButton(tr("Cancel"));
-    connect(m_pctrlCancel, SIGNAL(clicked()), this, SLOT(OnCancelAnalysis()));
+    m_pctrlCancel = new QPushButton(tr("Cancel"));
+    connect(m_pctrlCancel, SIGNAL(clicked()), this, SLOT(OnCancelAnalysis()));
+
+    QHBoxLayout *ButtonLayout = new QHBoxLayout;
+    ButtonLayout->addStretch(1);
+    ButtonLayout->addWidget(m_pctrlCancel);
+    ButtonLayout->addStretch(1);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout;
+    mainLayout->addWidget(m_pctrlTextOutput);
+    mainLayout->addWidget(m_pctrlProgress);
+    mainLayout->addLayout(ButtonLayout);
+    setLayout(mainLayout);
+}
+
+
+
+bool BoatAnalysisDlg::Solve(bool bFactorize, int nRHS, bool bRotated)
+{
+    //______________________________________________________________________________________
+    // Method :
+    //     - If the polar is of type 1 or 2, solve the linear system
+    //    - for cosine and sine parts, for a unit speed
+    //    - If the polar is of type 4, solve only for unit speed and for the specified Alpha
+    //    - Reconstruct right side results if calculation was symetric
+    //    - Sort results i.a.w. panel numbering
+    //
+    //     The nRHS right hand sides stored in m_RHS are solved together,
+    //     and their solutions are returned in the nRHS first columns of m_Mu
+    //     If bRotated, the boat has only been heeled or headed since the last factorization,
+    //     which is corrected for the rotated trailing legs instead of being recomputed
+    //______________________________________________________________________________________
+
+    //    memcpy(s_RHS,           m_RHS, m_MatSize * sizeof(double));
+
+    double Progress0 = m_Progress;
+    double TaskSize  = 30.0*double(m_MatSize)/400.0;
+    if(bFactorize && m_pBoatPolar->m_bIterativeSolver)
+    {
+        if(m_pBoatPolar->m_bMatrixFree || m_pBoatPolar->m_bHMatrix) AddString("      Factorizing the diagonal blocks of the preconditioner...\n");
+        else                                                        AddString("      Factorizing the sail and hull blocks of the preconditioner...\n");
+
+        if(!FactorizePreconditioner())
+        {
+            if(!m_bCancel) AddString(tr("      Singular preconditioner block.... Aborting calculation...\n"));
+            return false;
+        }
+        m_bMatrixReady = true;
+        m_MatrixBeta = m_Beta;
+        m_MatrixPhi  = m_Phi;
+        for(int is=0; is<m_pBoat->m_poaSail.size(); is++) m_MatrixSailAngle[is] = m_SailAngle[is];
+    }
+    else if(bFactorize && m_bTrimSolver)
+    {
+        if(!FactorizeSchurComplement())
+        {
+            if(!m_bCancel) AddString(tr("      Singular Matrix.... Aborting calculation...\n"));
+            return false;
+        }
+        m_bMatrixReady = true;
+        m_MatrixBeta = m_Beta;
+        m_MatrixPhi  = m_Phi;
+        for(int is=0; is<m_pBoat->m_poaSail.size(); is++) m_MatrixSailAngle[is] = m_SailAngle[is];
+    }
+    else if(bFactorize && m_pBoatPolar->m_bMixedPrecision)
+    {
+        if(!FactorizeMixedPrecision())
+        {
+            if(!m_bCancel) AddString(tr("      Singular Matrix.... Aborting calculation...\n"));
+            return false;
+        }
+        m_bMatrixReady = true;
+        m_MatrixBeta = m_Beta;
+        m_MatrixPhi  = m_Phi;
+        for(int is=0; is<m_pBoat->m_poaSail.size(); is++) m_MatrixSailAngle[is] = m_SailAngle[is];
+    }
+    else if(bRotated)
+    {
+        if(!CorrectRotatedLegs())
+        {
+            if(!m_bCancel) AddString(tr("      Singular Matrix.... Aborting calculation...\n"));
+            return false;
+        }
+        m_bMatrixReady = true;
+        m_MatrixBeta = m_Beta;
+        m_MatrixPhi  = m_Phi;
+    }
+    else if(bFactorize)
+    {
+        AddString("      Performing LU Matrix decomposition...\n");
+        m_bLegsReady = m_bRotated = false;
+
+        memcpy(s_aij, s_aijRef, ulong(m_MatSize)*ulong(m_MatSize)*sizeof(double));
+        if(!Crout_LU_Decomposition_with_Pivoting(s_aij, m_Index, m_MatSize, &m_bCancel,
+                                                 [&](double Fraction){SetProgress(Progress0 + TaskSize*Fraction);}))
+        {
+            if(!m_bCancel) AddString(tr("      Singular Matrix.... Aborting calculation...\n"));
+            return false;
+        }
+
+        //record the parameters of the factorized matrix, for reuse by the next points
+        m_bMatrixReady = true;
+        m_MatrixBeta = m_Beta;
+        m_MatrixPhi  = m_Phi;
+        for(int is=0; is<m_pBoat->m_poaSail.size(); is++) m_MatrixSailAngle[is] = m_SailAngle[is];
+        RecordLegColumns();
+    }
+    else if(m_pBoatPolar->m_bIterativeSolver)
+    {
+        AddString("      Reusing the preconditioner of the previous point...\n");
+    }
+    else
+    {
+        AddString("      Reusing the LU decomposition of the previous point...\n");
+    }
+
+    if(m_pBoatPolar->m_bIterativeSolver)
+    {
+        if(!SolveIterative(nRHS)) return false;
+    }
+    else if(m_bTrimSolver)
+    {
+        AddString("      Solving with the Schur complement...\n");
+        if(!SolveSchurComplement(nRHS)) return false;
+    }
+    else if(m_bRotated)
+    {
+        AddString("      Solving the LU system corrected for the trailing legs...\n");
+        if(!SolveRotated(nRHS)) return false;
+    }
+    else if(m_pBoatPolar->m_bMixedPrecision)
+    {
+        if(!SolveMixedPrecision(nRHS)) return false;
+    }
+    else if(nRHS>1)
+    {
+        AddString(QString("      Solving LU system for %1 points...\n").arg(nRHS));
+        if(!Crout_LU_with_Pivoting_Solve_Multiple(s_aij, m_RHS, m_Index, s_RHS, m_MatSize, nRHS, &m_bCancel))
+            return false;
+    }
+    else
+    {
+        AddString("      Solving LU system...\n");
+        if(!Crout_LU_with_Pivoting_Solve(s_aij, m_RHS, m_Index, s_RHS, m_MatSize, &m_bCancel))
+            return false;
+    }
+
+    memcpy(m_Mu, s_RHS, ulong(m_MatSize)*ulong(nRHS)*sizeof(double));
+
+    SetProgress(Progress0 + TaskSize*double(nRHS));
+
+    return true;
+}
+
+
+bool BoatAnalysisDlg::FactorizeMixedPrecision()
+{
+    //
+    // Factorizes the assembled matrix in single precision in s_aij, which is only half the size of s_aijRef,
+    // or in double precision in place in s_aijRef if the refinement has failed earlier in the analysis.
+    // In the latter case, the assembled matrix is lost and is rebuilt in full for the next geometry.
+    //
+    double Progress0 = m_Progress;
+    double TaskSize  = 30.0*double(m_MatSize)/400.0;
+    auto Progress = [&](double Fraction){SetProgress(Progress0 + TaskSize*Fraction);};
+
+    if(m_bMixedFallback)
+    {
+        AddString("      Performing LU Matrix decomposition...\n");
+        m_bRefMatrix = false;
+        return Crout_LU_Decomposition_with_Pivoting(s_aijRef, m_Index, m_MatSize, &m_bCancel, Progress);
+    }
+
+    AddString("      Performing single precision LU Matrix decomposition...\n");
+    float *pLU = reinterpret_cast<float*>(s_aij);
+    ParallelFor(m_MatSize, [&](int i)
+    {
+        float *lu_i = pLU + size_t(i)*size_t(m_MatSize);
+        double const *a_i = s_aijRef + size_t(i)*size_t(m_MatSize);
+        for(int j=0; j<m_MatSize; j++) lu_i[j] = float(a_i[j]);
+    });
+    return Crout_LU_Decomposition_with_Pivoting(pLU, m_Index, m_MatSize, &m_bCancel, Progress);
+}
+
+
+bool BoatAnalysisDlg::SolveMixedPrecision(int nRHS)
+{
+    //
+    // Solves the nRHS right hand sides with the single precision LU decomposition held in s_aij,
+    // then refines the solutions against the double precision matrix s_aijRef :
+    //      x <- x + LU^-1.(b - A.x)
+    // Each iteration gains the accuracy of the single precision factorization, i.e. several digits,
+    // so that a few iterations recover the double precision solution. If the iterations stall,
+    // the matrix is factorized in double precision for this point and the remainder of the analysis.
+    // The solutions are returned in s_RHS
+    //
+    QString strong;
+    int N = m_MatSize;
+
+    if(!m_bMixedFallback)
+    {
+        AddString("      Solving the single precision LU system with iterative refinement...\n");
+        float *pLU = reinterpret_cast<float*>(s_aij);
+        std::vector<double> R(ulong(N)*ulong(nRHS)), D(ulong(N)*ulong(nRHS));
+
+        if(!Crout_LU_with_Pivoting_Solve_Multiple(pLU, m_RHS, m_Index, s_RHS, N, nRHS, &m_bCancel)) return false;
+
+        //sets the residuals in R, and returns the largest relative residual of the right hand sides
+        auto Residual = [&]()
+        {
+            double MaxResidual = 0.0;
+            for(int r=0; r<nRHS; r++)
+            {
+                double const *b = m_RHS + r*N;
+                double *res = R.data() + r*N;
+                MatrixVectorProduct(s_aijRef, s_RHS + r*N, res, N);
+                double rr = 0.0, bb = 0.0;
+                for(int i=0; i<N; i++)
+                {
+                    res[i] = b[i] - res[i];
+                    rr += res[i]*res[i];
+                    bb += b[i]*b[i];
+                }
+                if(bb>0.0) MaxResidual = std::max(MaxResidual, sqrt(rr/bb));
+            }
+            return MaxResidual;
+        };
+
+        int nIter = 0;
+        bool bConverged = false;
+        double LastResidual = 0.0;
+        double Res = Residual();
+        while(!m_bCancel)
+        {
+            if(Res<REFINEMENTTOLERANCE)
+            {
+                bConverged = true;
+                break;
+            }
+            //stop if the residual does not decrease any more
+            if(nIter>=REFINEMENTMAXITER || (nIter>0 && Res>0.5*LastResidual)) break;
+
+            if(!Crout_LU_with_Pivoting_Solve_Multiple(pLU, R.data(), m_Index, D.data(), N, nRHS, &m_bCancel)) return false;
+            for(size_t i=0; i<D.size(); i++) s_RHS[i] += D[i];
+            nIter++;
+
+            LastResidual = Res;
+            Res = Residual();
+        }
+        if(m_bCancel) return false;
+
+        if(bConverged)
+        {
+            strong = QString("      %1 refinement iteration(s), relative residual = %2\n").arg(nIter).arg(Res, 0, 'e', 2);
+            AddString(strong);
+            return true;
+        }
+
+        strong = QString(tr("      The refinement has not converged after %1 iteration(s), relative residual = %2")+"\n")
+                 .arg(nIter).arg(Res, 0, 'e', 2);
+        AddString(strong);
+        AddString(tr("      Switching to the double precision LU decomposition")+"\n");
+        m_bMixedFallback = true;
+        if(!FactorizeMixedPrecision())
+        {
+            if(!m_bCancel) AddString(tr("      Singular Matrix.... Aborting calculation...\n"));
+            return false;
+        }
+    }
+    else AddString("      Solving LU system...\n");
+
+    return Crout_LU_with_Pivoting_Solve_Multiple(s_aijRef, m_RHS, m_Index, s_RHS, N, nRHS, &m_bCancel);
+}
+
+
+bool BoatAnalysisDlg::FactorizePreconditioner()
+{
+    //
+    // The panels are numbered sail by sail, then hull by hull
+    // Each of these groups defines a diagonal block of the influence matrix, which is
+    // copied and factorized on its own to build the block-Jacobi preconditioner
+    // If the full influence matrix is not built, the groups are split in blocks of consecutive panels
+    // of limited size, and the coefficients of the blocks are computed directly
+    //
+    int is, ib, i;
+    std::vector<int> GroupSize;
+
+    for(is=0; is<m_pBoat->m_poaSail.size(); is++) GroupSize.push_back(m_pBoat->m_poaSail.at(is)->m_NElements);
+    for(ib=0; ib<m_pBoat->m_poaHull.size(); ib++) GroupSize.push_back(m_pBoat->m_poaHull.at(ib)->m_NElements);
+
+    bool bFullMatrix = !m_pBoatPolar->m_bMatrixFree && !m_pBoatPolar->m_bHMatrix;
+    int MaxBlockSize = bFullMatrix ? m_MatSize : PRECONDBLOCKSIZE;
+
+    m_BlockStart.assign(1, 0);
+    for(i=0; i<int(GroupSize.size()); i++)
+    {
+        int n = GroupSize[ulong(i)];
+        while(n>0)
+        {
+            int nb = std::min(n, MaxBlockSize);
+            m_BlockStart.push_back(m_BlockStart.back() + nb);
+            n -= nb;
+        }
+    }
+    if(m_BlockStart.back()!=m_MatSize)
+    {
+        // not expected, but keep the preconditioner consistent with the matrix
+        m_BlockStart.assign(1, 0);
+        for(i=0; i<m_MatSize; i+=MaxBlockSize) m_BlockStart.push_back(std::min(i+MaxBlockSize, m_MatSize));
+    }
+    m_nBlocks = int(m_BlockStart.size())-1;
+    m_BlockOffset.resize(ulong(m_nBlocks));
+
+    size_t LUSize = 0;
+    for(ib=0; ib<m_nBlocks; ib++)
+    {
+        size_t n = size_t(m_BlockStart[ib+1]-m_BlockStart[ib]);
+        m_BlockOffset[ib] = LUSize;
+        LUSize += n*n;
+    }
 
-    QHBoxLayout *ButtonLayout = new QHBoxLayout;
-    ButtonLayout->addStretch(1);
-    ButtonLayout->addWidget(m_pctrlCancel);
-    ButtonLayout->addStretch(1);
+    if(LUSize>m_BlockLUSize)
+    {
+        delete [] m_pBlockLU;
+        m_pBlockLU = new (std::nothrow) double[LUSize];
+        m_BlockLUSize = m_pBlockLU ? LUSize : 0;
+        if(!m_pBlockLU) return false;
+    }
 
-    QVBoxLayout *mainLayout = new QVBoxLayout;
-    mainLayout->addWidget(m_pctrlTextOutput);
-    mainLayout->addWidget(m_pctrlProgress);
-    mainLayout->addLayout(ButtonLayout);
-    setLayout(mainLayout);
+    for(ib=0; ib<m_nBlocks; ib++)
+    {
+        int i0 = m_BlockStart[ib];
+        int n  = m_BlockStart[ib+1]-i0;
+        double *pLU = m_pBlockLU + m_BlockOffset[ib];
+        if(!bFullMatrix)
+        {
+            ParallelFor(n, [&](int k)
+            {
+                for(int l=0; l<n; l++) pLU[size_t(k)*n+l] = InfluenceCoefficient(i0+k, i0+l);
+            });
+        }
+        else
+        {
+            for(i=0; i<n; i++)
+            {
+                memcpy(pLU+size_t(i)*n, s_aijRef+size_t(i0+i)*m_MatSize+i0, size_t(n)*sizeof(double));
+            }
+        }
+        if(!Crout_LU_Decomposition_with_Pivoting(pLU, m_Index+i0, n, &m_bCancel)) return false;
+    }
+    return true;
 }
 
 
-
-bool BoatAnalysisDlg::Solve()
+void BoatAnalysisDlg::Precondition(double *v, double *w)
 {
-    //______________________________________________________________________________________
-    // Method :
-    //     - If the polar is of type 1 or 2, solve the linear system
-    //    - for cosine and sine parts, for a unit speed
-    //    - If the polar is of type 4, solve only for unit speed and for the specified Alpha
-    //    - Reconstruct right side results if calculation was symetric
-    //    - Sort results i.a.w. panel numbering
-    //______________________________________________________________________________________
+    // v = inv(M).v, where M is the block diagonal part of the influence matrix
+    // w is a work array of m_MatSize elements
+    for(int ib=0; ib<m_nBlocks; ib++)
+    {
+        int i0 = m_BlockStart[ib];
+        int n  = m_BlockStart[ib+1]-i0;
+        memcpy(w, v+i0, size_t(n)*sizeof(double));
+        Crout_LU_with_Pivoting_Solve(m_pBlockLU+m_BlockOffset[ib], w, m_Index+i0, v+i0, n, &m_bCancel);
+    }
+}
 
-    //    memcpy(s_RHS,           m_RHS, m_MatSize * sizeof(double));
 
-    AddString("      Performing LU Matrix decomposition...\n");
+bool BoatAnalysisDlg::SolveIterative(int nRHS)
+{
+    //
+    // Solves the nRHS systems with the restarted GMRES method
+    // The products by the influence matrix are evaluated with the panel tree if the matrix is not built,
+    // or with the hierarchical matrix
+    // The preconditioner must have been factorized
+    //
+    QString strong;
+    int nIter;
+    double Residual;
+    std::vector<double> Work(m_MatSize);
 
-    if(!Crout_LU_Decomposition_with_Pivoting(s_aij, m_Index, m_MatSize, &m_bCancel, 30.0*double(m_MatSize)/400.0, m_Progress))
+    for(int k=0; k<nRHS; k++)
     {
-        AddString(tr("      Singular Matrix.... Aborting calculation...\n"));
-        return false;
-    }
+        double *B = m_RHS + k*m_MatSize;
+        double *x = s_RHS + k*m_MatSize;
 
-    AddString("      Solving LU system...\n");
-    Crout_LU_with_Pivoting_Solve(s_aij, m_RHS, m_Index, s_RHS, m_MatSize, &m_bCancel);
+        //in a speed sequence the RHS only scales, so that the previous solution is a good first guess
+        if(k>0)
+        {
+            double n0=0.0, n1=0.0;
+            for(int p=0; p<m_MatSize; p++)
+            {
+                n0 += B[p-m_MatSize]*B[p-m_MatSize];
+                n1 += B[p]*B[p];
+            }
+            double ratio = n0>0.0 ? sqrt(n1/n0) : 0.0;
+            for(int p=0; p<m_MatSize; p++) x[p] = ratio * x[p-m_MatSize];
+        }
+        else memset(x, 0, ulong(m_MatSize)*sizeof(double));
+
+        bool bConverged = GMRES_Solve([&](double const *v, double *w)
+                                      {
+                                          if(m_pBoatPolar->m_bMatrixFree)   TreeProduct(v, w);
+                                          else if(m_pBoatPolar->m_bHMatrix) m_HMatrix.Product(v, w);
+                                          else                              MatrixVectorProduct(s_aijRef, v, w, m_MatSize);
+                                      },
+                                      B, x, m_MatSize, [&](double *v){Precondition(v, Work.data());},
+                                      m_pBoatPolar->m_SolverTolerance, GMRESRESTART, GMRESMAXITER,
+                                      nIter, Residual, &m_bCancel);
+        if(m_bCancel) return false;
 
-    memcpy(m_Mu, s_RHS, ulong(m_MatSize)*sizeof(double));
+        strong = QString("      GMRES: %1 iterations, residual = %2\n").arg(nIter).arg(Residual, 0, 'e', 3);
+        AddString(strong);
+        if(!bConverged)
+        {
+            AddString(tr("      GMRES did not converge to the requested tolerance")+"\n");
+            m_bWarning = true;
+        }
+    }
+    return true;
+}
 
 
+void BoatAnalysisDlg::ComputeDoubletDerivatives()
+{
     //   Define unit local velocity vector, necessary for moment calculations in stability analysis of 3D panels
     Vector3d u(1.0, 0.0, 0.0);
     double Cp;
@@ -1037,10 +2364,8 @@ bool BoatAnalysisDlg::Solve()
         {
             GetDoubletDerivative(p, m_RHS, Cp, m_VMuDerivative[p], 1.0, u.x, u.y, u.z);
         }
-        if(m_bCancel) return false;
+        if(m_bCancel) return;
     }
-
-    return true;
 }
 
 
@@ -1071,11 +2396,11 @@ void BoatAnalysisDlg::StartAnalysis()
     // the Neumann type BC is applied to the body panels, rather than the Dirichlet type BC
     //
     //    MainFrame *pMainFrame = (MainFrame*)s_pMainFrame;
-    qApp->processEvents();
 
     if(!m_pBoatPolar) return;
 
     QString strong;
+    int nrhs;
     m_pctrlCancel->setText(tr("Cancel"));
     m_bIsFinished = false;
 
@@ -1095,24 +2420,100 @@ void BoatAnalysisDlg::StartAnalysis()
     }
 
 
+    if(!AllocateArrays(m_MatSize))
+    {
+        strong = tr("Not enough memory for the analysis, aborting")+"\n";
+        AddString(strong);
+        m_bWarning = true;
+        m_bIsFinished = true;
+        m_pctrlCancel->setText(tr("Close"));
+        return;
+    }
+
+    bool bSingleLU = m_pBoatPolar->m_bMixedPrecision && !m_pBoatPolar->m_bIterativeSolver;
+    if(!m_pBoatPolar->m_bMatrixFree && !m_pBoatPolar->m_bHMatrix && !s_pMainFrame->AllocateMatrix(m_MatSize, bSingleLU))
+    {
+        strong = tr("Not enough memory for the influence matrix, the matrix-free or hierarchical solvers may be used instead, aborting")+"\n";
+        AddString(strong);
+        m_bWarning = true;
+        m_bIsFinished = true;
+        m_pctrlCancel->setText(tr("Close"));
+        return;
+    }
+
+    if(m_pBoatPolar->m_bIterativeSolver)
+    {
+        strong = QString(tr("Using the GMRES solver with a tolerance of %1")+"\n").arg(m_pBoatPolar->m_SolverTolerance, 0, 'g', 2);
+        AddString(strong);
+        if(m_pBoatPolar->m_bMatrixFree)
+        {
+            strong = QString(tr("The influence matrix is not built, the panel influences are evaluated with a tree of accuracy %1")+"\n")
+                     .arg(m_pBoatPolar->m_TreeAccuracy, 0, 'f', 2);
+            AddString(strong);
+        }
+        else if(m_pBoatPolar->m_bHMatrix)
+        {
+            strong = QString(tr("The influence matrix is stored in hierarchical form with an accuracy of %1")+"\n")
+                     .arg(m_pBoatPolar->m_HMatrixAccuracy, 0, 'g', 2);
+            AddString(strong);
+        }
+    }
+
     strong = tr("Type 1 - Fixed speed polar");
     AddString(strong);
     m_bCancel = false;
+    m_bMatrixReady = false; //the matrix arrays may have been used or resized since the last analysis
+    m_bRefMatrix   = false;
+    m_bLegsReady   = m_bRotated = false;
+    m_bMixedFallback = false;
+
+    if (m_ControlMax<m_ControlMin) m_ControlDelta = -fabs(m_ControlDelta);
+    nrhs  = int(fabs((m_ControlMax-m_ControlMin)*1.0001/m_ControlDelta) + 1);
+
+    if(!m_bSequence) nrhs = 1;
+    else if(nrhs>=100)
+    {
+        QMessageBox::warning(this, tr("Warning"),tr("The number of points to be calculated will be limited to 100"));
+        nrhs = 100;
+    }
+
+    //ESTIMATED UNIT TIMES FOR OPERATIONS
+
+    double TotalTime = 10.0*double(m_MatSize)/400. //BuildInfluenceMatrix :     10 x MatSize/400
+                       + 10.                         //CreateRHS :                10
+                       + 30.*double(m_MatSize)/400.  //SolveUnitRHS :             30 x MatSize/400
+                       + 1./400.   * double(m_pBoat->m_poaSail.size())  //ComputeFarField : 1 x MatSize/400x nsails
+                       + 1.   ;                      //ComputeOnBodyCp :           1
+
+    TotalTime *= nrhs;
+
+    m_pctrlProgress->setMinimum(0);
+    m_pctrlProgress->setMaximum(int(TotalTime));
+    m_Progress  = 0.0;
+    m_iProgress = 0;
 
-    QTimer *pTimer = new QTimer;
-    connect(pTimer, SIGNAL(timeout()), this, SLOT(OnProgress()));
-    pTimer->setInterval(100);
-    pTimer->start();
+    //Run the analysis in a separate thread, and keep processing the GUI events until it has finished
+    //The main window is disabled meanwhile, since the thread works on the boat's panels and nodes
+    s_pMainFrame->setEnabled(false);
+    QEventLoop EventLoop;
+    connect(this, SIGNAL(AnalysisFinished()), &EventLoop, SLOT(quit()), Qt::QueuedConnection);
 
-    qApp->processEvents();
+    std::thread AnalysisThread([this, nrhs]()
+    {
+        UnitLoop(nrhs);
+        emit AnalysisFinished();
+    });
+    EventLoop.exec();
+    AnalysisThread.join();
 
-    UnitLoop();
+    //release the memory of the hierarchical matrix, which is rebuilt by each analysis
+    m_HMatrix.Clear();
 
+    s_pMainFrame->setEnabled(true);
 
     if (!m_bCancel && !m_bWarning) strong = "\n"+tr("Panel Analysis completed successfully")+"\n";
     else if (m_bWarning)           strong = "\n"+tr("Panel Analysis completed ... Errors encountered")+"\n";
     AddString(strong);
-    pTimer->stop();
 
     //    if(m_pBoatPolar && (m_pBoatPolar->m_Type==STABILITYPOLAR || m_pBoatPolar->m_bTiltedGeom || m_pBoatPolar->m_bWakeRollUp))
     {
@@ -1129,6 +2530,49 @@ void BoatAnalysisDlg::StartAnalysis()
 
 
 
+static double Interpolate(double Min, double Max, double Ctrl)
+{
+    // a parameter which is not swept keeps exactly the same value for all the points,
+    // so that the geometry can be recognized as unchanged from one point to the next
+    if(Min==Max) return Min;
+    return (1.0-Ctrl) * Min + Ctrl * Max;
+}
+
+
+bool BoatAnalysisDlg::IsSameGeometry()
+{
+    //
+    // Returns true if the current point has the same panel geometry and wind direction
+    // as the matrix held in LU form, in which case only the RHS needs to be rebuilt
+    // The wind speed only scales the RHS
+    //
+    if(!m_bMatrixReady) return false;
+    if(m_Beta!=m_MatrixBeta || m_Phi!=m_MatrixPhi) return false;
+    for(int is=0; is<m_pBoat->m_poaSail.size(); is++)
+    {
+        if(m_SailAngle[is]!=m_MatrixSailAngle[is]) return false;
+    }
+    return true;
+}
+
+
+bool BoatAnalysisDlg::IsRigidRotation()
+{
+    //
+    // Returns true if the current geometry only differs from the one of the LU decomposition held in s_aij
+    // by a rotation of the whole boat, i.e. the heel or the wind direction have changed but not the sail angles.
+    // Without ground effect, the influence coefficients are then unchanged, except in the columns
+    // of the panels whose trailing legs follow the wind direction
+    //
+    if(!m_bLegsReady || m_pBoatPolar->m_bGround) return false;
+    for(int is=0; is<m_pBoat->m_poaSail.size(); is++)
+    {
+        if(m_SailAngle[is]!=m_MatrixSailAngle[is]) return false;
+    }
+    return true;
+}
+
+
 void BoatAnalysisDlg::SetAngles(BoatPolar *pBoatPolar, double Ctrl, bool bBCOnly)
 {
     // Rotate the panels by the bank angle
@@ -1141,9 +2585,9 @@ void BoatAnalysisDlg::SetAngles(BoatPolar *pBoatPolar, double Ctrl, bool bBCOnly
     //    memcpy(s_pWakePanel, s_pRefWakePanel, m_WakeSize * sizeof(CPanel));
     //    memcpy(s_pWakeNode,  s_pRefWakeNode,  m_nWakeNodes * sizeof(CVector));
 
-    m_QInf = (1.0-Ctrl) * pBoatPolar->m_QInfMin + Ctrl * pBoatPolar->m_QInfMax;
-    m_Phi  = (1.0-Ctrl) * pBoatPolar->m_PhiMin  + Ctrl * pBoatPolar->m_PhiMax;
-    m_Beta = (1.0-Ctrl) * pBoatPolar->m_BetaMin + Ctrl * pBoatPolar->m_BetaMax;
+    m_QInf = Interpolate(pBoatPolar->m_QInfMin, pBoatPolar->m_QInfMax, Ctrl);
+    m_Phi  = Interpolate(pBoatPolar->m_PhiMin,  pBoatPolar->m_PhiMax,  Ctrl);
+    m_Beta = Interpolate(pBoatPolar->m_BetaMin, pBoatPolar->m_BetaMax, Ctrl);
 
     SetWindAxis(m_Beta, m_WindDirection, m_WindNormal, m_WindSide);
     m_VInf = m_WindDirection * m_QInf;
@@ -1158,7 +2602,8 @@ void BoatAnalysisDlg::SetAngles(BoatPolar *pBoatPolar, double Ctrl, bool bBCOnly
         Mast.Set(sin(pSail->m_LuffAngle*PI/180.0), 0.0, cos(pSail->m_LuffAngle*PI/180.0));
         //        Mast.RotateX(pSail->m_LEPosition, m_Phi);
 
-        double Angle = (1.0-Ctrl) * pBoatPolar->m_SailAngleMin[is] + Ctrl * pBoatPolar->m_SailAngleMax[is];
+        double Angle = Interpolate(pBoatPolar->m_SailAngleMin[is], pBoatPolar->m_SailAngleMax[is], Ctrl);
+        m_SailAngle[is] = Angle;
         qt.Set(Angle, Mast);
 
         if(bBCOnly)
@@ -1188,59 +2633,82 @@ void BoatAnalysisDlg::SetAngles(BoatPolar *pBoatPolar, double Ctrl, bool bBCOnly
 
 
 
-bool BoatAnalysisDlg::UnitLoop()
+bool BoatAnalysisDlg::UnitLoop(int nrhs)
 {
+    //runs in the analysis thread : no direct access to the GUI from here
     QString str;
-    int n, nrhs;
+    int n, k, nBatch;
+    bool bSameGeometry = false, bRotated = false;
 
-    if (m_ControlMax<m_ControlMin) m_ControlDelta = -fabs(m_ControlDelta);
-    nrhs  = int(fabs((m_ControlMax-m_ControlMin)*1.0001/m_ControlDelta) + 1);
+    str = QString(tr("   Solving the problem... ")+"\n");
+    AddString(str);
 
-    if(!m_bSequence) nrhs = 1;
-    else if(nrhs>=100)
+    //if only the wind speed is swept, all the points share the same matrix
+    //and are solved together, up to VLMMAXRHS at a time
+    bool bFixedGeometry = m_pBoatPolar->m_PhiMin==m_pBoatPolar->m_PhiMax && m_pBoatPolar->m_BetaMin==m_pBoatPolar->m_BetaMax;
+    for(int is=0; is<m_pBoat->m_poaSail.size(); is++)
     {
-        QMessageBox::warning(this, tr("Warning"),tr("The number of points to be calculated will be limited to 100"));
-        nrhs = 100;
+        if(m_pBoatPolar->m_SailAngleMin[is]!=m_pBoatPolar->m_SailAngleMax[is]) bFixedGeometry = false;
     }
 
-    //ESTIMATED UNIT TIMES FOR OPERATIONS
-
-    double TotalTime = 10.0*double(m_MatSize)/400. //BuildInfluenceMatrix :     10 x MatSize/400
-                       + 10.                         //CreateRHS :                10
-                       + 30.*double(m_MatSize)/400.  //SolveUnitRHS :             30 x MatSize/400
-                       + 1./400.   * double(m_pBoat->m_poaSail.size())  //ComputeFarField : 1 x MatSize/400x nsails
-                       + 1.   ;                      //ComputeOnBodyCp :           1
-
-    TotalTime *= nrhs;
-
-    m_pctrlProgress->setMinimum(0);
-    m_pctrlProgress->setMaximum(int(TotalTime));
-    m_Progress = 0.0;
-    qApp->processEvents();
-
-    str = QString(tr("   Solving the problem... ")+"\n");
-    AddString(str);
+    SetTrimSolver(nrhs);
+    if(m_bTrimSolver)
+    {
+        str = QString(tr("      Only the %1 panels of the trimmed sails are factorized for each point")+"\n").arg(m_TrimMoved.size());
+        AddString(str);
+    }
 
-    for (n=0; n<nrhs; n++)
+    //the points which require their own matrix are independent of each other, and are solved concurrently
+    int nWorkers = SweepWorkerCount(nrhs);
+    if(nWorkers>1)
     {
-        m_Ctrl = m_ControlMin + double(n) * m_ControlDelta;
-        str = QString("      \n    "+tr("Processing parameter= %1")+"\n").arg(m_Ctrl,8,'f',3);
+        str = QString(tr("      The points are solved by %1 concurrent workers")+"\n").arg(nWorkers);
         AddString(str);
 
-        SetAngles(m_pBoatPolar, m_Ctrl, false);
-        if (m_bCancel) return true;
+        bool bDone = ParallelSweep(nrhs, nWorkers);
+        std::vector<SweepWorker>().swap(m_SweepWorker);
 
+        //s_aij and s_aijRef have not been used
+        m_bMatrixReady = m_bRefMatrix = m_bLegsReady = false;
+        if(bDone) return true;
+    }
 
-        BuildInfluenceMatrix();
-        if (m_bCancel) return true;
+    for (n=0; n<nrhs; n+=nBatch)
+    {
+        nBatch = bFixedGeometry ? std::min(nrhs-n, VLMMAXRHS) : 1;
 
+        //build the matrix and the right hand sides of all the points of the batch
+        for(k=0; k<nBatch; k++)
+        {
+            m_Ctrl = m_ControlMin + double(n+k) * m_ControlDelta;
+            str = QString("      \n    "+tr("Processing parameter= %1")+"\n").arg(m_Ctrl,8,'f',3);
+            AddString(str);
 
-        CreateRHS(m_RHS);
-        if (m_bCancel) return true;
+            SetAngles(m_pBoatPolar, m_Ctrl, false);
+            if (m_bCancel) return true;
 
+            if(k==0)
+            {
+                //only the wind speed has changed since the last point : the LU decomposition is still valid
+                bSameGeometry = IsSameGeometry();
+                //the boat has only been heeled or headed : the LU decomposition can be corrected
+                bRotated = !bSameGeometry && IsRigidRotation();
 
-        CreateSourceStrength();
-        if (m_bCancel) return true;
+                if(!bSameGeometry)
+                {
+                    m_bMatrixReady = false;
+                    if(m_pBoatPolar->m_bMatrixFree)   BuildPanelTree();
+                    else if(m_pBoatPolar->m_bHMatrix) BuildHMatrix();
+                    else                              UpdateInfluenceMatrix();
+                }
+                else SetProgress(m_Progress + 10.0*double(m_MatSize)/400.);
+                if (m_bCancel) return true;
+            }
+            else SetProgress(m_Progress + 10.0*double(m_MatSize)/400.);
+
+            CreateRHS(m_RHS + k*m_MatSize);
+            if (m_bCancel) return true;
+        }
 
         //compute wake contribution
         //        CreateWakeContribution();
@@ -1260,7 +2728,7 @@ bool BoatAnalysisDlg::UnitLoop()
         if (m_bCancel) return true;
 
 
-        if (!Solve())
+        if (!Solve(!bSameGeometry && !bRotated, nBatch, bRotated))
         {
             m_bWarning = true;
             return true;
@@ -1268,13 +2736,185 @@ bool BoatAnalysisDlg::UnitLoop()
         if (m_bCancel) return true;
 
 
-        ComputeFarField();
-        if (m_bCancel) return true;
+        //post-process the points one at a time, the results are expected in the first columns
+        for(k=0; k<nBatch; k++)
+        {
+            if(k>0)
+            {
+                m_Ctrl = m_ControlMin + double(n+k) * m_ControlDelta;
+                SetAngles(m_pBoatPolar, m_Ctrl, false);
+                memcpy(m_Mu,  m_Mu  + k*m_MatSize, ulong(m_MatSize)*sizeof(double));
+                memcpy(m_RHS, m_RHS + k*m_MatSize, ulong(m_MatSize)*sizeof(double));
+                str = QString("      \n    "+tr("Computing the results for parameter= %1")+"\n").arg(m_Ctrl,8,'f',3);
+                AddString(str);
+            }
 
-        ComputeOnBody();
-        if (m_bCancel) return true;
+            ComputeResults();
+            if (m_bCancel) return true;
+        }
+    }
+
+    return true;
+}
+
+
+void BoatAnalysisDlg::ComputeResults()
+{
+    //
+    // Computes the results of the current point, once its doublet strengths are in m_Mu
+    //
+    CreateSourceStrength();
+    if (m_bCancel) return;
+
+    ComputeDoubletDerivatives();
+    if (m_bCancel) return;
+
+    ComputeFarField();
+    if (m_bCancel) return;
+
+    ComputeOnBody();
+    if (m_bCancel) return;
+
+    ComputeBoat();
+}
+
+
+int BoatAnalysisDlg::SweepWorkerCount(int nrhs)
+{
+    //
+    // Returns the number of points of the polar which may be solved concurrently
+    // If the sail angles move along the polar, each point requires its own influence matrix,
+    // and the points are independent of each other. Each worker then builds and factorizes its matrix
+    // on one core, which scales better than sharing all the cores on the factorization of a single matrix.
+    // Each worker needs its own n x n matrix, so that the number of workers is limited by the available memory.
+    //
+    if(nrhs<2 || m_pBoatPolar->m_bIterativeSolver || m_bTrimSolver || m_bWakeRollUp) return 1;
+
+    bool bTrimmed = false;
+    for(int is=0; is<m_pBoat->m_poaSail.size(); is++)
+    {
+        if(m_pBoatPolar->m_SailAngleMin[is]!=m_pBoatPolar->m_SailAngleMax[is]) bTrimmed = true;
+    }
+    if(!bTrimmed) return 1;
+
+    if(m_pBoatPolar->m_bMixedPrecision)
+    {
+        // the workers factorize their matrices in double precision, which would use the memory saved by the single precision LU
+        AddString(tr("      The single precision LU is used for each point in turn, instead of solving the points concurrently")+"\n");
+        return 1;
+    }
+
+    // the batches hold up to 7 segments of 12 values per thin panel, or 27 values per thick panel,
+    // and the buffers 3 velocities per segment or 4 influences per thick panel
+    double WorkerSize = double(m_MatSize) * double(m_MatSize) * sizeof(double)
+                      + double(m_MatSize) * (sizeof(CPanel) + 3*sizeof(int) + 2*sizeof(double))
+                      + double(m_MatSize) * 7*(12+3) * sizeof(double)
+                      + double(m_nNodes)  * sizeof(Vector3d);
+    int nMemory = int(SWEEPMEMORYFRACTION*AvailableMemory()/WorkerSize);
+
+    return std::max(1, std::min(std::min(ThreadCount(), nrhs), nMemory));
+}
+
+
+bool BoatAnalysisDlg::ParallelSweep(int nrhs, int nWorkers)
+{
+    //
+    // Solves the points of the polar with nWorkers workers, each point by a single worker.
+    // Each worker takes the next point of the polar as soon as it has solved the previous one,
+    // so that the workers do not wait for each other.
+    // The geometry and the right hand side of each point are set serially, since the wind factor
+    // is not re-entrant, and the results are computed serially in control order once all the points are solved,
+    // so that the BoatOpps are added to the polar in the same order as with the sequential loop.
+    // Returns false if the workers could not be allocated, in which case nothing has been computed.
+    //
+    QString str;
+    int n;
+    std::vector<double> PointRHS, PointMu;
+
+    try
+    {
+        m_SweepWorker.resize(ulong(nWorkers));
+        for(int k=0; k<nWorkers; k++)
+        {
+            SweepWorker &W = m_SweepWorker[ulong(k)];
+            W.Panel.resize(ulong(m_MatSize));
+            W.Node.resize(ulong(m_nNodes));
+            W.aij.resize(ulong(m_MatSize)*ulong(m_MatSize));
+            W.Index.resize(ulong(m_MatSize));
+            W.RHS.resize(ulong(m_MatSize));
+            W.Mu.resize(ulong(m_MatSize));
+        }
+        PointRHS.resize(ulong(nrhs)*ulong(m_MatSize));
+        PointMu.resize(ulong(nrhs)*ulong(m_MatSize));
+    }
+    catch(std::bad_alloc &)
+    {
+        std::vector<SweepWorker>().swap(m_SweepWorker);
+        AddString(tr("      Not enough memory for the parallel sweep, solving the points one at a time")+"\n");
+        return false;
+    }
+
+    std::mutex SetupMutex;   // serializes the set up of the points, and the progress
+    int nNext = 0;           // the next point to set up
+    int iFailed = nrhs;      // the first point whose matrix is singular
+
+    ParallelFor(nWorkers, [&](int ik)
+    {
+        SweepWorker &W = m_SweepWorker[ulong(ik)];
+        for(;;)
+        {
+            int iPoint;
+            {
+                std::lock_guard<std::mutex> lock(SetupMutex);
+                if(m_bCancel || nNext>=iFailed) return;
+                iPoint = nNext++;
+
+                m_Ctrl = m_ControlMin + double(iPoint) * m_ControlDelta;
+                AddString(QString("      \n    "+tr("Processing parameter= %1")+"\n").arg(m_Ctrl,8,'f',3));
 
-        ComputeBoat();
+                SetAngles(m_pBoatPolar, m_Ctrl, false);
+                if (m_bCancel) return;
+
+                memcpy(W.Panel.data(), s_pPanel, ulong(m_MatSize)*sizeof(CPanel));
+                memcpy(W.Node.data(),  s_pNode,  ulong(m_nNodes)*sizeof(Vector3d));
+                W.WindDirection = m_WindDirection;
+                CreateRHS(W.RHS.data());
+                if (m_bCancel) return;
+            }
+
+            bool bSolved = SolveSweepPoint(W);
+
+            std::lock_guard<std::mutex> lock(SetupMutex);
+            if(!bSolved)
+            {
+                if(!m_bCancel) iFailed = std::min(iFailed, iPoint);
+                return;
+            }
+            memcpy(PointRHS.data() + ulong(iPoint)*ulong(m_MatSize), W.RHS.data(), ulong(m_MatSize)*sizeof(double));
+            memcpy(PointMu.data()  + ulong(iPoint)*ulong(m_MatSize), W.Mu.data(),  ulong(m_MatSize)*sizeof(double));
+            SetProgress(m_Progress + 40.0*double(m_MatSize)/400.0);
+        }
+    });
+    if (m_bCancel) return true;
+
+    for(n=0; n<nrhs; n++)
+    {
+        m_Ctrl = m_ControlMin + double(n) * m_ControlDelta;
+        if(n==iFailed)
+        {
+            str = QString(tr("      Singular Matrix for parameter= %1.... Aborting calculation...")+"\n").arg(m_Ctrl,8,'f',3);
+            AddString(str);
+            m_bWarning = true;
+            return true;
+        }
+
+        str = QString("      \n    "+tr("Computing the results for parameter= %1")+"\n").arg(m_Ctrl,8,'f',3);
+        AddString(str);
+        SetAngles(m_pBoatPolar, m_Ctrl, false);
+        memcpy(m_RHS, PointRHS.data() + ulong(n)*ulong(m_MatSize), ulong(m_MatSize)*sizeof(double));
+        memcpy(m_Mu,  PointMu.data()  + ulong(n)*ulong(m_MatSize), ulong(m_MatSize)*sizeof(double));
+
+        ComputeResults();
         if (m_bCancel) return true;
     }
 
@@ -1282,6 +2922,30 @@ bool BoatAnalysisDlg::UnitLoop()
 }
 
 
+bool BoatAnalysisDlg::SolveSweepPoint(SweepWorker &W)
+{
+    //
+    // Builds, factorizes and solves the system of one point of a parallel sweep, with the worker's geometry.
+    // The rows of the matrix are evaluated by the batch kernels, as in BuildInfluenceMatrix().
+    // Runs in a worker thread, so that the parallel loops of the factorization run serially.
+    //
+    BatchBuffer Buffer;
+    BuildVortexBatch(&W);
+    BuildPanelBatch(&W);
+
+    for(int p=0; p<m_MatSize; p++)
+    {
+        if(m_bCancel) return false;
+        BatchInfluenceRow(p, 0, m_MatSize, W.aij.data() + ulong(p)*ulong(m_MatSize), true, Buffer, &W);
+    }
+
+    if(!Crout_LU_Decomposition_with_Pivoting(W.aij.data(), W.Index.data(), m_MatSize, &m_bCancel))
+        return false;
+
+    return Crout_LU_with_Pivoting_Solve(W.aij.data(), W.RHS.data(), W.Index.data(), W.Mu.data(), m_MatSize, &m_bCancel);
+}
+
+
 void BoatAnalysisDlg::WriteString(QString strong)
 {
     if(!m_pXFile) return;
@@ -1291,7 +2955,7 @@ void BoatAnalysisDlg::WriteString(QString strong)
 }
 
 
-void BoatAnalysisDlg::VLMGetVortexInfluence(CPanel *pPanel, Vector3d const &C, Vector3d &V, bool bAll)
+void BoatAnalysisDlg::VLMGetVortexInfluence(CPanel const *pPanel, Vector3d const &C, Vector3d &V, bool bAll) const
 {
     // calculates the the panel p's vortex influence at point C
     // V is the resulting velocity
@@ -108,6 +108,10 @@ void BoatPolarDlg::Connect()
 {
     connect(m_pctrlUnit1, SIGNAL(toggled(bool)), this, SLOT(OnUnit()));
     connect(m_pctrlUnit2, SIGNAL(toggled(bool)), this, SLOT(OnUnit()));
+    connect(m_pctrlDirectSolver, SIGNAL(toggled(bool)), this, SLOT(OnSolver()));
+    connect(m_pctrlIterativeSolver, SIGNAL(toggled(bool)), this, SLOT(OnSolver()));
+    connect(m_pctrlMatrixFreeSolver, SIGNAL(toggled(bool)), this, SLOT(OnSolver()));
+    connect(m_pctrlHMatrixSolver, SIGNAL(toggled(bool)), this, SLOT(OnSolver()));
 
     connect(pOKButton, SIGNAL(clicked()),this, SLOT(OnOK()));
     connect(pCancelButton, SIGNAL(clicked()), this, SLOT(reject()));
@@ -192,6 +196,14 @@ void BoatPolarDlg::ReadData()
 
     s_BoatPolar.m_bGround = m_pctrlGroundEffect->isChecked();
 
+    s_BoatPolar.m_bIterativeSolver = !m_pctrlDirectSolver->isChecked();
+    s_BoatPolar.m_SolverTolerance  = m_pctrlSolverTolerance->Value();
+    s_BoatPolar.m_bMatrixFree      = m_pctrlMatrixFreeSolver->isChecked();
+    s_BoatPolar.m_TreeAccuracy     = m_pctrlTreeAccuracy->Value();
+    s_BoatPolar.m_bHMatrix         = m_pctrlHMatrixSolver->isChecked();
+    s_BoatPolar.m_HMatrixAccuracy  = m_pctrlHMatrixAccuracy->Value();
+    s_BoatPolar.m_bMixedPrecision  = m_pctrlMixedPrecision->isChecked();
+
 
     SetDensity();
 
@@ -278,6 +290,16 @@ void BoatPolarDlg::InitDialog(Boat *pBoat, BoatPolar *pBoatPolar)
     m_pctrlXCmRef->setValue(s_BoatPolar.m_CoG.x*s_pMainFrame->m_mtoUnit);
     m_pctrlZCmRef->setValue(s_BoatPolar.m_CoG.z*s_pMainFrame->m_mtoUnit);
 
+    m_pctrlDirectSolver->setChecked(!s_BoatPolar.m_bIterativeSolver);
+    m_pctrlIterativeSolver->setChecked(s_BoatPolar.m_bIterativeSolver && !s_BoatPolar.m_bMatrixFree && !s_BoatPolar.m_bHMatrix);
+    m_pctrlMatrixFreeSolver->setChecked(s_BoatPolar.m_bIterativeSolver && s_BoatPolar.m_bMatrixFree);
+    m_pctrlHMatrixSolver->setChecked(s_BoatPolar.m_bIterativeSolver && !s_BoatPolar.m_bMatrixFree && s_BoatPolar.m_bHMatrix);
+    m_pctrlSolverTolerance->setValue(s_BoatPolar.m_SolverTolerance);
+    m_pctrlTreeAccuracy->setValue(s_BoatPolar.m_TreeAccuracy);
+    m_pctrlHMatrixAccuracy->setValue(s_BoatPolar.m_HMatrixAccuracy);
+    m_pctrlMixedPrecision->setChecked(s_BoatPolar.m_bMixedPrecision);
+    OnSolver();
+
     //fill the wind gradient table
     QModelIndex ind;
     QString strong;
@@ -357,6 +379,15 @@ void BoatPolarDlg::OnOK()
 }
 
 
+void BoatPolarDlg::OnSolver()
+{
+    m_pctrlSolverTolerance->setEnabled(!m_pctrlDirectSolver->isChecked());
+    m_pctrlTreeAccuracy->setEnabled(m_pctrlMatrixFreeSolver->isChecked());
+    m_pctrlHMatrixAccuracy->setEnabled(m_pctrlHMatrixSolver->isChecked());
+    m_pctrlMixedPrecision->setEnabled(m_pctrlDirectSolver->isChecked());
+}
+
+
 void BoatPolarDlg::OnUnit()
 {
     if(m_pctrlUnit1->isChecked())
@@ -489,6 +520,53 @@ void BoatPolarDlg::SetupLayout()
         pAeroDataGroupBox->setLayout(pAeroDataLayout);
     }
 
+    QGroupBox *pSolverBox = new QGroupBox(tr("Linear solver"));
+    {
+        QGridLayout *pSolverLayout = new QGridLayout;
+        m_pctrlDirectSolver    = new QRadioButton(tr("Direct (LU)"));
+        m_pctrlIterativeSolver = new QRadioButton(tr("Iterative (GMRES)"));
+        QLabel *pLabTolerance = new QLabel(tr("Tolerance ="));
+        pLabTolerance->setAlignment(Qt::AlignRight | Qt::AlignCenter);
+        m_pctrlSolverTolerance = new FloatEdit(1.e-6, 2);
+        m_pctrlSolverTolerance->SetMin(0.0);
+        m_pctrlMatrixFreeSolver = new QRadioButton(tr("Matrix-free (GMRES)"));
+        m_pctrlMatrixFreeSolver->setToolTip(tr("The panel influences are evaluated with a tree of panel groups\n"
+                                               "instead of building the influence matrix"));
+        QLabel *pLabAccuracy = new QLabel(tr("Tree accuracy ="));
+        pLabAccuracy->setAlignment(Qt::AlignRight | Qt::AlignCenter);
+        m_pctrlTreeAccuracy = new FloatEdit(0.3, 2);
+        m_pctrlTreeAccuracy->SetMin(0.05);
+        m_pctrlTreeAccuracy->SetMax(0.9);
+        m_pctrlTreeAccuracy->setToolTip(tr("Max ratio of the size of a group of panels to its distance\n"
+                                           "for the group to be replaced by its far field.\n"
+                                           "Smaller values are more accurate and slower."));
+        m_pctrlHMatrixSolver = new QRadioButton(tr("Hierarchical matrix (GMRES)"));
+        m_pctrlHMatrixSolver->setToolTip(tr("The blocks of the influence matrix between distant groups of panels\n"
+                                            "are stored in compressed form"));
+        QLabel *pLabHMatrixAccuracy = new QLabel(tr("Matrix accuracy ="));
+        pLabHMatrixAccuracy->setAlignment(Qt::AlignRight | Qt::AlignCenter);
+        m_pctrlHMatrixAccuracy = new FloatEdit(1.e-4, 2);
+        m_pctrlHMatrixAccuracy->SetMin(1.e-10);
+        m_pctrlHMatrixAccuracy->SetMax(0.1);
+        m_pctrlHMatrixAccuracy->setToolTip(tr("Relative accuracy of the compressed blocks.\n"
+                                              "Smaller values are more accurate and use more memory."));
+        m_pctrlMixedPrecision = new QCheckBox(tr("Single precision LU"));
+        m_pctrlMixedPrecision->setToolTip(tr("The matrix is factorized in single precision, which halves the memory\n"
+                                             "and the factorization time, and the solution is refined to double precision"));
+        pSolverLayout->addWidget(m_pctrlDirectSolver,1,1);
+        pSolverLayout->addWidget(m_pctrlIterativeSolver,1,2);
+        pSolverLayout->addWidget(m_pctrlMatrixFreeSolver,1,3);
+        pSolverLayout->addWidget(m_pctrlHMatrixSolver,1,4);
+        pSolverLayout->addWidget(pLabTolerance,2,1);
+        pSolverLayout->addWidget(m_pctrlSolverTolerance,2,2);
+        pSolverLayout->addWidget(pLabAccuracy,3,1);
+        pSolverLayout->addWidget(m_pctrlTreeAccuracy,3,2);
+        pSolverLayout->addWidget(pLabHMatrixAccuracy,3,3);
+        pSolverLayout->addWidget(m_pctrlHMatrixAccuracy,3,4);
+        pSolverLayout->addWidget(m_pctrlMixedPrecision,2,3,1,2);
+        pSolverBox->setLayout(pSolverLayout);
+    }
+
     QGroupBox *pWindGradientBox = new QGroupBox("Wind gradient parabola");
     {
         QVBoxLayout *pWindGradientLayout = new QVBoxLayout;
@@ -515,6 +593,7 @@ void BoatPolarDlg::SetupLayout()
             pLeftSideLayout->addWidget(pNameGroup);
             pLeftSideLayout->addWidget(pInertiaBox);
             pLeftSideLayout->addWidget(pAeroDataGroupBox);
+            pLeftSideLayout->addWidget(pSolverBox);
             pLeftSideLayout->addStretch(1);
             pLeftSideLayout->addWidget(pWindGradientBox);
             pLeftSideLayout->addWidget(m_pctrlGroundEffect);
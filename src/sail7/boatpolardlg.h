@@ -50,6 +50,7 @@ private:
 
 private slots:
     void OnOK();
+    void OnSolver();
     void OnUnit();
 
 private:
@@ -87,6 +88,9 @@ private:
 
     QRadioButton *m_pctrlPanelMethod;
     QRadioButton *m_pctrlUnit1, *m_pctrlUnit2;
+    QRadioButton *m_pctrlDirectSolver, *m_pctrlIterativeSolver, *m_pctrlMatrixFreeSolver, *m_pctrlHMatrixSolver;
+    FloatEdit *m_pctrlSolverTolerance, *m_pctrlTreeAccuracy, *m_pctrlHMatrixAccuracy;
+    QCheckBox *m_pctrlMixedPrecision;
 
     QLabel *m_pctrlQInfCl;
     QLabel *m_pctrlBoatName;
@@ -22,6 +22,7 @@
 #include <QVBoxLayout>
 #include <QFileDialog>
 #include <QDir>
+#include <QVector>
 #include <QDomDocument>
 #include <math.h>
 
@@ -2960,8 +2961,39 @@ void Sail7::SetBoat(QString BoatName)
     m_bResetglStream = true;
     m_bResetglSpeeds = true;
 
-    memset(s_pPanel, 0, sizeof(s_pMainFrame->m_Panel));
-    memset(s_pNode,  0, sizeof(s_pMainFrame->m_Node));
+    // size the solver arrays to the boat before meshing it
+    int nPanels = 0;
+    for(int is=0; is<m_pCurBoat->m_poaSail.size(); is++)
+    {
+        Sail *pSail = m_pCurBoat->m_poaSail.at(is);
+        if(pSail) nPanels += pSail->m_NXPanels * pSail->m_NZPanels;
+    }
+    for(int ib=0; ib<m_pCurBoat->m_poaHull.size(); ib++)
+    {
+        Body *pHull = m_pCurBoat->m_poaHull.at(ib);
+        if(!pHull) continue;
+        if(pHull->m_LineType==BODYPANELTYPE)
+        {
+            int nx = 0, nh = 0;
+            for(int i=0; i<pHull->FrameSize()-1; i++)       nx+=pHull->m_xPanels[i];
+            for(int i=0; i<pHull->FramePointCount()-1; i++) nh+=pHull->m_hPanels[i];
+            nPanels += 2*nx*nh;
+        }
+        else nPanels += 2*pHull->m_nxPanels*pHull->m_nhPanels;
+    }
+
+    //each panel brings at most four new nodes
+    if(!s_pMainFrame->AllocateSolverArrays(nPanels, 4*nPanels))
+    {
+        QApplication::restoreOverrideCursor();
+        QMessageBox::warning(s_pMainFrame, tr("Warning"), tr("Not enough memory to mesh the boat"));
+        m_pCurBoat = nullptr;
+        m_MatSize = m_nNodes = 0;
+        return;
+    }
+
+    memset(s_pPanel, 0, ulong(nPanels)   * sizeof(CPanel));
+    memset(s_pNode,  0, ulong(4*nPanels) * sizeof(Vector3d));
 
     m_NSurfaces = 0;
     m_MatSize = 0;
@@ -4663,21 +4695,18 @@ void Sail7::SetBoatPolarGraphTitles(Graph* pGraph)
 
 
 
-void Sail7::AddBoatOpp(double *Cp, double *Gamma, double *Sigma, Vector3d const &F, Vector3d const &M, Vector3d const& ForceTrefftz)
+void Sail7::AddBoatOpp(BoatOpp *pNewPoint)
 {
     //
-    // Creates the wing's operating point
-    // Fills it with the input resulting from the LLT, VLM or 3D-panel analysis,
-    // and inserts it in the array of wing operating points
-    //
-    // In input, takes
+    // Stores the boat's operating point built by the analysis
+    // The BoatOpp is filled by the analysis with the results of the 3D-panel analysis:
     //   - the array of Cp distribution
     //   - the array of circulation or doublet strengths Gamma
     //   - the array of source strengths Sigma
-    //   - the data stored in the LLTAnalysisDlg or PanelAnalysisDlg current instances
-    //   - the data stored in the current wing object
+    //   - the angles, forces and moments
     //
-    // In output, fills the pBoatOpp object and returns the pointer
+    // Completes it with the data stored in the current boat and polar objects,
+    // and inserts it in the array of boat operating points, which takes ownership of it
     //
 
     int i,j;
@@ -4685,74 +4714,28 @@ void Sail7::AddBoatOpp(double *Cp, double *Gamma, double *Sigma, Vector3d const
     s_pMainFrame->SetSaveState(false);
 
     BoatOpp *pBoatOpp;
-    BoatOpp * pNewPoint;
-    pNewPoint = new BoatOpp();
-    if(pNewPoint == nullptr)
-    {
-        QMessageBox::warning(s_pMainFrame,tr("Warning"),tr("Not enough memory to store the OpPoint\n"));
-        return;
-    }
-    else
+
+    //load BoatOpp with data
+    pNewPoint->m_Color = s_pMainFrame->GetColor(5);
+    bool bFound;
+    for(i=0; i<30;i++)
     {
-        //load BoatOpp with data
-        pNewPoint->m_Color = s_pMainFrame->GetColor(5);
-        bool bFound;
-        for(i=0; i<30;i++)
+        bFound = false;
+        for (j=0; j<m_poaBoatOpp->size();j++)
         {
-            bFound = false;
-            for (j=0; j<m_poaBoatOpp->size();j++)
-            {
-                pBoatOpp = m_poaBoatOpp->at(j);
-                if(pBoatOpp->m_Color == s_pMainFrame->m_crColors[i]) bFound = true;
-            }
-            if(!bFound)
-            {
-                pNewPoint->m_Color = s_pMainFrame->m_crColors[i];
-                break;
-            }
+            pBoatOpp = m_poaBoatOpp->at(j);
+            if(pBoatOpp->m_Color == s_pMainFrame->m_crColors[i]) bFound = true;
         }
-
-        pNewPoint->m_BoatName =  m_pCurBoat->m_BoatName;
-
-        pNewPoint->m_BoatPolarName       = m_pCurBoatPolar->m_BoatPolarName;
-        pNewPoint->m_bVLM1               = m_pCurBoatPolar->m_bVLM1;
-
-        pNewPoint->m_NVLMPanels          = m_PanelDlg.m_MatSize;
-
-
-        //get the data from the PanelAnalysis dialog, and from the wing object
-        double Ctrl = m_PanelDlg.m_Ctrl;
-        pNewPoint->m_Beta                = m_pCurBoatPolar->m_BetaMin * (1.0-Ctrl) + m_pCurBoatPolar->m_BetaMax * Ctrl;
-        pNewPoint->m_Phi                 = m_pCurBoatPolar->m_PhiMin  * (1.0-Ctrl) + m_pCurBoatPolar->m_PhiMax  * Ctrl;
-        pNewPoint->m_QInf                = m_PanelDlg.m_QInf;
-        pNewPoint->m_Ctrl                = m_PanelDlg.m_Ctrl;
-        for(int is=0; is<m_pCurBoat->m_poaSail.size(); is++)
+        if(!bFound)
         {
-            pNewPoint->m_SailAngle[is] = m_pCurBoatPolar->m_SailAngleMin[is] * (1.0-Ctrl) + m_pCurBoatPolar->m_SailAngleMax[is] * Ctrl;
+            pNewPoint->m_Color = s_pMainFrame->m_crColors[i];
+            break;
         }
-
-
-        pNewPoint->F  = F;
-        pNewPoint->M  = M;
-        pNewPoint->ForceTrefftz = ForceTrefftz;
-
-        /*        CVector WindDirection, WindNormal, WindSide;
-        SetWindAxis(pNewPoint->m_Beta, WindDirection, WindNormal, WindSide);
-        pNewPoint->m_Lift = pNewPoint->ForceTrefftz.dot(WindNormal);
-        pNewPoint->m_Drag = pNewPoint->ForceTrefftz.dot(WindDirection);*/
-
-
-        memcpy(pNewPoint->m_Cp,    Cp,    ulong(m_MatSize)*sizeof(double));
-        memcpy(pNewPoint->m_G,     Gamma, ulong(m_MatSize)*sizeof(double));
-        memcpy(pNewPoint->m_Sigma, Sigma, ulong(m_MatSize)*sizeof(double));
-
-        pNewPoint->m_nWakeNodes     = 0;
-        pNewPoint->m_NXWakePanels   = 1;
-        //        pNewPoint->m_FirstWakePanel = m_pCurBoatPolar->m_WSpan;
-        pNewPoint->m_WakeFactor     = 1.0;
-
     }
 
+    pNewPoint->m_BoatName =  m_pCurBoat->m_BoatName;
+    pNewPoint->m_BoatPolarName       = m_pCurBoatPolar->m_BoatPolarName;
+
     //add the data to the polar object
     m_pCurBoatPolar->AddPoint(pNewPoint);
 
@@ -4836,7 +4819,7 @@ void Sail7::RotatePanelsX(double const &Angle, Vector3d const &P)
     // the wake array is not rotated but translated to remain at the wing's trailing edge
     pw=0;
 
-    if(!m_pCurBoatPolar) return;
+    if(!m_pCurBoatPolar || m_WakeSize<=0) return;
     /*    for (kw=0; kw<m_NWakeColumn; kw++)
     {
         //consider the first panel of the column;
@@ -4910,7 +4893,7 @@ void Sail7::RotatePanelsZ(double const &Angle, Vector3d const &P)
     // the wake array is not rotated but translated to remain at the wing's trailing edge
     pw=0;
 
-    if(!m_pCurBoatPolar) return;
+    if(!m_pCurBoatPolar || m_WakeSize<=0) return;
     /*    for (kw=0; kw<m_NWakeColumn; kw++)
     {
         //consider the first panel of the column;
@@ -5472,6 +5455,9 @@ void Sail7::GLCreatePanelForces(BoatOpp *pBoatOpp)
     //
 
     if(!m_pCurBoat || !pBoatOpp || !m_pCurBoatPolar) return;
+    // the results must belong to the panels of the current mesh
+    if(pBoatOpp->m_NVLMPanels!=m_MatSize) return;
+    if(!pBoatOpp->LoadResults()) return;
 
     int p;
     double force, cosa, sina2, cosa2, color;
@@ -5879,7 +5865,7 @@ void Sail7::GLCreateSailGeom(GLuint GLList, Sail *pSail, Vector3d Position)
 
 void Sail7::GLCreateCp(BoatOpp *pBoatOpp)
 {
-    if(!m_pCurBoat || !pBoatOpp)
+    if(!m_pCurBoat || !pBoatOpp || pBoatOpp->m_NVLMPanels!=m_MatSize || !pBoatOpp->LoadResults())
     {
         glNewList(PANELCP,GL_COMPILE);
         glEndList();
@@ -5889,7 +5875,7 @@ void Sail7::GLCreateCp(BoatOpp *pBoatOpp)
     int nPanels;
     double color;
     double lmin, lmax, range;
-    double CpInf[2*VLMMAXMATSIZE], CpSup[2*VLMMAXMATSIZE], Cp100[2*VLMMAXMATSIZE];
+    QVector<double> CpInf(m_nNodes), CpSup(m_nNodes), Cp100(m_nNodes);
     Vector3d LA,LB,TA,TB;
     nPanels = pBoatOpp->m_NVLMPanels;
 
@@ -6383,6 +6369,8 @@ void Sail7::OnResetBoatPlrLegend()
 void Sail7::GLCreateStreamLines()
 {
     if(!m_pCurBoatOpp || !m_pCurBoatPolar || !m_pCurBoat) return;
+    if(m_pCurBoatOpp->m_NVLMPanels!=m_MatSize) return;
+    if(!m_pCurBoatOpp->LoadResults()) return;
 
     //    GL3DScales *p3DScales = (GL3DScales *)m_pGL3DScales;
     bool bFound;
@@ -6479,7 +6467,7 @@ void Sail7::GLCreateStreamLines()
 
     ProgressDlg dlg;
     dlg.setWindowTitle("Streamines calculation");
-    dlg.InitDialog(0, iStream.size());
+    dlg.InitDialog(0, GL3DScales::s_NX);
     dlg.setWindowModality(Qt::WindowModal);
     dlg.SetValue(0);
     dlg.move(s_pMainFrame->m_DlgPos);
@@ -6490,6 +6478,7 @@ void Sail7::GLCreateStreamLines()
 
     m_PanelDlg.m_MatSize = m_pCurBoatOpp->m_NVLMPanels;
     m_PanelDlg.m_pBoat = m_pCurBoat;
+    m_PanelDlg.m_pBoatPolar = m_pCurBoatPolar;
 
     //Define the freestream wind vector
     double beta = m_pCurBoatPolar->m_BetaMin * (1-m_pCurBoatOpp->m_Ctrl) +m_pCurBoatPolar->m_BetaMax * m_pCurBoatOpp->m_Ctrl ;
@@ -6500,6 +6489,79 @@ void Sail7::GLCreateStreamLines()
     m_PanelDlg.SetAngles(m_pCurBoatPolar, m_pCurBoatOpp->m_Ctrl, false);
 
     //________________________________
+    // The streamlines are advanced together, so that the velocities
+    // at the heads of all the lines are evaluated in one pass at each step
+
+    int nStreams = iStream.size();
+    int nLinePts = GL3DScales::s_NX+1;
+    std::vector<Vector3d> Line(ulong(nStreams*nLinePts));
+    std::vector<Vector3d> Head(nStreams), VHead(nStreams);
+
+    for (int is=0; is<nStreams; is++)
+    {
+        if(GL3DScales::s_pos==YLINE)      C = VStream.at(is);
+        else if(GL3DScales::s_pos==ZLINE) C = VStream.at(is);
+        else                              C = s_pNode[iStream.at(is)];
+
+        if(GL3DScales::s_pos==TRAILINGEDGE && fabs(GL3DScales::s_XOffset)<0.001 && fabs(GL3DScales::s_ZOffset)<0.001)
+        {
+            //                VA = m_pCurBoatOpp->GetWindDirection();
+            //                VA.Normalize();
+            //The initial velocity vector is the direction at the T.E., i.e. the bisector angle of the two panels
+            bFound =false;
+            for(int iSail=0; iSail<m_pCurBoat->m_poaSail.size(); iSail++)
+            {
+                Sail *pSail = m_pCurBoat->m_poaSail.at(iSail);
+                for(int pp=0; pp<pSail->m_NElements; pp++)
+                {
+                    if(pSail->m_pPanel[pp].m_iTA == iStream.at(is))
+                    {
+                        VA = s_pNode[pSail->m_pPanel[pp].m_iTA] - s_pNode[pSail->m_pPanel[pp].m_iLA];
+                        VA.Normalize();
+                        bFound=true;
+                        break;
+                    }
+                    if(pSail->m_pPanel[pp].m_iTB == iStream.at(is))
+                    {
+                        VA = s_pNode[pSail->m_pPanel[pp].m_iTB] - s_pNode[pSail->m_pPanel[pp].m_iLB];
+                        VA.Normalize();
+                        bFound=true;
+                        break;
+                    }
+                }
+                if(bFound) break;
+            }
+        }
+
+        C.x += GL3DScales::s_XOffset;
+        C.z += GL3DScales::s_ZOffset;
+
+        Line[ulong(is*nLinePts)] = C;
+        C   += VA * GL3DScales::s_DeltaL;
+        Line[ulong(is*nLinePts+1)] = C;
+        Head[ulong(is)] = C;
+    }
+
+    m = 2;
+    ds = GL3DScales::s_DeltaL * GL3DScales::s_XFactor;
+    for (i=1; i<GL3DScales::s_NX && nStreams>0; i++)
+    {
+        m_PanelDlg.GetSpeedVectors(Head.data(), nStreams, Mu, Sigma, VHead.data(), true, i==1);
+
+        for (int is=0; is<nStreams; is++)
+        {
+            VT = VHead[ulong(is)];
+            VT += VInf;
+            VT.Normalize();
+            Head[ulong(is)] += VT* ds;
+            Line[ulong(is*nLinePts+i+1)] = Head[ulong(is)];
+        }
+        ds *= GL3DScales::s_XFactor;
+        m++;
+
+        dlg.SetValue(i);
+        if(dlg.IsCanceled()) break;
+    }
 
     glNewList(STREAMLINES,GL_COMPILE);
     {
@@ -6521,74 +6583,17 @@ void Sail7::GLCreateStreamLines()
 
         glColor3d(color.redF(), color.greenF(), color.blueF());
 
-        m = 0;
-
-        for (int is=0; is<iStream.size(); is++)
+        for (int is=0; is<nStreams; is++)
         {
-            if(GL3DScales::s_pos==YLINE)      C = VStream.at(is);
-            else if(GL3DScales::s_pos==ZLINE) C = VStream.at(is);
-            else                              C = s_pNode[iStream.at(is)];
-
-            if(GL3DScales::s_pos==TRAILINGEDGE && fabs(GL3DScales::s_XOffset)<0.001 && fabs(GL3DScales::s_ZOffset)<0.001)
-            {
-                //                VA = m_pCurBoatOpp->GetWindDirection();
-                //                VA.Normalize();
-                //The initial velocity vector is the direction at the T.E., i.e. the bisector angle of the two panels
-                bFound =false;
-                for(int iSail=0; iSail<m_pCurBoat->m_poaSail.size(); iSail++)
-                {
-                    Sail *pSail = m_pCurBoat->m_poaSail.at(iSail);
-                    for(int pp=0; pp<pSail->m_NElements; pp++)
-                    {
-                        if(pSail->m_pPanel[pp].m_iTA == iStream.at(is))
-                        {
-                            VA = s_pNode[pSail->m_pPanel[pp].m_iTA] - s_pNode[pSail->m_pPanel[pp].m_iLA];
-                            VA.Normalize();
-                            bFound=true;
-                            break;
-                        }
-                        if(pSail->m_pPanel[pp].m_iTB == iStream.at(is))
-                        {
-                            VA = s_pNode[pSail->m_pPanel[pp].m_iTB] - s_pNode[pSail->m_pPanel[pp].m_iLB];
-                            VA.Normalize();
-                            bFound=true;
-                            break;
-                        }
-                    }
-                    if(bFound) break;
-                }
-            }
-
-            C.x += GL3DScales::s_XOffset;
-            C.z += GL3DScales::s_ZOffset;
-
-            ds = GL3DScales::s_DeltaL;
-
             glBegin(GL_LINE_STRIP);
             {
-                glVertex3d(C.x+TC.x, C.y+TC.y, C.z+TC.z);
-                C   += VA *ds;
-                glVertex3d(C.x+TC.x, C.y+TC.y, C.z+TC.z);
-                ds *= GL3DScales::s_XFactor;
-
-                for (i=1; i<GL3DScales::s_NX; i++)
+                for(int ip=0; ip<m; ip++)
                 {
-                    m_PanelDlg.GetSpeedVector(C, Mu, Sigma, VT);
-
-                    VT += VInf;
-                    VT.Normalize();
-                    C   += VT* ds;
-                    glVertex3d(C.x+TC.x, C.y+TC.y, C.z+TC.z);
-                    ds *= GL3DScales::s_XFactor;
+                    Vector3d const &P = Line[ulong(is*nLinePts+ip)];
+                    glVertex3d(P.x+TC.x, P.y+TC.y, P.z+TC.z);
                 }
             }
             glEnd();
-
-            dlg.SetValue(m);
-            m++;
-
-            if(dlg.IsCanceled()) break;
-
         }
         glDisable (GL_LINE_STIPPLE);
     }
@@ -6606,6 +6611,8 @@ void Sail7::GLCreateSurfSpeeds()
 {
 
     if(!m_pCurBoatOpp || !m_pCurBoatPolar || !m_pCurBoat) return;
+    if(m_pCurBoatOpp->m_NVLMPanels!=m_MatSize) return;
+    if(!m_pCurBoatOpp->LoadResults()) return;
 
     ProgressDlg dlg;
     dlg.move(s_pMainFrame->m_DlgPos);
@@ -6619,7 +6626,7 @@ void Sail7::GLCreateSurfSpeeds()
     double length, sinT, cosT, beta;
     double *Mu, *Sigma;
     double x1, x2, y1, y2, z1, z2, xe, ye, ze, dlx, dlz;
-    Vector3d C, V, VT, VInf;
+    Vector3d C, VT, VInf;
 
     factor = GL3DScales::s_VelocityScale/100.0;
 
@@ -6642,6 +6649,15 @@ void Sail7::GLCreateSurfSpeeds()
     //Apply the currently selected Boat's Opp angles
     m_PanelDlg.SetAngles(m_pCurBoatPolar, m_pCurBoatOpp->m_Ctrl, false);
 
+    //evaluate the velocities at all the panels' control points in one pass
+    std::vector<Vector3d> CPts(m_MatSize), VPts(m_MatSize);
+    for (p=0; p<m_MatSize; p++)
+    {
+        if(s_pPanel[p].m_Pos==MIDSURFACE) CPts[ulong(p)] = s_pPanel[p].CtrlPt;
+        else                              CPts[ulong(p)] = s_pPanel[p].CollPt;
+    }
+    m_PanelDlg.GetSpeedVectors(CPts.data(), m_MatSize, Mu, Sigma, VPts.data(), true);
+
 
     glNewList(SURFACESPEEDS, GL_COMPILE);
     {
@@ -6665,11 +6681,8 @@ void Sail7::GLCreateSurfSpeeds()
         {
             VT = m_PanelDlg.m_VInf;
 
-            if(s_pPanel[p].m_Pos==MIDSURFACE) C.Copy(s_pPanel[p].CtrlPt);
-            else                              C.Copy(s_pPanel[p].CollPt);
-
-            m_PanelDlg.GetSpeedVector(C, Mu, Sigma, V, true, false);
-            VT += V;
+            C = CPts[ulong(p)];
+            VT += VPts[ulong(p)];
 
             length = VT.VAbs()*factor;
             xe     = C.x+factor*VT.x;
@@ -6947,6 +6960,16 @@ void Sail7::UpdateUnits()
 void Sail7::OnExportCurBoatOpp()
 {
     if(!m_pCurBoatOpp) return;
+    if(m_pCurBoatOpp->m_NVLMPanels!=m_MatSize)
+    {
+        QMessageBox::warning(s_pMainFrame, tr("Warning"), tr("The operating point does not match the panels of the current boat"));
+        return;
+    }
+    if(!m_pCurBoatOpp->LoadResults())
+    {
+        QMessageBox::warning(s_pMainFrame, tr("Warning"), tr("Could not read the panel results of the operating point"));
+        return;
+    }
 
     QString Header, strong, Format;
     int k;
@@ -254,7 +254,7 @@ class Sail7 : public QWidget
         BoatPolar* AddBoatPolar(BoatPolar *pBoatPolar);
         BoatPolar* GetBoatPolar(QString BoatPolarName);
 
-        void AddBoatOpp(double *Cp, double *Gamma, double *Sigma, Vector3d const &F, Vector3d const &M, Vector3d const& ForceTrefftz);
+        void AddBoatOpp(BoatOpp *pNewPoint);
 
 
         //____________________Variables______________________________________